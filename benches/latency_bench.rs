@@ -0,0 +1,396 @@
+//! 延迟分布测试：记录每一次操作的耗时，输出 p50/p99/p999。
+//!
+//! 与 `performance_bench` 只统计平均值不同，这里关注会造成长尾延迟的路径：GC 稳定期的覆盖写入、
+//! 5 万个键的冷启动加载、KV 缓存未命中的查找、滚动覆盖后的 TSDB 时间范围查询以及 64KB 以上的大值。
+//! 每个场景分别运行在理想时序的 `SimFlash` 和文件存储上，以区分引擎本身的开销和 I/O 开销。
+//!
+//! 运行：`cargo bench --bench latency_bench [场景名过滤]`
+
+use embedded_storage::nor_flash::{ErrorType, NorFlash, ReadNorFlash};
+use flashdb_rs::storage::{FileStrategy, StdStorage};
+use flashdb_rs::{Error, SimFlash, SimTiming, KVDB, TSDB};
+use std::cell::RefCell;
+use std::rc::Rc;
+use std::sync::OnceLock;
+use std::time::{Duration, Instant};
+use tempfile::tempdir;
+
+// --- 存储后端 ---
+
+/// 理想时序（不耗时）的 [`SimFlash`]，克隆后共享同一块 Flash，用于模拟断电后重新加载。
+///
+/// 数据库的扇区大小取自 `NorFlash::ERASE_SIZE`，因此由 `SEC` 参数指定。
+#[derive(Clone)]
+struct SharedSim<const SEC: usize>(Rc<RefCell<SimFlash<SEC>>>);
+
+impl<const SEC: usize> SharedSim<SEC> {
+    fn new(size: u32) -> Self {
+        Self(Rc::new(RefCell::new(SimFlash::with_timing(size as usize, SimTiming::IDEAL))))
+    }
+}
+
+impl<const SEC: usize> ErrorType for SharedSim<SEC> {
+    type Error = Error;
+}
+
+impl<const SEC: usize> ReadNorFlash for SharedSim<SEC> {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        self.0.borrow_mut().read(offset, bytes)
+    }
+
+    fn capacity(&self) -> usize {
+        self.0.borrow().capacity()
+    }
+}
+
+impl<const SEC: usize> NorFlash for SharedSim<SEC> {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = SEC;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        self.0.borrow_mut().erase(from, to)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.0.borrow_mut().write(offset, bytes)
+    }
+}
+
+/// 文件存储，`StdStorage` 的擦除大小固定为 4096，这里按 `SEC` 重新声明以支持大扇区。
+struct FileFlash<const SEC: usize>(StdStorage);
+
+impl<const SEC: usize> ErrorType for FileFlash<SEC> {
+    type Error = Error;
+}
+
+impl<const SEC: usize> ReadNorFlash for FileFlash<SEC> {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        self.0.read(offset, bytes)
+    }
+
+    fn capacity(&self) -> usize {
+        self.0.capacity()
+    }
+}
+
+impl<const SEC: usize> NorFlash for FileFlash<SEC> {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = SEC;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        self.0.erase(from, to)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.0.write(offset, bytes)
+    }
+}
+
+/// 测试使用的后端，每个场景都会在两种后端上各运行一次
+#[derive(Clone, Copy)]
+enum Backend {
+    Sim,
+    File,
+}
+
+impl Backend {
+    const ALL: [Backend; 2] = [Backend::Sim, Backend::File];
+
+    fn name(self) -> &'static str {
+        match self {
+            Backend::Sim => "sim",
+            Backend::File => "file",
+        }
+    }
+}
+
+/// 打开同一块存储，可以多次调用以模拟重新上电
+trait Open {
+    type Storage: NorFlash;
+    fn open(&self) -> Self::Storage;
+
+    /// 用 Flash 镜像覆盖整个存储
+    fn restore(&self, image: &[u8]) {
+        let mut storage = self.open();
+        let sec_size = <Self::Storage as NorFlash>::ERASE_SIZE;
+        for (i, sector) in image.chunks(sec_size).enumerate() {
+            let addr = (i * sec_size) as u32;
+            storage.erase(addr, addr + sector.len() as u32).unwrap();
+            storage.write(addr, sector).unwrap();
+        }
+    }
+}
+
+impl<const SEC: usize> Open for SharedSim<SEC> {
+    type Storage = SharedSim<SEC>;
+    fn open(&self) -> SharedSim<SEC> {
+        self.clone()
+    }
+}
+
+struct FileOpen<const SEC: usize> {
+    dir: tempfile::TempDir,
+    name: &'static str,
+    max_size: u32,
+}
+
+impl<const SEC: usize> Open for FileOpen<SEC> {
+    type Storage = FileFlash<SEC>;
+    fn open(&self) -> FileFlash<SEC> {
+        let storage = StdStorage::new(
+            self.dir.path(),
+            self.name,
+            SEC as u32,
+            self.max_size,
+            FileStrategy::Multi,
+        );
+        FileFlash(storage.unwrap())
+    }
+}
+
+/// 在指定后端上运行一个场景，场景函数对两种后端共用
+macro_rules! with_backend {
+    ($backend:expr, $name:expr, $sec_size:expr, $max_size:expr, $f:expr) => {
+        match $backend {
+            Backend::Sim => $f(&SharedSim::<{ $sec_size as usize }>::new($max_size)),
+            Backend::File => $f(&FileOpen::<{ $sec_size as usize }> {
+                dir: tempdir().unwrap(),
+                name: $name,
+                max_size: $max_size,
+            }),
+        }
+    };
+}
+
+fn open_kvdb<O: Open>(storage: &O) -> Box<KVDB<O::Storage>> {
+    let mut db = Box::new(KVDB::new(storage.open()));
+    db.init(None).unwrap();
+    db
+}
+
+fn open_tsdb<O: Open>(storage: &O, entry_max: usize) -> Box<TSDB<O::Storage>> {
+    let mut db = Box::new(TSDB::new(storage.open()));
+    db.init(entry_max).unwrap();
+    db
+}
+
+// --- 统计 ---
+
+/// 延迟直方图：保存每次采样，报告时排序后取分位数
+struct Histogram {
+    samples: Vec<Duration>,
+}
+
+impl Histogram {
+    fn new() -> Self {
+        Self { samples: Vec::new() }
+    }
+
+    fn time<R>(&mut self, f: impl FnOnce() -> R) -> R {
+        let start = Instant::now();
+        let result = f();
+        self.samples.push(start.elapsed());
+        result
+    }
+
+    fn report(mut self, name: &str, backend: Backend) {
+        self.samples.sort_unstable();
+        let n = self.samples.len();
+        let pct = |p: f64| self.samples[((n as f64 * p).ceil() as usize).clamp(1, n) - 1];
+        let mean = self.samples.iter().sum::<Duration>() / n as u32;
+        println!(
+            "{:<30} {:<5} n={:<6} mean {:>10.1?} p50 {:>10.1?} p99 {:>10.1?} p999 {:>10.1?} max {:>10.1?}",
+            name,
+            backend.name(),
+            n,
+            mean,
+            pct(0.50),
+            pct(0.99),
+            pct(0.999),
+            self.samples[n - 1]
+        );
+    }
+}
+
+/// 确定性的伪随机数（xorshift），保证两种后端上的访问序列相同
+struct XorShift(u64);
+
+impl XorShift {
+    fn next(&mut self, bound: u32) -> u32 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 7;
+        self.0 ^= self.0 << 17;
+        (self.0 % bound as u64) as u32
+    }
+}
+
+// --- KVDB 场景 ---
+
+/// GC 稳定期的覆盖写入：数据库写满后，每次写入都可能触发 GC，p999 反映 GC 造成的停顿。
+fn kvdb_gc_steady(backend: Backend) {
+    const SEC: u32 = 4096;
+    const MAX: u32 = 64 * SEC;
+    const KEYS: u32 = 256;
+    with_backend!(backend, "gc_steady", SEC, MAX, |storage| {
+        let mut db = open_kvdb(storage);
+        let value = [0x5Au8; 200];
+        for i in 0..KEYS {
+            db.set(&format!("key{}", i), &value).unwrap();
+        }
+        let mut rng = XorShift(0x9E37_79B9_7F4A_7C15);
+        // 预热到 GC 开始工作
+        for _ in 0..2_000 {
+            db.set(&format!("key{}", rng.next(KEYS)), &value).unwrap();
+        }
+        #[cfg(feature = "stats")]
+        db.reset_stats();
+        let mut hist = Histogram::new();
+        for _ in 0..5_000 {
+            let key = format!("key{}", rng.next(KEYS));
+            hist.time(|| db.set(&key, &value).unwrap());
+        }
+        hist.report("kvdb_gc_steady_set_200B", backend);
+        #[cfg(feature = "stats")]
+        println!("    {}", db.stats());
+    });
+}
+
+/// 冷启动：5 万个键的数据库重新加载（`_fdb_kv_load`）的耗时。
+///
+/// 预填充只在 `SimFlash` 上进行一次，再把镜像写入各个后端，以免填充时间淹没测试本身；
+/// 使用 64KB 扇区，减少填充时为新 KV 分配空间所需遍历的扇区数。
+fn kvdb_cold_load(backend: Backend) {
+    const SEC: u32 = 64 * 1024;
+    const MAX: u32 = 64 * SEC;
+    const KEYS: u32 = 50_000;
+    static IMAGE: OnceLock<Vec<u8>> = OnceLock::new();
+    let image = IMAGE.get_or_init(|| {
+        let sim = SharedSim::<{ SEC as usize }>::new(MAX);
+        let mut db = open_kvdb(&sim);
+        for i in 0..KEYS {
+            db.set(&format!("key{}", i), &i.to_le_bytes()).unwrap();
+        }
+        drop(db);
+        let image = sim.0.borrow().data().to_vec();
+        image
+    });
+    with_backend!(backend, "cold_load", SEC, MAX, |storage| {
+        Open::restore(storage, image);
+        let mut hist = Histogram::new();
+        for _ in 0..10 {
+            let db = hist.time(|| open_kvdb(storage));
+            drop(db);
+        }
+        hist.report("kvdb_cold_load_50k", backend);
+    });
+}
+
+/// KV 缓存未命中的查找：键的数量远超缓存表（64 项），随机读取时大多需要遍历扇区。
+fn kvdb_get_cache_miss(backend: Backend) {
+    const SEC: u32 = 4096;
+    const MAX: u32 = 128 * SEC;
+    const KEYS: u32 = 2_000;
+    with_backend!(backend, "get_miss", SEC, MAX, |storage| {
+        let mut db = open_kvdb(storage);
+        for i in 0..KEYS {
+            db.set(&format!("key{}", i), &[i as u8; 64]).unwrap();
+        }
+        let mut rng = XorShift(0x2545_F491_4F6C_DD1D);
+        let mut buf = [0u8; 64];
+        let mut hist = Histogram::new();
+        for _ in 0..5_000 {
+            let i = rng.next(KEYS);
+            let key = format!("key{}", i);
+            let len = hist.time(|| db.get_into(&key, &mut buf).unwrap());
+            assert_eq!(len, 64);
+        }
+        hist.report("kvdb_get_cache_miss_2k", backend);
+    });
+}
+
+/// 大值的写入与读取，扇区设置为 256KB 以容纳单个大 KV。
+fn kvdb_large_value(backend: Backend) {
+    const SEC: u32 = 256 * 1024;
+    const MAX: u32 = 16 * SEC;
+    with_backend!(backend, "large_value", SEC, MAX, |storage| {
+        let mut db = open_kvdb(storage);
+        for &size in &[64 * 1024usize, 192 * 1024] {
+            let value = vec![0xA5u8; size];
+            let mut set = Histogram::new();
+            let mut get = Histogram::new();
+            for _ in 0..100 {
+                set.time(|| db.set("blob", &value).unwrap());
+                let read = get.time(|| db.get("blob").unwrap().unwrap());
+                assert_eq!(read.len(), size);
+            }
+            set.report(&format!("kvdb_set_{}KB", size / 1024), backend);
+            get.report(&format!("kvdb_get_{}KB", size / 1024), backend);
+        }
+    });
+}
+
+// --- TSDB 场景 ---
+
+/// 滚动覆盖后的时间范围查询：写入量是容量的数倍，最早的数据已被覆盖。
+fn tsdb_iter_rolled_over(backend: Backend) {
+    const SEC: u32 = 4096;
+    const MAX: u32 = 32 * SEC;
+    with_backend!(backend, "ts_rolled", SEC, MAX, |storage| {
+        let mut db = open_tsdb(storage, 64);
+        let data = [0u8; 64];
+        let last = 10_000i64;
+        for t in 1..=last {
+            db.append_with_timestamp(t, &data).unwrap();
+        }
+        let mut oldest = 0;
+        db.tsdb_iter(
+            |_db, tsl| {
+                oldest = tsl.time();
+                false
+            },
+            false,
+        );
+        assert!(oldest > 1, "数据库应已滚动覆盖");
+
+        let mut rng = XorShift(0xD1B5_4A32_D192_ED03);
+        for &span in &[1i64, 100, 1000] {
+            let mut hist = Histogram::new();
+            for _ in 0..1_000 {
+                let from = oldest + rng.next((last - oldest - span + 1) as u32) as i64;
+                let mut count = 0;
+                hist.time(|| {
+                    db.tsdb_iter_by_time(from, from + span - 1, |_db, _tsl| {
+                        count += 1;
+                        true
+                    })
+                });
+                assert_eq!(count, span);
+            }
+            hist.report(&format!("tsdb_iter_by_time_rolled_{}", span), backend);
+        }
+    });
+}
+
+fn main() {
+    // cargo bench 会传入 `--bench` 等参数，其余参数作为场景名过滤
+    let filters: Vec<String> = std::env::args().skip(1).filter(|a| !a.starts_with('-')).collect();
+    let scenarios: [(&str, fn(Backend)); 5] = [
+        ("kvdb_gc_steady", kvdb_gc_steady),
+        ("kvdb_cold_load", kvdb_cold_load),
+        ("kvdb_get_cache_miss", kvdb_get_cache_miss),
+        ("kvdb_large_value", kvdb_large_value),
+        ("tsdb_iter_rolled_over", tsdb_iter_rolled_over),
+    ];
+    for (name, scenario) in scenarios {
+        if !filters.is_empty() && !filters.iter().any(|f| name.contains(f.as_str())) {
+            continue;
+        }
+        for backend in Backend::ALL {
+            scenario(backend);
+        }
+    }
+}
@@ -131,6 +131,13 @@ fn main() {
     let use_kvdb = cfg!(feature = "kvdb");
     let use_tsdb = cfg!(feature = "tsdb");
     let use_log = cfg!(feature = "log");
+    let use_kv_index = cfg!(feature = "kv_index");
+    let use_ts_sec_dir = cfg!(feature = "ts_sec_dir");
+    let use_kv_compress = cfg!(feature = "kv_compress");
+    let use_kv_parallel_load = cfg!(feature = "kv_parallel_load");
+    let use_stats = cfg!(feature = "stats");
+    let use_crc_slice8 = cfg!(feature = "crc_slice8");
+    let use_crc_hw = cfg!(feature = "crc_hw");
     let debug_enabled = cfg!(debug_assertions);
 
     {
@@ -181,9 +188,58 @@ fn main() {
     if use_tsdb {
         build.define("FDB_USING_TSDB", "1");
     }
+    if use_kv_index {
+        build.define("FDB_KV_USING_INDEX", "1");
+    }
+    if use_ts_sec_dir {
+        build.define("FDB_TSDB_USING_SEC_DIR", "1");
+    }
+    if use_kv_compress {
+        build.define("FDB_KV_USING_COMPRESS", "1");
+    }
+    if use_kv_parallel_load {
+        build.define("FDB_KV_USING_PRECHECK", "1");
+    }
+    if use_stats {
+        build.define("FDB_USING_STATS", "1");
+    }
     if debug_enabled {
         build.define("FDB_DEBUG_ENABLE", "1");
     }
+    // 扫描 Flash（查找 KV 魔数、检测擦除区域）时的读缓冲区大小，可通过环境变量 `FDB_SCAN_BUF_SIZE` 配置。
+    // std 环境下栈空间充裕，默认使用更大的窗口以减少读取次数；嵌入式环境沿用 C 代码中的默认值
+    println!("cargo:rerun-if-env-changed=FDB_SCAN_BUF_SIZE");
+    match env::var("FDB_SCAN_BUF_SIZE") {
+        Ok(size) => {
+            match size.trim().parse::<usize>() {
+                Ok(n) if n >= 32 => build.define("FDB_SCAN_BUF_SIZE", n.to_string().as_str()),
+                _ => panic!("FDB_SCAN_BUF_SIZE MUST be a number of at least 32, got `{}`", size),
+            };
+        }
+        Err(_) if cfg!(feature = "std") => {
+            build.define("FDB_SCAN_BUF_SIZE", "1024");
+        }
+        Err(_) => {}
+    }
+    if use_crc_slice8 {
+        build.define("FDB_CRC32_USING_SLICE8", "1");
+    }
+    if use_crc_hw {
+        build.define("FDB_CRC32_USING_HW", "1");
+        // 硬件 CRC 路径在编译期选择：只有目标启用了对应的指令集扩展（如 `-C target-cpu=native`）才会生效，
+        // 否则 C 代码会回退到 slicing-by-8 查表
+        let target_features = env::var("CARGO_CFG_TARGET_FEATURE").unwrap_or_default();
+        let has_feature = |name: &str| target_features.split(',').any(|f| f == name);
+        match env::var("CARGO_CFG_TARGET_ARCH").unwrap_or_default().as_str() {
+            "x86" | "x86_64" if has_feature("pclmulqdq") && has_feature("sse4.1") => {
+                build.flag("-mpclmul").flag("-msse4.1");
+            }
+            "aarch64" if has_feature("crc") => {
+                build.flag_if_supported("-march=armv8-a+crc");
+            }
+            _ => {}
+        }
+    }
 
     build.compile("flashdb");
 
@@ -213,6 +269,21 @@ fn main() {
     if use_tsdb {
         bindings = bindings.clang_arg("-DFDB_USING_TSDB=1");
     }
+    if use_kv_index {
+        bindings = bindings.clang_arg("-DFDB_KV_USING_INDEX=1");
+    }
+    if use_ts_sec_dir {
+        bindings = bindings.clang_arg("-DFDB_TSDB_USING_SEC_DIR=1");
+    }
+    if use_kv_compress {
+        bindings = bindings.clang_arg("-DFDB_KV_USING_COMPRESS=1");
+    }
+    if use_kv_parallel_load {
+        bindings = bindings.clang_arg("-DFDB_KV_USING_PRECHECK=1");
+    }
+    if use_stats {
+        bindings = bindings.clang_arg("-DFDB_USING_STATS=1");
+    }
     if debug_enabled {
         bindings = bindings.clang_arg("-DFDB_DEBUG_ENABLE=1");
     }
@@ -15,6 +15,7 @@
 #ifdef FDB_USING_FILE_MODE
 
 #define DB_PATH_MAX            256
+#define ERASED_BUF_SIZE        32
 
 static void get_db_file_path(fdb_db_t db, uint32_t addr, char *path, size_t size)
 {
@@ -119,16 +120,38 @@ static int open_db_file(fdb_db_t db, uint32_t addr, bool clean)
     return fd;
 }
 
+/* fill the [from, to) area of the file with 0xFF */
+static bool fill_erased(int fd, uint32_t from, uint32_t to)
+{
+    uint8_t buf[ERASED_BUF_SIZE];
+    size_t len;
+
+    memset(buf, 0xFF, sizeof(buf));
+    if (lseek(fd, from, SEEK_SET) != (int32_t)from)
+        return false;
+    for (; from < to; from += len) {
+        len = to - from < sizeof(buf) ? to - from : sizeof(buf);
+        if (write(fd, buf, len) != (ssize_t)len)
+            return false;
+    }
+    return true;
+}
+
 fdb_err_t _fdb_file_read(fdb_db_t db, uint32_t addr, void *buf, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
     int fd = open_db_file(db, addr, false);
     if (fd > 0) {
+        ssize_t len;
         /* get the offset address is relative to the start of the current file */
         addr = addr % db->sec_size;
 
-        if ((lseek(fd, addr, SEEK_SET) != (int32_t)addr) || (read(fd, buf, size) != (ssize_t)size))
+        if ((lseek(fd, addr, SEEK_SET) != (int32_t)addr) || ((len = read(fd, buf, size)) < 0)) {
             result = FDB_READ_ERR;
+        } else if ((size_t)len < size) {
+            /* the area after the end of file is erased */
+            memset((uint8_t *)buf + len, 0xFF, size - len);
+        }
     } else {
         result = FDB_READ_ERR;
     }
@@ -140,10 +163,14 @@ fdb_err_t _fdb_file_write(fdb_db_t db, uint32_t addr, const void *buf, size_t si
     fdb_err_t result = FDB_NO_ERR;
     int fd = open_db_file(db, addr, false);
     if (fd > 0) {
+        off_t file_len = lseek(fd, 0, SEEK_END);
         /* get the offset address is relative to the start of the current file */
         addr = addr % db->sec_size;
 
-        if ((lseek(fd, addr, SEEK_SET) != (int32_t)addr) || (write(fd, buf, size) != (ssize_t)size))
+        /* the hole between the end of file and the write address must read as erased (0xFF) */
+        if (file_len < 0 || ((off_t)addr > file_len && !fill_erased(fd, (uint32_t)file_len, addr)))
+            result = FDB_WRITE_ERR;
+        else if ((lseek(fd, addr, SEEK_SET) != (int32_t)addr) || (write(fd, buf, size) != (ssize_t)size))
             result = FDB_WRITE_ERR;
         if(sync) {
             fsync(fd);
@@ -157,19 +184,9 @@ fdb_err_t _fdb_file_write(fdb_db_t db, uint32_t addr, const void *buf, size_t si
 fdb_err_t _fdb_file_erase(fdb_db_t db, uint32_t addr, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
+    /* the file is truncated when opened with clean, the area after the end of file reads as 0xFF */
     int fd = open_db_file(db, addr, true);
     if (fd > 0) {
-#define BUF_SIZE 32
-        uint8_t buf[BUF_SIZE];
-        size_t i;
-        lseek(fd, 0, SEEK_SET);
-        for (i = 0; i * BUF_SIZE < size; i++)
-        {
-            memset(buf, 0xFF, BUF_SIZE);
-            write(fd, buf, BUF_SIZE);
-        }
-        memset(buf, 0xFF, BUF_SIZE);
-        write(fd, buf, size - i * BUF_SIZE);
         fsync(fd);
     } else {
         result = FDB_ERASE_ERR;
@@ -257,14 +274,44 @@ static FILE *open_db_file(fdb_db_t db, uint32_t addr, bool clean)
     return fd;
 }
 
+/* fill the [from, to) area of the file with 0xFF */
+static bool fill_erased(FILE *fp, uint32_t from, uint32_t to)
+{
+    uint8_t buf[ERASED_BUF_SIZE];
+    size_t len;
+
+    memset(buf, 0xFF, sizeof(buf));
+    if (fseek(fp, from, SEEK_SET) != 0)
+        return false;
+    for (; from < to; from += len) {
+        len = to - from < sizeof(buf) ? to - from : sizeof(buf);
+        if (fwrite(buf, len, 1, fp) != 1)
+            return false;
+    }
+    return true;
+}
+
 fdb_err_t _fdb_file_read(fdb_db_t db, uint32_t addr, void *buf, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
     FILE *fp = open_db_file(db, addr, false);
     if (fp) {
+        size_t len;
         addr = addr % db->sec_size;
-        if ((fseek(fp, addr, SEEK_SET) != 0) || (fread(buf, size, 1, fp) != 1))
+        if (fseek(fp, addr, SEEK_SET) != 0) {
             result = FDB_READ_ERR;
+        } else {
+            len = fread(buf, 1, size, fp);
+            if (len < size) {
+                if (ferror(fp)) {
+                    clearerr(fp);
+                    result = FDB_READ_ERR;
+                } else {
+                    /* the area after the end of file is erased */
+                    memset((uint8_t *)buf + len, 0xFF, size - len);
+                }
+            }
+        }
     } else {
         result = FDB_READ_ERR;
     }
@@ -276,8 +323,12 @@ fdb_err_t _fdb_file_write(fdb_db_t db, uint32_t addr, const void *buf, size_t si
     fdb_err_t result = FDB_NO_ERR;
     FILE *fp = open_db_file(db, addr, false);
     if (fp) {
+        long file_len = (fseek(fp, 0, SEEK_END) == 0) ? ftell(fp) : -1;
         addr = addr % db->sec_size;
-        if ((fseek(fp, addr, SEEK_SET) != 0) || (fwrite(buf, size, 1, fp) != 1))
+        /* the hole between the end of file and the write address must read as erased (0xFF) */
+        if (file_len < 0 || ((long)addr > file_len && !fill_erased(fp, (uint32_t)file_len, addr)))
+            result = FDB_READ_ERR;
+        else if ((fseek(fp, addr, SEEK_SET) != 0) || (fwrite(buf, size, 1, fp) != 1))
             result = FDB_READ_ERR;
         if(sync) {
             fflush(fp);
@@ -292,19 +343,9 @@ fdb_err_t _fdb_file_erase(fdb_db_t db, uint32_t addr, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
 
+    /* the file is truncated when opened with clean, the area after the end of file reads as 0xFF */
     FILE *fp = open_db_file(db, addr, true);
     if (fp != NULL) {
-#define BUF_SIZE 32
-        uint8_t buf[BUF_SIZE];
-        size_t i;
-        fseek(fp, 0, SEEK_SET);
-        for (i = 0; i * BUF_SIZE < size; i++)
-        {
-            memset(buf, 0xFF, BUF_SIZE);
-            fwrite(buf, BUF_SIZE, 1, fp);
-        }
-        memset(buf, 0xFF, BUF_SIZE);
-        fwrite(buf, size - i * BUF_SIZE, 1, fp);
         fflush(fp);
     } else {
         result = FDB_ERASE_ERR;
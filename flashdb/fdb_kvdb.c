@@ -48,6 +48,11 @@
 #define FDB_GC_EMPTY_SEC_THRESHOLD                1
 #endif
 
+/* the incremental GC step starts to collect a new sector when the empty sector number is NOT more than it */
+#ifndef FDB_GC_STEP_EMPTY_SEC_THRESHOLD
+#define FDB_GC_STEP_EMPTY_SEC_THRESHOLD           (FDB_GC_EMPTY_SEC_THRESHOLD + 1)
+#endif
+
 /* the string KV value buffer size for legacy fdb_get_kv(db, ) function */
 #ifndef FDB_STR_KV_VALUE_MAX_SIZE
 #define FDB_STR_KV_VALUE_MAX_SIZE                128
@@ -80,6 +85,19 @@
 #define KV_MAGIC_OFFSET                          ((unsigned long)(&((struct kv_hdr_data *)0)->magic))
 #define KV_LEN_OFFSET                            ((unsigned long)(&((struct kv_hdr_data *)0)->len))
 #define KV_NAME_LEN_OFFSET                       ((unsigned long)(&((struct kv_hdr_data *)0)->name_len))
+#define KV_CRC32_OFFSET                          ((unsigned long)(&((struct kv_hdr_data *)0)->crc32))
+
+#ifdef FDB_KV_USING_COMPRESS
+#define KV_HDR_NAME_LEN(hdr)                     ((hdr)->name_len & ~FDB_KV_FLAG_MASK)
+#else
+#define KV_HDR_NAME_LEN(hdr)                     ((hdr)->name_len)
+#endif
+
+#ifdef FDB_USING_STATS
+#define KV_STATS_ADD(db, field, n)               ((db)->stats.field += (n))
+#else
+#define KV_STATS_ADD(db, field, n)
+#endif
 
 #define db_name(db)                              (((fdb_db_t)db)->name)
 #define db_init_ok(db)                           (((fdb_db_t)db)->init_ok)
@@ -98,6 +116,9 @@
     } while(0);
 
 #define VER_NUM_KV_NAME                         "__ver_num__"
+/* the batch header KV name and magic word(`B`, `C`, `H`, `0`) */
+#define BATCH_KV_NAME                           "__batch__"
+#define BATCH_MAGIC_WORD                        0x30484342
 
 struct sector_hdr_data {
     struct {
@@ -129,6 +150,13 @@ struct kv_hdr_data {
 };
 typedef struct kv_hdr_data *kv_hdr_data_t;
 
+/* the value of batch header KV, it's written before all member KV of the batch */
+struct kv_batch_data {
+    uint32_t magic;                              /**< magic word(`B`, `C`, `H`, `0`) */
+    uint32_t count;                              /**< member KV count */
+    uint32_t len;                                /**< batch total length (header KV + all member KV) */
+};
+
 struct alloc_kv_cb_args {
     fdb_kvdb_t db;
     size_t kv_size;
@@ -143,6 +171,31 @@ struct gc_cb_args {
 
 static void gc_collect(fdb_kvdb_t db);
 static void gc_collect_by_free_size(fdb_kvdb_t db, size_t free_size);
+static bool read_batch_data(fdb_kvdb_t db, fdb_kv_t kv, struct kv_batch_data *batch);
+static void batch_roll_forward(fdb_kvdb_t db, fdb_kv_t batch_kv, const struct kv_batch_data *batch);
+
+#ifdef FDB_KV_USING_INDEX
+/*
+ * The full KV index port. It maps every KV name to the address of its valid (FDB_KV_WRITE) KV node,
+ * the index object is saved in db->kv_index and implemented outside the library (e.g. a map in host RAM).
+ */
+extern bool fdb_kv_index_get(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t *addr);
+extern void fdb_kv_index_set(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr);
+/* remove the index of the name only when it still points to the addr */
+extern void fdb_kv_index_del(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr);
+extern void fdb_kv_index_clear(fdb_kvdb_t db);
+/* restore the index from a snapshot which is saved when the database closed cleanly, return false when it's unavailable */
+extern bool fdb_kv_index_restore(fdb_kvdb_t db);
+#endif /* FDB_KV_USING_INDEX */
+
+#ifdef FDB_KV_USING_PRECHECK
+/*
+ * The KV CRC32 precheck port. The KV CRC32 are verified by fdb_kv_sector_precheck before the database load,
+ * e.g. on several threads, the result object is saved in db->kv_precheck and implemented outside the library.
+ * Return true when the KV at the addr with the same length and CRC32 has been verified OK.
+ */
+extern bool fdb_kv_precheck_get(fdb_kvdb_t db, uint32_t addr, uint32_t len, uint32_t crc32);
+#endif /* FDB_KV_USING_PRECHECK */
 
 #ifdef FDB_KV_USING_CACHE
 static void update_sector_cache(fdb_kvdb_t db, kv_sec_info_t sector)
@@ -276,9 +329,12 @@ static bool get_kv_from_cache(fdb_kvdb_t db, const char *name, size_t name_len,
  */
 static uint32_t find_next_kv_addr(fdb_kvdb_t db, uint32_t start, uint32_t end)
 {
-    uint8_t buf[32];
-    uint32_t start_bak = start, i;
-    uint32_t magic;
+    uint8_t buf[FDB_SCAN_BUF_SIZE];
+    uint32_t start_bak = start, magic_word = KV_MAGIC_WORD;
+    uint8_t magic[sizeof(uint32_t)];
+    const uint8_t *p, *limit;
+    /* the next KV is usually right there, so the first read window is small */
+    size_t read_size, win_size = sizeof(buf) < 32 ? sizeof(buf) : 32;
 
 #ifdef FDB_KV_USING_CACHE
     kv_sec_info_t sector;
@@ -288,19 +344,26 @@ static uint32_t find_next_kv_addr(fdb_kvdb_t db, uint32_t start, uint32_t end)
     }
 #endif /* FDB_KV_USING_CACHE */
 
-    for (; start < end && start + sizeof(buf) < end; start += (sizeof(buf) - sizeof(uint32_t))) {
-        if (_fdb_flash_read((fdb_db_t)db, start, (uint32_t *) buf, sizeof(buf)) != FDB_NO_ERR)
+    /* the magic word is saved in CPU byte order */
+    memcpy(magic, &magic_word, sizeof(magic));
+
+    /* the read windows are overlapped by 3 bytes, so the magic word across two windows will NOT be missed */
+    for (; start + sizeof(uint32_t) <= end; start += read_size - (sizeof(uint32_t) - 1)) {
+        read_size = end - start < win_size ? end - start : win_size;
+        if (_fdb_flash_read((fdb_db_t)db, start, (uint32_t *) buf, read_size) != FDB_NO_ERR)
             return FAILED_ADDR;
-        for (i = 0; i < sizeof(buf) - sizeof(uint32_t) && start + i < end; i++) {
-#ifndef FDB_BIG_ENDIAN            /* Little Endian Order */
-            magic = buf[i] + ((uint32_t)buf[i + 1] << 8) + ((uint32_t)buf[i + 2] << 16) + ((uint32_t)buf[i + 3] << 24);
-#else                       /* Big Endian Order */
-            magic = buf[i + 3] + ((uint32_t)buf[i + 2] << 8) + ((uint32_t)buf[i + 1] << 16) + ((uint32_t)buf[i] << 24);
-#endif
-            if (magic == KV_MAGIC_WORD && (start + i - KV_MAGIC_OFFSET) >= start_bak) {
-                return start + i - KV_MAGIC_OFFSET;
+        /* search the first magic byte by memchr, then check the rest bytes */
+        limit = buf + read_size - (sizeof(uint32_t) - 1);
+        for (p = buf; (p = memchr(p, magic[0], limit - p)) != NULL; p++) {
+            if (!memcmp(p + 1, magic + 1, sizeof(uint32_t) - 1)
+                    && (start + (uint32_t)(p - buf) - KV_MAGIC_OFFSET) >= start_bak) {
+                return start + (uint32_t)(p - buf) - KV_MAGIC_OFFSET;
             }
         }
+        if (read_size < win_size) {
+            break;
+        }
+        win_size = sizeof(buf);
     }
 
     return FAILED_ADDR;
@@ -372,6 +435,17 @@ static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
     calc_crc32 = fdb_calc_crc32(calc_crc32, &kv_hdr.name_len, sizeof(uint32_t));
     calc_crc32 = fdb_calc_crc32(calc_crc32, &kv_hdr.value_len, sizeof(uint32_t));
     crc_data_len = kv->len - KV_HDR_DATA_SIZE;
+#ifdef FDB_KV_USING_COMPRESS
+    /* the flags are covered by the CRC32 above, split them from the name length */
+    kv->flags = kv_hdr.name_len & FDB_KV_FLAG_MASK;
+    kv_hdr.name_len &= ~FDB_KV_FLAG_MASK;
+#endif
+#ifdef FDB_KV_USING_PRECHECK
+    /* the KV has been verified by the precheck, skip reading the whole KV data */
+    if (db->in_recovery_check && db->kv_precheck && fdb_kv_precheck_get(db, kv->addr.start, kv->len, kv_hdr.crc32)) {
+        calc_crc32 = kv_hdr.crc32;
+    } else
+#endif
     /* calculate the CRC32 value */
     for (len = 0, size = 0; len < crc_data_len; len += size) {
         if (len + sizeof(buf) < crc_data_len) {
@@ -583,13 +657,42 @@ static bool find_kv(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
 {
     bool find_ok = false;
 
+#ifdef FDB_KV_USING_INDEX
+    if (db->kv_index_ready) {
+        size_t name_len = strlen(key);
+        uint32_t index_addr;
+
+        /* the index contains all KV, so the KV is NOT exist when it's not in the index */
+        if (!fdb_kv_index_get(db, key, name_len, &index_addr)) {
+            return false;
+        }
+        kv->addr.start = index_addr;
+        read_kv(db, kv);
+        if (kv->crc_is_ok && kv->status == FDB_KV_WRITE && kv->name_len == name_len
+                && !strncmp(kv->name, key, name_len)) {
+            return true;
+        }
+        /* the index is out of date, search it on flash then correct the index */
+        FDB_DEBUG("The index of KV (%s) @0x%08" PRIX32 " is out of date.\n", key, index_addr);
+        find_ok = find_kv_no_cache(db, key, kv);
+        if (find_ok) {
+            fdb_kv_index_set(db, key, name_len, kv->addr.start);
+        } else {
+            fdb_kv_index_del(db, key, name_len, index_addr);
+        }
+        return find_ok;
+    }
+#endif /* FDB_KV_USING_INDEX */
+
 #ifdef FDB_KV_USING_CACHE
     size_t key_len = strlen(key);
 
     if (get_kv_from_cache(db, key, key_len, &kv->addr.start)) {
+        KV_STATS_ADD(db, cache_hits, 1);
         read_kv(db, kv);
         return true;
     }
+    KV_STATS_ADD(db, cache_misses, 1);
 #endif /* FDB_KV_USING_CACHE */
 
     find_ok = find_kv_no_cache(db, key, kv);
@@ -661,6 +764,7 @@ fdb_kv_t fdb_kv_get_obj(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
     /* lock the KV cache */
     db_lock(db);
 
+    KV_STATS_ADD(db, get_calls, 1);
     find_ok = find_kv(db, key, kv);
 
     /* unlock the KV cache */
@@ -707,6 +811,7 @@ size_t fdb_kv_get_blob(fdb_kvdb_t db, const char *key, fdb_blob_t blob)
     /* lock the KV cache */
     db_lock(db);
 
+    KV_STATS_ADD(db, get_calls, 1);
     read_len = get_kv(db, key, blob->buf, blob->size, &blob->saved.len);
 
     /* unlock the KV cache */
@@ -770,6 +875,10 @@ static fdb_err_t format_sector(fdb_kvdb_t db, uint32_t addr, uint32_t combined_v
 
     FDB_ASSERT(addr % db_sec_size(db) == 0);
 
+#ifdef FDB_KV_USING_PRECHECK
+    /* the precheck result of the KV in the erased sector is invalid */
+    db->kv_precheck = NULL;
+#endif
     result = _fdb_flash_erase((fdb_db_t)db, addr, db_sec_size(db));
     if (result == FDB_NO_ERR) {
         /* initialize the header data */
@@ -934,17 +1043,36 @@ static uint32_t alloc_kv(fdb_kvdb_t db, kv_sec_info_t sector, size_t kv_size)
     return empty_kv;
 }
 
-static fdb_err_t del_kv(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool complete_del)
+/*
+ * change the dirty status of the sector which the KV is in to FDB_SECTOR_DIRTY_TRUE
+ */
+static fdb_err_t mark_sec_dirty(fdb_kvdb_t db, uint32_t kv_addr, bool sync)
 {
     fdb_err_t result = FDB_NO_ERR;
-    uint32_t dirty_status_addr;
-    struct fdb_kv kv = { .status = FDB_KV_UNUSED };
+    uint8_t status_table[FDB_DIRTY_STATUS_TABLE_SIZE];
+    uint32_t dirty_status_addr = FDB_ALIGN_DOWN(kv_addr, db_sec_size(db)) + SECTOR_DIRTY_OFFSET;
+
+    /* read and change the sector dirty status */
+    if (_fdb_read_status((fdb_db_t)db, dirty_status_addr, status_table, FDB_SECTOR_DIRTY_STATUS_NUM) == FDB_SECTOR_DIRTY_FALSE) {
+        result = _fdb_write_status((fdb_db_t)db, dirty_status_addr, status_table, FDB_SECTOR_DIRTY_STATUS_NUM, FDB_SECTOR_DIRTY_TRUE, sync);
+#ifdef FDB_KV_USING_CACHE
+        {
+            kv_sec_info_t sector_cache = get_sector_from_cache(db, FDB_ALIGN_DOWN(kv_addr, db_sec_size(db)));
+            if (sector_cache) {
+                sector_cache->status.dirty = FDB_SECTOR_DIRTY_TRUE;
+            }
+        }
+#endif /* FDB_KV_USING_CACHE */
+    }
+
+    return result;
+}
 
-#if (KV_STATUS_TABLE_SIZE >= FDB_DIRTY_STATUS_TABLE_SIZE)
+static fdb_err_t del_kv_ex(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool complete_del, bool sync)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct fdb_kv kv = { .status = FDB_KV_UNUSED };
     uint8_t status_table[KV_STATUS_TABLE_SIZE];
-#else
-    uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
-#endif
 
     /* need find KV */
     if (!old_kv) {
@@ -961,7 +1089,18 @@ static fdb_err_t del_kv(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool co
         result = _fdb_write_status((fdb_db_t)db, old_kv->addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_PRE_DELETE, false);
         db->last_is_complete_del = true;
     } else {
-        result = _fdb_write_status((fdb_db_t)db, old_kv->addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_DELETED, true);
+        result = _fdb_write_status((fdb_db_t)db, old_kv->addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_DELETED, sync);
+
+#ifdef FDB_KV_USING_INDEX
+        if (result == FDB_NO_ERR) {
+            /* the index is already pointed to the new KV when the KV is changed or moved, it will not be removed */
+            if (key != NULL) {
+                fdb_kv_index_del(db, key, strlen(key), old_kv->addr.start);
+            } else {
+                fdb_kv_index_del(db, old_kv->name, old_kv->name_len, old_kv->addr.start);
+            }
+        }
+#endif /* FDB_KV_USING_INDEX */
 
         if (!db->last_is_complete_del && result == FDB_NO_ERR) {
 #ifdef FDB_KV_USING_CACHE
@@ -979,24 +1118,18 @@ static fdb_err_t del_kv(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool co
         db->last_is_complete_del = false;
     }
 
-    dirty_status_addr = FDB_ALIGN_DOWN(old_kv->addr.start, db_sec_size(db)) + SECTOR_DIRTY_OFFSET;
-    /* read and change the sector dirty status */
-    if (result == FDB_NO_ERR
-            && _fdb_read_status((fdb_db_t)db, dirty_status_addr, status_table, FDB_SECTOR_DIRTY_STATUS_NUM) == FDB_SECTOR_DIRTY_FALSE) {
-        result = _fdb_write_status((fdb_db_t)db, dirty_status_addr, status_table, FDB_SECTOR_DIRTY_STATUS_NUM, FDB_SECTOR_DIRTY_TRUE, true);
-#ifdef FDB_KV_USING_CACHE
-        {
-            kv_sec_info_t sector_cache = get_sector_from_cache(db, FDB_ALIGN_DOWN(old_kv->addr.start, db_sec_size(db)));
-            if (sector_cache) {
-                sector_cache->status.dirty = FDB_SECTOR_DIRTY_TRUE;
-            }
-        }
-#endif /* FDB_KV_USING_CACHE */
+    if (result == FDB_NO_ERR) {
+        result = mark_sec_dirty(db, old_kv->addr.start, sync);
     }
 
     return result;
 }
 
+static fdb_err_t del_kv(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool complete_del)
+{
+    return del_kv_ex(db, key, old_kv, complete_del, true);
+}
+
 /*
  * move the KV to new space
  */
@@ -1006,6 +1139,15 @@ static fdb_err_t move_kv(fdb_kvdb_t db, fdb_kv_t kv)
     uint8_t status_table[KV_STATUS_TABLE_SIZE];
     uint32_t kv_addr;
     struct kvdb_sec_info sector;
+    struct kv_batch_data batch;
+
+    /* The batch header KV describes the member KVs behind it by address, so it MUST NOT be moved.
+     * It's still alive only when the roll-forward was not finished, so finish it and collect the header. */
+    if (read_batch_data(db, kv, &batch)) {
+        FDB_INFO("Found a committed KV batch (count %" PRIu32 ") when moving. Now will roll forward it.\n", batch.count);
+        batch_roll_forward(db, kv, &batch);
+        return FDB_NO_ERR;
+    }
 
     /* prepare to delete the current KV */
     if (kv->status == FDB_KV_WRITE) {
@@ -1053,8 +1195,13 @@ static fdb_err_t move_kv(fdb_kvdb_t db, fdb_kv_t kv)
                 kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv->name_len) + FDB_WG_ALIGN(kv->value_len));
         update_kv_cache(db, kv->name, kv->name_len, kv_addr);
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX
+        fdb_kv_index_set(db, kv->name, kv->name_len, kv_addr);
+#endif /* FDB_KV_USING_INDEX */
     }
 
+    KV_STATS_ADD(db, moved_kvs, 1);
+    KV_STATS_ADD(db, moved_bytes, kv->len);
     FDB_DEBUG("Moved the KV (%.*s) from 0x%08" PRIX32 " to 0x%08" PRIX32 ".\n", kv->name_len, kv->name, kv->addr.start, kv_addr);
 
 __exit:
@@ -1131,6 +1278,7 @@ static bool do_gc(kv_sec_info_t sector, void *arg1, void *arg2)
             }
         } while ((kv.addr.start = get_next_kv_addr(db, sector, &kv)) != FAILED_ADDR);
         format_sector(db, sector->addr, SECTOR_NOT_COMBINED);
+        KV_STATS_ADD(db, gc_sectors, 1);
         last_gc_sec_addr = gc->last_gc_sec_addr;
         gc->last_gc_sec_addr = sector->addr;
         /* update oldest_addr for next GC sector format */
@@ -1147,6 +1295,92 @@ static bool do_gc(kv_sec_info_t sector, void *arg1, void *arg2)
     return false;
 }
 
+/*
+ * Calculate the live (write or pre-delete status) KV size of the sector, only the KV header is read.
+ */
+static size_t calc_sector_live_size(fdb_kvdb_t db, kv_sec_info_t sector)
+{
+    struct kv_hdr_data kv_hdr;
+    struct fdb_kv kv;
+    fdb_kv_status_t status;
+    size_t live = 0;
+
+    for (kv.addr.start = sector->addr + SECTOR_HDR_DATA_SIZE; kv.addr.start != FAILED_ADDR;
+            kv.addr.start = get_next_kv_addr(db, sector, &kv)) {
+        _fdb_flash_read((fdb_db_t)db, kv.addr.start, (uint32_t *)&kv_hdr, sizeof(struct kv_hdr_data));
+        status = (fdb_kv_status_t) _fdb_get_status(kv_hdr.status_table, FDB_KV_STATUS_NUM);
+        if (kv_hdr.len == UINT32_MAX || kv_hdr.len > db_sec_size(db) - SECTOR_HDR_DATA_SIZE || kv_hdr.len < KV_HDR_DATA_SIZE) {
+            /* the KV length has an error, find the next KV by magic word */
+            kv.len = KV_HDR_DATA_SIZE;
+            kv.crc_is_ok = false;
+        } else {
+            kv.len = kv_hdr.len;
+            kv.crc_is_ok = true;
+            if (status == FDB_KV_WRITE || status == FDB_KV_PRE_DELETE) {
+                live += kv.len;
+            }
+        }
+    }
+
+    return live;
+}
+
+struct gc_victim_cb_args {
+    fdb_kvdb_t db;
+    size_t age;                                  /**< current sector age, the oldest sector is the sector number */
+    uint32_t addr;                               /**< the victim sector address */
+    uint64_t score;                              /**< the victim score, the bigger is the better */
+};
+
+static bool gc_victim_cb(kv_sec_info_t sector, void *arg1, void *arg2)
+{
+    struct gc_victim_cb_args *victim = arg1;
+    fdb_kvdb_t db = victim->db;
+    size_t age = victim->age--, free_size, live;
+    uint64_t score;
+
+    if (!sector->check_ok || sector->status.store == FDB_SECTOR_STORE_EMPTY) {
+        return false;
+    }
+    if (sector->status.dirty == FDB_SECTOR_DIRTY_GC) {
+        /* the interrupted GC sector MUST be finished first */
+        victim->addr = sector->addr;
+        return true;
+    }
+    if (sector->status.dirty != FDB_SECTOR_DIRTY_TRUE) {
+        return false;
+    }
+    live = calc_sector_live_size(db, sector);
+    free_size = db_sec_size(db) - SECTOR_HDR_DATA_SIZE - live;
+    if (db->gc_policy == FDB_KV_GC_GREEDY) {
+        score = free_size;
+    } else {
+        /* the benefit is the free size which is held for a long time, the cost is reading the sector and writing the live KV */
+        score = (uint64_t)free_size * age * 1024 / (db_sec_size(db) + live);
+    }
+    if (victim->addr == FAILED_ADDR || score > victim->score) {
+        victim->addr = sector->addr;
+        victim->score = score;
+    }
+
+    return false;
+}
+
+/*
+ * Select the GC victim sector by the GC policy.
+ *
+ * @return the victim sector address, FAILED_ADDR: no dirty sector
+ */
+static uint32_t gc_select_victim(fdb_kvdb_t db)
+{
+    struct kvdb_sec_info sector;
+    struct gc_victim_cb_args victim = { db, SECTOR_NUM, FAILED_ADDR, 0 };
+
+    sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &victim, NULL, gc_victim_cb, false);
+
+    return victim.addr;
+}
+
 static void gc_collect_by_free_size(fdb_kvdb_t db, size_t free_size)
 {
     struct kvdb_sec_info sector;
@@ -1161,7 +1395,18 @@ static void gc_collect_by_free_size(fdb_kvdb_t db, size_t free_size)
     FDB_DEBUG("The remain empty sector is %" PRIu32 ", GC threshold is %" PRIdLEAST16 ".\n", (uint32_t)empty_sec_num, FDB_GC_EMPTY_SEC_THRESHOLD);
     if (empty_sec_num <= FDB_GC_EMPTY_SEC_THRESHOLD) {
         struct gc_cb_args arg = { db, free_size, empty_sec_addr };
-        sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &arg, NULL, do_gc, false);
+        KV_STATS_ADD(db, gc_runs, 1);
+        if (db->gc_policy == FDB_KV_GC_SEQUENTIAL) {
+            sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &arg, NULL, do_gc, false);
+        } else {
+            uint32_t victim_addr;
+            /* collect the best victim one by one, the collected sector is NOT dirty anymore */
+            while ((victim_addr = gc_select_victim(db)) != FAILED_ADDR) {
+                if (read_sector_info(db, victim_addr, &sector, false) != FDB_NO_ERR || do_gc(&sector, &arg, NULL)) {
+                    break;
+                }
+            }
+        }
     }
 
     db->gc_request = false;
@@ -1177,6 +1422,126 @@ static void gc_collect(fdb_kvdb_t db)
     gc_collect_by_free_size(db, db_max_size(db));
 }
 
+struct gc_stat_cb_args {
+    size_t empty_sec;                            /**< empty sector count */
+    size_t dirty_sec;                            /**< dirty sector count, including the collecting sector */
+    uint32_t gc_sec_addr;                        /**< the collecting sector (dirty status is GC) address */
+    uint32_t victim_addr;                        /**< the next sector to collect */
+};
+
+static bool gc_stat_cb(kv_sec_info_t sector, void *arg1, void *arg2)
+{
+    struct gc_stat_cb_args *stat = arg1;
+
+    if (!sector->check_ok) {
+        return false;
+    }
+    if (sector->status.store == FDB_SECTOR_STORE_EMPTY) {
+        stat->empty_sec++;
+    } else if (sector->status.dirty == FDB_SECTOR_DIRTY_GC) {
+        stat->dirty_sec++;
+        if (stat->gc_sec_addr == FAILED_ADDR) {
+            stat->gc_sec_addr = sector->addr;
+        }
+    } else if (sector->status.dirty == FDB_SECTOR_DIRTY_TRUE) {
+        stat->dirty_sec++;
+        if (stat->victim_addr == FAILED_ADDR) {
+            stat->victim_addr = sector->addr;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Run an incremental GC step, it moves at most `budget` KVs of ONE sector.
+ * The collecting sector keeps the GC dirty status between steps (also after reboot), it will be continued
+ * by the next step or collected completely by the full GC.
+ *
+ * @return true when the GC has more work
+ */
+static bool gc_step(fdb_kvdb_t db, size_t budget)
+{
+    struct gc_stat_cb_args stat = { 0, 0, FAILED_ADDR, FAILED_ADDR };
+    struct kvdb_sec_info sector;
+    struct fdb_kv kv;
+    uint32_t sec_addr;
+    size_t moved = 0;
+    bool pending;
+
+    sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &stat, NULL, gc_stat_cb, false);
+    if ((sec_addr = stat.gc_sec_addr) == FAILED_ADDR) {
+        /* start to collect a new sector only when the empty sectors are not enough */
+        if (stat.victim_addr == FAILED_ADDR || stat.empty_sec > FDB_GC_STEP_EMPTY_SEC_THRESHOLD) {
+            db->gc_request = false;
+            return false;
+        }
+        sec_addr = db->gc_policy == FDB_KV_GC_SEQUENTIAL ? stat.victim_addr : gc_select_victim(db);
+    }
+    if (read_sector_info(db, sec_addr, &sector, false) != FDB_NO_ERR) {
+        db->gc_request = false;
+        return false;
+    }
+    if (sector.status.dirty != FDB_SECTOR_DIRTY_GC) {
+        uint8_t status_table[FDB_DIRTY_STATUS_TABLE_SIZE];
+        /* change the sector status to GC */
+        _fdb_write_status((fdb_db_t)db, sector.addr + SECTOR_DIRTY_OFFSET, status_table, FDB_SECTOR_DIRTY_STATUS_NUM, FDB_SECTOR_DIRTY_GC, true);
+        sector.status.dirty = FDB_SECTOR_DIRTY_GC;
+#ifdef FDB_KV_USING_CACHE
+        {
+            kv_sec_info_t sector_cache = get_sector_from_cache(db, sector.addr);
+            if (sector_cache) {
+                sector_cache->status.dirty = FDB_SECTOR_DIRTY_GC;
+            }
+        }
+#endif /* FDB_KV_USING_CACHE */
+    }
+    /* the GC request allows the moved KV using the reserved empty sector */
+    db->gc_request = true;
+    for (kv.addr.start = sector.addr + SECTOR_HDR_DATA_SIZE; kv.addr.start != FAILED_ADDR;
+            kv.addr.start = get_next_kv_addr(db, &sector, &kv)) {
+        read_kv(db, &kv);
+        if (kv.crc_is_ok && (kv.status == FDB_KV_WRITE || kv.status == FDB_KV_PRE_DELETE)) {
+            if (moved == budget) {
+                break;
+            }
+            /* move the KV to new space */
+            if (move_kv(db, &kv) != FDB_NO_ERR) {
+                FDB_INFO("Error: Moved the KV (%.*s) for GC failed.\n", kv.name_len, kv.name);
+            }
+            moved++;
+        }
+    }
+    if (kv.addr.start == FAILED_ADDR) {
+        /* all KVs were moved, collect the sector */
+        format_sector(db, sector.addr, SECTOR_NOT_COMBINED);
+        KV_STATS_ADD(db, gc_sectors, 1);
+        /* update oldest_addr for next GC sector format */
+        db_oldest_addr(db) = get_next_sector_addr(db, &sector, 0);
+        FDB_DEBUG("Collect a sector @0x%08" PRIX32 " by GC step\n", sector.addr);
+        pending = stat.dirty_sec > 1 && stat.empty_sec + 1 <= FDB_GC_STEP_EMPTY_SEC_THRESHOLD;
+    } else {
+        pending = true;
+    }
+    db->gc_request = false;
+
+    return pending;
+}
+
+/*
+ * process the GC after write KV.
+ * When the GC budget is set, it runs an incremental GC step after each write, so the sectors are collected
+ * before the empty sectors run out, and the full GC on the KV allocation is rarely needed.
+ */
+static void gc_after_write(fdb_kvdb_t db, size_t free_size)
+{
+    if (db->gc_budget > 0) {
+        gc_step(db, db->gc_budget);
+    } else if (db->gc_request) {
+        gc_collect_by_free_size(db, free_size);
+    }
+}
+
 static fdb_err_t align_write(fdb_kvdb_t db, uint32_t addr, const uint32_t *buf, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
@@ -1204,7 +1569,48 @@ static fdb_err_t align_write(fdb_kvdb_t db, uint32_t addr, const uint32_t *buf,
     return result;
 }
 
-static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char *key, const void *value, size_t len)
+/*
+ * calculate the CRC32 then write the KV header, name and value, the KV status will be FDB_KV_PRE_WRITE after it.
+ * The magic, name_len, value_len and len of the KV header MUST be filled by caller.
+ */
+static fdb_err_t write_kv_body(fdb_kvdb_t db, uint32_t kv_addr, kv_hdr_data_t kv_hdr, const char *key, const void *value)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint8_t ff = FDB_BYTE_ERASED;
+    size_t align_remain;
+
+    /* start calculate CRC32 */
+    kv_hdr->crc32 = 0;
+    /* CRC32(header.name_len + header.value_len + name + value), using sizeof(uint32_t) for compatible V1.x */
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, &kv_hdr->name_len, sizeof(uint32_t));
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, &kv_hdr->value_len, sizeof(uint32_t));
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, key, KV_HDR_NAME_LEN(kv_hdr));
+    align_remain = FDB_WG_ALIGN(KV_HDR_NAME_LEN(kv_hdr)) - KV_HDR_NAME_LEN(kv_hdr);
+    while (align_remain--) {
+        kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, &ff, 1);
+    }
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, value, kv_hdr->value_len);
+    align_remain = FDB_WG_ALIGN(kv_hdr->value_len) - kv_hdr->value_len;
+    while (align_remain--) {
+        kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, &ff, 1);
+    }
+    /* write KV header data */
+    result = write_kv_hdr(db, kv_addr, kv_hdr);
+    /* write key name */
+    if (result == FDB_NO_ERR) {
+        result = align_write(db, kv_addr + KV_HDR_DATA_SIZE, (uint32_t *) key, KV_HDR_NAME_LEN(kv_hdr));
+    }
+    /* write value */
+    if (result == FDB_NO_ERR) {
+        result = align_write(db, kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(KV_HDR_NAME_LEN(kv_hdr)), value,
+                kv_hdr->value_len);
+    }
+
+    return result;
+}
+
+static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char *key, const void *value, size_t len,
+        uint8_t flags)
 {
     fdb_err_t result = FDB_NO_ERR;
     struct kv_hdr_data kv_hdr;
@@ -1221,6 +1627,11 @@ static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char
     kv_hdr.name_len = strlen(key);
     kv_hdr.value_len = len;
     kv_hdr.len = KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr.name_len) + FDB_WG_ALIGN(kv_hdr.value_len);
+#ifdef FDB_KV_USING_COMPRESS
+    kv_hdr.name_len |= flags & FDB_KV_FLAG_MASK;
+#else
+    (void)flags;
+#endif
 
     if (kv_hdr.len > db_sec_size(db) - SECTOR_HDR_DATA_SIZE) {
         FDB_INFO("Error: The KV size is too big\n");
@@ -1228,53 +1639,32 @@ static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char
     }
 
     if (kv_addr != FAILED_ADDR || (kv_addr = new_kv(db, sector, kv_hdr.len)) != FAILED_ADDR) {
-        size_t align_remain;
         /* update the sector status */
         if (result == FDB_NO_ERR) {
             result = update_sec_status(db, sector, kv_hdr.len, &is_full);
         }
+        /* write KV header, name and value */
         if (result == FDB_NO_ERR) {
-            uint8_t ff = FDB_BYTE_ERASED;
-            /* start calculate CRC32 */
-            kv_hdr.crc32 = 0;
-            /* CRC32(header.name_len + header.value_len + name + value), using sizeof(uint32_t) for compatible V1.x */
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &kv_hdr.name_len, sizeof(uint32_t));
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &kv_hdr.value_len, sizeof(uint32_t));
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, key, kv_hdr.name_len);
-            align_remain = FDB_WG_ALIGN(kv_hdr.name_len) - kv_hdr.name_len;
-            while (align_remain--) {
-                kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &ff, 1);
-            }
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, value, kv_hdr.value_len);
-            align_remain = FDB_WG_ALIGN(kv_hdr.value_len) - kv_hdr.value_len;
-            while (align_remain--) {
-                kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &ff, 1);
-            }
-            /* write KV header data */
-            result = write_kv_hdr(db, kv_addr, &kv_hdr);
+            result = write_kv_body(db, kv_addr, &kv_hdr, key, value);
         }
-        /* write key name */
-        if (result == FDB_NO_ERR) {
-            result = align_write(db, kv_addr + KV_HDR_DATA_SIZE, (uint32_t *) key, kv_hdr.name_len);
-
 #ifdef FDB_KV_USING_CACHE
+        if (result == FDB_NO_ERR) {
             if (!is_full) {
-                update_sector_empty_addr_cache(db, sector->addr,
-                        kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr.name_len) + FDB_WG_ALIGN(kv_hdr.value_len));
+                update_sector_empty_addr_cache(db, sector->addr, kv_addr + kv_hdr.len);
             }
-            update_kv_cache(db, key, kv_hdr.name_len, kv_addr);
-#endif /* FDB_KV_USING_CACHE */
-        }
-        /* write value */
-        if (result == FDB_NO_ERR) {
-            result = align_write(db, kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr.name_len), value,
-                    kv_hdr.value_len);
+            update_kv_cache(db, key, KV_HDR_NAME_LEN(&kv_hdr), kv_addr);
         }
+#endif /* FDB_KV_USING_CACHE */
         /* change the KV status to KV_WRITE */
         if (result == FDB_NO_ERR) {
             result = _fdb_write_status((fdb_db_t) db, kv_addr, kv_hdr.status_table, FDB_KV_STATUS_NUM, FDB_KV_WRITE,
                     true);
         }
+#ifdef FDB_KV_USING_INDEX
+        if (result == FDB_NO_ERR) {
+            fdb_kv_index_set(db, key, KV_HDR_NAME_LEN(&kv_hdr), kv_addr);
+        }
+#endif /* FDB_KV_USING_INDEX */
         /* trigger GC collect when current sector is full */
         if (result == FDB_NO_ERR && is_full) {
             FDB_DEBUG("Trigger a GC check after created KV.\n");
@@ -1307,6 +1697,7 @@ fdb_err_t fdb_kv_del(fdb_kvdb_t db, const char *key)
     /* lock the KV cache */
     db_lock(db);
 
+    KV_STATS_ADD(db, del_calls, 1);
     result = del_kv(db, key, NULL, true);
 
     /* unlock the KV cache */
@@ -1315,11 +1706,26 @@ fdb_err_t fdb_kv_del(fdb_kvdb_t db, const char *key)
     return result;
 }
 
-static fdb_err_t set_kv(fdb_kvdb_t db, const char *key, const void *value_buf, size_t buf_len)
+/*
+ * the batch header KV name is reserved, GC and recovery check treat the KV with this name as a batch header
+ */
+static bool kv_name_is_reserved(fdb_kvdb_t db, const char *key)
+{
+    if (!strcmp(key, BATCH_KV_NAME)) {
+        FDB_INFO("Error: The KV name (%s) is reserved\n", key);
+        return true;
+    }
+    return false;
+}
+
+static fdb_err_t set_kv(fdb_kvdb_t db, const char *key, const void *value_buf, size_t buf_len, uint8_t flags)
 {
     fdb_err_t result = FDB_NO_ERR;
     bool kv_is_found = false;
 
+    if (kv_name_is_reserved(db, key)) {
+        return FDB_KV_NAME_ERR;
+    }
     if (value_buf == NULL) {
         result = del_kv(db, key, NULL, true);
     } else {
@@ -1334,16 +1740,14 @@ static fdb_err_t set_kv(fdb_kvdb_t db, const char *key, const void *value_buf, s
         }
         /* create the new KV */
         if (result == FDB_NO_ERR) {
-            result = create_kv_blob(db, &db->cur_sector, key, value_buf, buf_len);
+            result = create_kv_blob(db, &db->cur_sector, key, value_buf, buf_len, flags);
         }
         /* delete the old KV */
         if (kv_is_found && result == FDB_NO_ERR) {
             result = del_kv(db, key, &db->cur_kv, true);
         }
         /* process the GC after set KV */
-        if (db->gc_request) {
-            gc_collect_by_free_size(db, KV_HDR_DATA_SIZE + FDB_WG_ALIGN(strlen(key)) + FDB_WG_ALIGN(buf_len));
-        }
+        gc_after_write(db, KV_HDR_DATA_SIZE + FDB_WG_ALIGN(strlen(key)) + FDB_WG_ALIGN(buf_len));
     }
 
     return result;
@@ -1371,13 +1775,54 @@ fdb_err_t fdb_kv_set_blob(fdb_kvdb_t db, const char *key, fdb_blob_t blob)
     /* lock the KV cache */
     db_lock(db);
 
-    result = set_kv(db, key, blob->buf, blob->size);
+    KV_STATS_ADD(db, set_calls, 1);
+    if (blob->buf) {
+        KV_STATS_ADD(db, set_bytes, strlen(key) + blob->size);
+    }
+    result = set_kv(db, key, blob->buf, blob->size, 0);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
+#ifdef FDB_KV_USING_COMPRESS
+/**
+ * Set a blob KV with the KV flags. The flags are saved in the KV header and returned by the KV object,
+ * the value is saved as it is, e.g. the caller compresses the value and sets FDB_KV_FLAG_COMPRESSED.
+ *
+ * @param db database object
+ * @param key KV name
+ * @param blob blob object
+ * @param flags KV flags, @see FDB_KV_FLAG_COMPRESSED
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_set_blob_ex(fdb_kvdb_t db, const char *key, fdb_blob_t blob, uint8_t flags)
+{
+    fdb_err_t result = FDB_NO_ERR;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    KV_STATS_ADD(db, set_calls, 1);
+    if (blob->buf) {
+        KV_STATS_ADD(db, set_bytes, strlen(key) + blob->size);
+    }
+    result = set_kv(db, key, blob->buf, blob->size, flags);
 
     /* unlock the KV cache */
     db_unlock(db);
 
     return result;
 }
+#endif /* FDB_KV_USING_COMPRESS */
 
 /**
  * Set a string KV. If it value is NULL, delete it.
@@ -1400,26 +1845,686 @@ fdb_err_t fdb_kv_set(fdb_kvdb_t db, const char *key, const char *value)
     }
 }
 
+#if (FDB_WRITE_GRAN <= 32)
 /**
- * recovery all KV to default.
+ * Begin to write a KV by streaming, the value is written by fdb_kv_write_data in pieces,
+ * so the caller doesn't need to hold the whole value in RAM.
+ *
+ * The KV space and header are reserved here. The KV header CRC32 is left erased, it will be
+ * programmed by fdb_kv_write_finish after all value is written. The KV stays in FDB_KV_PRE_WRITE
+ * status until then, so the old KV (when exists) is still valid and it will be dropped by the
+ * recovery check when power failed.
+ *
+ * @note NO other write operation of the database is allowed until the writer is finished or aborted.
  *
  * @param db database object
+ * @param key KV name
+ * @param value_len the whole value length
+ * @param writer the writer object
+ *
  * @return result
  */
-fdb_err_t fdb_kv_set_default(fdb_kvdb_t db)
+fdb_err_t fdb_kv_write_begin(fdb_kvdb_t db, const char *key, size_t value_len, struct fdb_kv_writer *writer)
 {
     fdb_err_t result = FDB_NO_ERR;
-    uint32_t addr, i, value_len;
-    struct kvdb_sec_info sector;
+    struct kv_hdr_data kv_hdr;
+    uint8_t ff = FDB_BYTE_ERASED;
+    size_t align_remain;
 
-    /* lock the KV cache */
-    db_lock(db);
+    FDB_ASSERT(key);
+    FDB_ASSERT(writer);
 
-#ifdef FDB_KV_USING_CACHE
-    for (i = 0; i < FDB_KV_CACHE_TABLE_SIZE; i++) {
-        db->kv_cache_table[i].addr = FDB_DATA_UNUSED;
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
     }
-#endif /* FDB_KV_USING_CACHE */
+
+    memset(writer, 0, sizeof(struct fdb_kv_writer));
+    writer->addr = FAILED_ADDR;
+    writer->name_len = strlen(key);
+    if (writer->name_len > FDB_KV_NAME_MAX) {
+        FDB_INFO("Error: The KV name length is more than %d\n", FDB_KV_NAME_MAX);
+        return FDB_KV_NAME_ERR;
+    }
+    if (kv_name_is_reserved(db, key)) {
+        return FDB_KV_NAME_ERR;
+    }
+    memcpy(writer->name, key, writer->name_len);
+    writer->value_len = value_len;
+    writer->len = KV_HDR_DATA_SIZE + FDB_WG_ALIGN(writer->name_len) + FDB_WG_ALIGN(value_len);
+    if (writer->len > db_sec_size(db) - SECTOR_HDR_DATA_SIZE) {
+        FDB_INFO("Error: The KV size is too big\n");
+        return FDB_SAVED_FULL;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    /* the GC maybe triggered */
+    if ((writer->addr = new_kv(db, &db->cur_sector, writer->len)) == FAILED_ADDR) {
+        result = FDB_SAVED_FULL;
+        goto __exit;
+    }
+
+    memset(&kv_hdr, FDB_BYTE_ERASED, sizeof(struct kv_hdr_data));
+    kv_hdr.magic = KV_MAGIC_WORD;
+    kv_hdr.name_len = writer->name_len;
+    kv_hdr.value_len = value_len;
+    kv_hdr.len = writer->len;
+    /* CRC32(header.name_len + header.value_len + name + value), the value part is calculated when writing */
+    writer->crc32 = fdb_calc_crc32(0, &kv_hdr.name_len, sizeof(uint32_t));
+    writer->crc32 = fdb_calc_crc32(writer->crc32, &kv_hdr.value_len, sizeof(uint32_t));
+    writer->crc32 = fdb_calc_crc32(writer->crc32, key, writer->name_len);
+    align_remain = FDB_WG_ALIGN(writer->name_len) - writer->name_len;
+    while (align_remain--) {
+        writer->crc32 = fdb_calc_crc32(writer->crc32, &ff, 1);
+    }
+
+    result = update_sec_status(db, &db->cur_sector, writer->len, &writer->is_full);
+    /* write KV header without CRC32 and name */
+    if (result == FDB_NO_ERR) {
+        result = write_kv_hdr(db, writer->addr, &kv_hdr);
+    }
+    if (result == FDB_NO_ERR) {
+        result = align_write(db, writer->addr + KV_HDR_DATA_SIZE, (uint32_t *) key, writer->name_len);
+    }
+#ifdef FDB_KV_USING_CACHE
+    if (result == FDB_NO_ERR && !writer->is_full) {
+        update_sector_empty_addr_cache(db, db->cur_sector.addr, writer->addr + writer->len);
+    }
+#endif /* FDB_KV_USING_CACHE */
+
+__exit:
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Write a piece of value to the KV which is begun by fdb_kv_write_begin.
+ *
+ * @param db database object
+ * @param writer the writer object
+ * @param buf value buffer
+ * @param size value buffer size, the total written size MUST NOT more than the value length
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_write_data(fdb_kvdb_t db, struct fdb_kv_writer *writer, const void *buf, size_t size)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    const uint8_t *data = buf;
+    uint32_t value_addr;
+    size_t aligned;
+
+    FDB_ASSERT(writer);
+
+    if (writer->addr == FAILED_ADDR || size > writer->value_len - writer->written) {
+        return FDB_WRITE_ERR;
+    }
+    value_addr = writer->addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(writer->name_len);
+    writer->crc32 = fdb_calc_crc32(writer->crc32, buf, size);
+
+    /* lock the KV cache */
+    db_lock(db);
+
+#if (FDB_WRITE_GRAN / 8 > 1)
+    {
+        /* fill the not aligned tail of the last piece first */
+        size_t pending = writer->written - FDB_WG_ALIGN_DOWN(writer->written), fill;
+        if (pending) {
+            fill = sizeof(writer->tail) - pending < size ? sizeof(writer->tail) - pending : size;
+            memcpy(writer->tail + pending, data, fill);
+            data += fill;
+            size -= fill;
+            writer->written += fill;
+            if (pending + fill == sizeof(writer->tail)) {
+                result = _fdb_flash_write((fdb_db_t) db, value_addr + writer->written - sizeof(writer->tail),
+                        (uint32_t *) writer->tail, sizeof(writer->tail), false);
+            }
+        }
+    }
+#endif
+    aligned = FDB_WG_ALIGN_DOWN(size);
+    if (result == FDB_NO_ERR && aligned) {
+        result = _fdb_flash_write((fdb_db_t) db, value_addr + writer->written, data, aligned, false);
+        writer->written += aligned;
+    }
+#if (FDB_WRITE_GRAN / 8 > 1)
+    if (result == FDB_NO_ERR && size > aligned) {
+        memcpy(writer->tail, data + aligned, size - aligned);
+        writer->written += size - aligned;
+    }
+#endif
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Finish the KV writing. The CRC32 is programmed and the KV status is changed to FDB_KV_WRITE,
+ * then the old KV is deleted.
+ *
+ * @param db database object
+ * @param writer the writer object, all value MUST be written
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_write_finish(fdb_kvdb_t db, struct fdb_kv_writer *writer)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint8_t status_table[KV_STATUS_TABLE_SIZE], ff = FDB_BYTE_ERASED;
+    size_t align_remain;
+    bool kv_is_found;
+
+    FDB_ASSERT(writer);
+
+    if (writer->addr == FAILED_ADDR || writer->written != writer->value_len) {
+        return FDB_WRITE_ERR;
+    }
+    align_remain = FDB_WG_ALIGN(writer->value_len) - writer->value_len;
+    while (align_remain--) {
+        writer->crc32 = fdb_calc_crc32(writer->crc32, &ff, 1);
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    KV_STATS_ADD(db, set_calls, 1);
+    KV_STATS_ADD(db, set_bytes, writer->name_len + writer->value_len);
+
+#if (FDB_WRITE_GRAN / 8 > 1)
+    if (writer->written != FDB_WG_ALIGN_DOWN(writer->written)) {
+        align_remain = writer->written - FDB_WG_ALIGN_DOWN(writer->written);
+        memset(writer->tail + align_remain, FDB_BYTE_ERASED, sizeof(writer->tail) - align_remain);
+        result = _fdb_flash_write((fdb_db_t) db, writer->addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(writer->name_len)
+                + FDB_WG_ALIGN_DOWN(writer->written), (uint32_t *) writer->tail, sizeof(writer->tail), false);
+    }
+#endif
+    /* prepare to delete the old KV */
+    kv_is_found = find_kv(db, writer->name, &db->cur_kv);
+    if (result == FDB_NO_ERR && kv_is_found) {
+        result = del_kv(db, writer->name, &db->cur_kv, false);
+    }
+    /* the KV is valid after the CRC32 is programmed, and it's committed by the status */
+    if (result == FDB_NO_ERR) {
+        result = _fdb_flash_write((fdb_db_t) db, writer->addr + KV_CRC32_OFFSET, &writer->crc32, sizeof(uint32_t), false);
+    }
+    if (result == FDB_NO_ERR) {
+        result = _fdb_write_status((fdb_db_t) db, writer->addr, status_table, FDB_KV_STATUS_NUM, FDB_KV_WRITE, true);
+    }
+    if (result == FDB_NO_ERR) {
+#ifdef FDB_KV_USING_CACHE
+        update_kv_cache(db, writer->name, writer->name_len, writer->addr);
+#endif
+#ifdef FDB_KV_USING_INDEX
+        fdb_kv_index_set(db, writer->name, writer->name_len, writer->addr);
+#endif
+    }
+    /* delete the old KV */
+    if (kv_is_found && result == FDB_NO_ERR) {
+        result = del_kv(db, writer->name, &db->cur_kv, true);
+    }
+    writer->addr = FAILED_ADDR;
+    /* trigger GC collect when current sector is full */
+    if (writer->is_full) {
+        FDB_DEBUG("Trigger a GC check after created KV.\n");
+        db->gc_request = true;
+    }
+    gc_after_write(db, writer->len);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Abort the KV writing, the reserved KV is deleted and the old KV is unchanged.
+ *
+ * @param db database object
+ * @param writer the writer object
+ */
+void fdb_kv_write_abort(fdb_kvdb_t db, struct fdb_kv_writer *writer)
+{
+    uint8_t status_table[KV_STATUS_TABLE_SIZE];
+
+    FDB_ASSERT(writer);
+
+    if (writer->addr == FAILED_ADDR) {
+        return;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    if (_fdb_write_status((fdb_db_t) db, writer->addr, status_table, FDB_KV_STATUS_NUM, FDB_KV_DELETED, true) == FDB_NO_ERR) {
+        mark_sec_dirty(db, writer->addr, true);
+    }
+    writer->addr = FAILED_ADDR;
+    if (writer->is_full) {
+        db->gc_request = true;
+    }
+
+    /* unlock the KV cache */
+    db_unlock(db);
+}
+#endif /* FDB_WRITE_GRAN <= 32 */
+
+/*
+ * check the KV is a batch header KV, and read the batch data when it is.
+ */
+static bool read_batch_data(fdb_kvdb_t db, fdb_kv_t kv, struct kv_batch_data *batch)
+{
+    if (!kv->crc_is_ok || kv->name_len != sizeof(BATCH_KV_NAME) - 1 || kv->value_len != sizeof(struct kv_batch_data)
+            || strncmp(kv->name, BATCH_KV_NAME, kv->name_len)) {
+        return false;
+    }
+    _fdb_flash_read((fdb_db_t)db, kv->addr.value, (uint32_t *)batch, sizeof(struct kv_batch_data));
+    /* the whole batch MUST be in the sector of header KV */
+    return batch->magic == BATCH_MAGIC_WORD && batch->len >= kv->len
+            && kv->addr.start + batch->len <= FDB_ALIGN_DOWN(kv->addr.start, db_sec_size(db)) + db_sec_size(db);
+}
+
+/*
+ * read the batch member KV on kv->addr.start, it will return false when the member has NOT been written.
+ */
+static bool read_batch_member(fdb_kvdb_t db, fdb_kv_t kv, uint32_t end)
+{
+    uint8_t status_table[KV_STATUS_TABLE_SIZE];
+
+    /* the unused member MUST NOT be read by read_kv, it will be set to ERR_HDR */
+    if (kv->addr.start >= end
+            || _fdb_read_status((fdb_db_t)db, kv->addr.start, status_table, FDB_KV_STATUS_NUM) == FDB_KV_UNUSED) {
+        return false;
+    }
+    read_kv(db, kv);
+
+    return true;
+}
+
+/*
+ * roll back an uncommitted batch: delete all member KVs which are written, then set the header KV to ERR_HDR.
+ * The old KVs are NOT changed before the batch is committed.
+ */
+static void batch_rollback(fdb_kvdb_t db, uint32_t batch_addr, uint32_t hdr_len, uint32_t batch_len)
+{
+    uint8_t status_table[KV_STATUS_TABLE_SIZE];
+    struct fdb_kv kv;
+
+    if (_fdb_read_status((fdb_db_t)db, batch_addr, status_table, FDB_KV_STATUS_NUM) == FDB_KV_UNUSED) {
+        /* nothing has been written */
+        return;
+    }
+    for (kv.addr.start = batch_addr + hdr_len; read_batch_member(db, &kv, batch_addr + batch_len);
+            kv.addr.start += kv.len) {
+        if (kv.crc_is_ok && kv.status == FDB_KV_WRITE) {
+            /* the cache and index still point to the old KV */
+            db->last_is_complete_del = true;
+            del_kv_ex(db, NULL, &kv, true, false);
+        } else {
+            /* the member KV has not write finish, so the rest members are NOT written */
+            if (kv.status != FDB_KV_ERR_HDR) {
+                _fdb_write_status((fdb_db_t)db, kv.addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_ERR_HDR, false);
+            }
+            break;
+        }
+    }
+    _fdb_write_status((fdb_db_t)db, batch_addr, status_table, FDB_KV_STATUS_NUM, FDB_KV_ERR_HDR, true);
+}
+
+struct batch_roll_forward_cb_args {
+    fdb_kvdb_t db;
+    uint32_t start;                              /**< batch start address, it's the header KV address */
+    uint32_t members;                            /**< the first member KV address */
+    uint32_t end;                                /**< batch end address */
+};
+
+static bool batch_roll_forward_cb(fdb_kv_t kv, void *arg1, void *arg2)
+{
+    struct batch_roll_forward_cb_args *arg = arg1;
+    struct fdb_kv member;
+
+    if (!kv->crc_is_ok || (kv->status != FDB_KV_WRITE && kv->status != FDB_KV_PRE_DELETE)
+            || (kv->addr.start >= arg->start && kv->addr.start < arg->end)) {
+        return false;
+    }
+    /* delete the KV when it has the same name with a batch member */
+    for (member.addr.start = arg->members; read_batch_member(arg->db, &member, arg->end);
+            member.addr.start += member.len) {
+        if (member.crc_is_ok && member.status == FDB_KV_WRITE && member.name_len == kv->name_len
+                && !strncmp(member.name, kv->name, kv->name_len)) {
+            /* the cache and index will point to the member KV */
+            arg->db->last_is_complete_del = true;
+            del_kv_ex(arg->db, NULL, kv, true, false);
+            break;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * roll forward a committed batch: delete the old KVs of all members, then delete the header KV.
+ */
+static void batch_roll_forward(fdb_kvdb_t db, fdb_kv_t batch_kv, const struct kv_batch_data *batch)
+{
+    struct batch_roll_forward_cb_args arg = { db, batch_kv->addr.start, batch_kv->addr.start + batch_kv->len,
+            batch_kv->addr.start + batch->len };
+    struct fdb_kv kv;
+
+    kv_iterator(db, &kv, &arg, NULL, batch_roll_forward_cb);
+    del_kv(db, NULL, batch_kv, true);
+}
+
+struct batch_find_old_cb_args {
+    const char *key;
+    uint32_t start;                              /**< batch start address */
+    uint32_t end;                                /**< batch end address */
+    bool find_ok;
+};
+
+static bool batch_find_old_cb(fdb_kv_t kv, void *arg1, void *arg2)
+{
+    struct batch_find_old_cb_args *arg = arg1;
+
+    if (kv->addr.start >= arg->start && kv->addr.start < arg->end) {
+        return false;
+    }
+    return find_kv_cb(kv, (void *)arg->key, &arg->find_ok);
+}
+
+/*
+ * find the old KV of a committed batch member, which is NOT in the batch.
+ * It MUST be called before the member KV is put into the cache and index, they still point to the old KV.
+ */
+static bool batch_find_old_kv(fdb_kvdb_t db, const char *key, fdb_kv_t kv, uint32_t start, uint32_t end)
+{
+    struct batch_find_old_cb_args arg = { key, start, end, false };
+
+    if (!find_kv(db, key, kv)) {
+        return false;
+    }
+    if (kv->addr.start < start || kv->addr.start >= end) {
+        return true;
+    }
+    /* the member KV is found by searching the flash, search it again without the batch */
+    kv_iterator(db, kv, &arg, NULL, batch_find_old_cb);
+
+    return arg.find_ok;
+}
+
+/**
+ * Set multiple KVs as an atomic batch. Either all or none of them are changed after a power failure.
+ *
+ * The space of the whole batch is allocated once, all KVs are written contiguously in one sector behind a
+ * batch header KV, and the batch is committed by the header status with only one sync. So the batch total
+ * size (about KV header + name + value of every item) MUST be less than a sector.
+ *
+ * @param db database object
+ * @param items batch items, the key MUST be different and the value MUST NOT be NULL. The items are NOT changed.
+ * @param count item count
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_set_batch(fdb_kvdb_t db, struct fdb_kv_batch_item *items, size_t count)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct kv_hdr_data kv_hdr, member_hdr;
+    struct kv_batch_data batch;
+    struct fdb_kv kv;
+    size_t i, j, name_len, last_old = count;
+    uint32_t batch_addr, kv_addr, hdr_len, total_len;
+    bool is_full = false;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+    if (count == 0) {
+        return FDB_NO_ERR;
+    }
+
+    /* check all items and calculate the batch total length */
+    hdr_len = KV_HDR_DATA_SIZE + FDB_WG_ALIGN(sizeof(BATCH_KV_NAME) - 1) + FDB_WG_ALIGN(sizeof(struct kv_batch_data));
+    total_len = hdr_len;
+    for (i = 0; i < count; i++) {
+        if (items[i].key == NULL || items[i].value == NULL) {
+            return FDB_KV_NAME_ERR;
+        }
+        name_len = strlen(items[i].key);
+        if (name_len > FDB_KV_NAME_MAX) {
+            FDB_INFO("Error: The KV name (%s) is invalid for batch\n", items[i].key);
+            return FDB_KV_NAME_ERR;
+        }
+        if (kv_name_is_reserved(db, items[i].key)) {
+            return FDB_KV_NAME_ERR;
+        }
+        for (j = 0; j < i; j++) {
+            if (!strcmp(items[i].key, items[j].key)) {
+                FDB_INFO("Error: The KV name (%s) is duplicated in batch\n", items[i].key);
+                return FDB_KV_NAME_EXIST;
+            }
+        }
+        total_len += KV_HDR_DATA_SIZE + FDB_WG_ALIGN(name_len) + FDB_WG_ALIGN(items[i].value_len);
+        if (total_len > db_sec_size(db) - SECTOR_HDR_DATA_SIZE) {
+            FDB_INFO("Error: The batch size is too big\n");
+            return FDB_SAVED_FULL;
+        }
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    KV_STATS_ADD(db, set_calls, 1);
+#ifdef FDB_USING_STATS
+    for (i = 0; i < count; i++) {
+        KV_STATS_ADD(db, set_bytes, strlen(items[i].key) + items[i].value_len);
+    }
+#endif
+
+    /* alloc the space of whole batch, the GC maybe triggered */
+    if ((batch_addr = new_kv(db, &db->cur_sector, total_len)) == FAILED_ADDR) {
+        result = FDB_SAVED_FULL;
+        goto __exit;
+    }
+    /* find the last item which has an old KV after GC, its deletion will be synced. No more GC until the batch is finished */
+    for (i = 0; i < count; i++) {
+        if (find_kv(db, items[i].key, &kv)) {
+            last_old = i;
+        }
+    }
+
+    result = update_sec_status(db, &db->cur_sector, total_len, &is_full);
+    /* write the batch header KV, its status keeps PRE_WRITE until the batch is committed */
+    if (result == FDB_NO_ERR) {
+        batch.magic = BATCH_MAGIC_WORD;
+        batch.count = count;
+        batch.len = total_len;
+        memset(&kv_hdr, FDB_BYTE_ERASED, sizeof(struct kv_hdr_data));
+        kv_hdr.magic = KV_MAGIC_WORD;
+        kv_hdr.name_len = sizeof(BATCH_KV_NAME) - 1;
+        kv_hdr.value_len = sizeof(struct kv_batch_data);
+        kv_hdr.len = hdr_len;
+        result = write_kv_body(db, batch_addr, &kv_hdr, BATCH_KV_NAME, &batch);
+    }
+    /* write all member KVs behind the header without sync */
+    for (i = 0, kv_addr = batch_addr + hdr_len; result == FDB_NO_ERR && i < count; i++) {
+        memset(&member_hdr, FDB_BYTE_ERASED, sizeof(struct kv_hdr_data));
+        member_hdr.magic = KV_MAGIC_WORD;
+        member_hdr.name_len = strlen(items[i].key);
+        member_hdr.value_len = items[i].value_len;
+        member_hdr.len = KV_HDR_DATA_SIZE + FDB_WG_ALIGN(member_hdr.name_len) + FDB_WG_ALIGN(member_hdr.value_len);
+#ifdef FDB_KV_USING_COMPRESS
+        member_hdr.name_len |= items[i].flags & FDB_KV_FLAG_MASK;
+#endif
+        result = write_kv_body(db, kv_addr, &member_hdr, items[i].key, items[i].value);
+        if (result == FDB_NO_ERR) {
+            result = _fdb_write_status((fdb_db_t) db, kv_addr, member_hdr.status_table, FDB_KV_STATUS_NUM,
+                    FDB_KV_WRITE, false);
+        }
+        kv_addr += member_hdr.len;
+    }
+    /* commit the batch, the header status changing is the only sync point */
+    if (result == FDB_NO_ERR) {
+        result = _fdb_write_status((fdb_db_t) db, batch_addr, kv_hdr.status_table, FDB_KV_STATUS_NUM, FDB_KV_WRITE,
+                true);
+    }
+    if (result != FDB_NO_ERR) {
+        FDB_INFO("Error: Write the batch failed, now will roll back it.\n");
+        batch_rollback(db, batch_addr, hdr_len, total_len);
+        goto __exit;
+    }
+
+#ifdef FDB_KV_USING_CACHE
+    if (!is_full) {
+        update_sector_empty_addr_cache(db, db->cur_sector.addr, batch_addr + total_len);
+    }
+#endif
+    /* the batch is committed, delete the old KVs and point the cache and index to the member KVs.
+     * The deletion will be redone by recovery check when power failed, the last old KV deletion is synced
+     * before the header is deleted. */
+    for (i = 0, kv_addr = batch_addr + hdr_len; i < count; i++) {
+        name_len = strlen(items[i].key);
+        if (result == FDB_NO_ERR && batch_find_old_kv(db, items[i].key, &kv, batch_addr, batch_addr + total_len)) {
+            /* keep the cache which will be pointed to the member KV */
+            db->last_is_complete_del = true;
+            result = del_kv_ex(db, items[i].key, &kv, true, i == last_old);
+        }
+#ifdef FDB_KV_USING_CACHE
+        update_kv_cache(db, items[i].key, name_len, kv_addr);
+#endif
+#ifdef FDB_KV_USING_INDEX
+        fdb_kv_index_set(db, items[i].key, name_len, kv_addr);
+#endif
+        kv_addr += KV_HDR_DATA_SIZE + FDB_WG_ALIGN(name_len) + FDB_WG_ALIGN(items[i].value_len);
+    }
+    kv.addr.start = batch_addr;
+    read_kv(db, &kv);
+    if (result == FDB_NO_ERR) {
+        result = del_kv_ex(db, NULL, &kv, true, false);
+    } else if (kv.status == FDB_KV_WRITE || kv.status == FDB_KV_PRE_DELETE) {
+        FDB_INFO("Error: Delete the old KVs of batch failed, now will roll forward it again.\n");
+        batch_roll_forward(db, &kv, &batch);
+    }
+    if (result != FDB_NO_ERR) {
+        uint8_t status_table[KV_STATUS_TABLE_SIZE];
+        /* the header KV MUST NOT be left alive, it's only valid at the commit time */
+        if (_fdb_read_status((fdb_db_t)db, batch_addr, status_table, FDB_KV_STATUS_NUM) < FDB_KV_DELETED) {
+            _fdb_write_status((fdb_db_t)db, batch_addr, status_table, FDB_KV_STATUS_NUM, FDB_KV_ERR_HDR, true);
+        }
+    }
+    /* trigger GC collect when current sector is full */
+    if (is_full) {
+        FDB_DEBUG("Trigger a GC check after set batch.\n");
+        db->gc_request = true;
+    }
+    gc_after_write(db, total_len);
+
+__exit:
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Run an incremental GC step. It moves at most `budget` KVs out of the collecting sector,
+ * so the pause is bounded. A new sector is collected only when the empty sectors are not enough.
+ *
+ * @param db database object
+ * @param budget the max KV number to move, it MUST be more than 0
+ * @param pending the GC has more work after this step, it can be NULL
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_gc_step(fdb_kvdb_t db, size_t budget, bool *pending)
+{
+    bool has_pending;
+
+    FDB_ASSERT(budget > 0);
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+    /* lock the KV cache */
+    db_lock(db);
+
+    has_pending = gc_step(db, budget);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    if (pending) {
+        *pending = has_pending;
+    }
+
+    return FDB_NO_ERR;
+}
+
+/**
+ * Get the GC pressure of the database.
+ * The GC is falling behind when the empty sector number is NOT more than the threshold and it has dirty sectors.
+ * The threshold is the one of the incremental GC, @see FDB_GC_STEP_EMPTY_SEC_THRESHOLD, the GC steps keep
+ * collecting until the empty sector number is more than it.
+ *
+ * @param db database object
+ * @param pressure the GC pressure
+ */
+void fdb_kv_gc_pressure(fdb_kvdb_t db, struct fdb_kv_gc_pressure *pressure)
+{
+    struct gc_stat_cb_args stat = { 0, 0, FAILED_ADDR, FAILED_ADDR };
+    struct kvdb_sec_info sector;
+
+    FDB_ASSERT(pressure);
+
+    memset(pressure, 0, sizeof(struct fdb_kv_gc_pressure));
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &stat, NULL, gc_stat_cb, false);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    pressure->empty_sec = stat.empty_sec;
+    pressure->dirty_sec = stat.dirty_sec;
+    pressure->threshold = FDB_GC_STEP_EMPTY_SEC_THRESHOLD;
+    pressure->in_progress = stat.gc_sec_addr != FAILED_ADDR;
+}
+
+/**
+ * recovery all KV to default.
+ *
+ * @param db database object
+ * @return result
+ */
+fdb_err_t fdb_kv_set_default(fdb_kvdb_t db)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint32_t addr, i, value_len;
+    struct kvdb_sec_info sector;
+
+    /* lock the KV cache */
+    db_lock(db);
+
+#ifdef FDB_KV_USING_CACHE
+    for (i = 0; i < FDB_KV_CACHE_TABLE_SIZE; i++) {
+        db->kv_cache_table[i].addr = FDB_DATA_UNUSED;
+    }
+#endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX
+    fdb_kv_index_clear(db);
+#endif /* FDB_KV_USING_INDEX */
 
     /* format all sectors */
     for (addr = 0; addr < db_max_size(db); addr += db_sec_size(db)) {
@@ -1438,7 +2543,7 @@ fdb_err_t fdb_kv_set_default(fdb_kvdb_t db)
             value_len = db->default_kvs.kvs[i].value_len;
         }
         sector.empty_kv = FAILED_ADDR;
-        create_kv_blob(db, &sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value, value_len);
+        create_kv_blob(db, &sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value, value_len, 0);
         if (result != FDB_NO_ERR) {
             goto __exit;
         }
@@ -1553,7 +2658,7 @@ static void kv_auto_update(fdb_kvdb_t db)
                         value_len = db->default_kvs.kvs[i].value_len;
                     }
                     db->cur_sector.empty_kv = FAILED_ADDR;
-                    create_kv_blob(db, &db->cur_sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value, value_len);
+                    create_kv_blob(db, &db->cur_sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value, value_len, 0);
                 }
             }
         } else {
@@ -1562,7 +2667,7 @@ static void kv_auto_update(fdb_kvdb_t db)
         }
     }
 
-    set_kv(db, VER_NUM_KV_NAME, &setting_ver_num, sizeof(size_t));
+    set_kv(db, VER_NUM_KV_NAME, &setting_ver_num, sizeof(size_t), 0);
 }
 #endif /* FDB_KV_AUTO_UPDATE */
 
@@ -1618,15 +2723,26 @@ static bool check_and_recovery_gc_cb(kv_sec_info_t sector, void *arg1, void *arg
 static bool check_and_recovery_kv_cb(fdb_kv_t kv, void *arg1, void *arg2)
 {
     fdb_kvdb_t db = arg1;
-
-    /* recovery the prepare deleted KV */
-    if (kv->crc_is_ok && kv->status == FDB_KV_PRE_DELETE) {
+    bool *interrupted = arg2;
+    struct kv_batch_data batch;
+
+    /* recovery the batch which is interrupted */
+    if (read_batch_data(db, kv, &batch) && (kv->status == FDB_KV_PRE_WRITE || kv->status == FDB_KV_WRITE)) {
+        if (kv->status == FDB_KV_PRE_WRITE) {
+            FDB_INFO("Found an uncommitted KV batch (count %" PRIu32 "). Now will roll back it.\n", batch.count);
+            batch_rollback(db, kv->addr.start, kv->len, batch.len);
+        } else {
+            FDB_INFO("Found a committed KV batch (count %" PRIu32 "). Now will roll forward it.\n", batch.count);
+            batch_roll_forward(db, kv, &batch);
+        }
+    } else if (kv->crc_is_ok && kv->status == FDB_KV_PRE_DELETE) {
         FDB_INFO("Found an KV (%.*s) which has changed value failed. Now will recovery it.\n", kv->name_len, kv->name);
         /* recovery the old KV */
         if (move_kv(db, kv) == FDB_NO_ERR) {
             FDB_DEBUG("Recovery the KV successful.\n");
         } else {
             FDB_DEBUG("Warning: Moved an KV (size %" PRIu32 ") failed when recovery. Now will GC then retry.\n", kv->len);
+            *interrupted = true;
             return true;
         }
     } else if (kv->status == FDB_KV_PRE_WRITE) {
@@ -1634,16 +2750,33 @@ static bool check_and_recovery_kv_cb(fdb_kv_t kv, void *arg1, void *arg2)
         /* the KV has not write finish, change the status to error */
         //TODO Draw the state replacement diagram of exception handling
         _fdb_write_status((fdb_db_t)db, kv->addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_ERR_HDR, true);
+        *interrupted = true;
         return true;
     } else if (kv->crc_is_ok && kv->status == FDB_KV_WRITE) {
 #ifdef FDB_KV_USING_CACHE
         /* update the cache when first load. If caching is disabled, this step is not performed */
         update_kv_cache(db, kv->name, kv->name_len, kv->addr.start);
 #endif
+#ifdef FDB_KV_USING_INDEX
+        fdb_kv_index_set(db, kv->name, kv->name_len, kv->addr.start);
+#endif
+    }
+
+    return false;
+}
+
+#ifdef FDB_KV_USING_INDEX
+static bool build_kv_index_cb(fdb_kv_t kv, void *arg1, void *arg2)
+{
+    fdb_kvdb_t db = arg1;
+
+    if (kv->crc_is_ok && kv->status == FDB_KV_WRITE) {
+        fdb_kv_index_set(db, kv->name, kv->name_len, kv->addr.start);
     }
 
     return false;
 }
+#endif /* FDB_KV_USING_INDEX */
 
 /**
  * Check and load the flash KV.
@@ -1656,8 +2789,14 @@ static fdb_err_t _fdb_kv_load(fdb_kvdb_t db)
     struct fdb_kv kv;
     struct kvdb_sec_info sector;
     size_t check_failed_count = 0;
+    bool check_interrupted;
 
     db->in_recovery_check = true;
+#ifdef FDB_KV_USING_INDEX
+    /* the index will be rebuilt by the KV check */
+    db->kv_index_ready = false;
+    fdb_kv_index_clear(db);
+#endif
     /* check all sector header */
     sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &check_failed_count, db, check_sec_hdr_cb, false);
     if (db->parent.not_formatable && check_failed_count > 0) {
@@ -1669,22 +2808,201 @@ static fdb_err_t _fdb_kv_load(fdb_kvdb_t db)
         fdb_kv_set_default(db);
     }
 
+#ifdef FDB_KV_USING_INDEX
+    /* the snapshot is only saved after a clean close, so the GC and KV recovery check are NOT needed */
+    if (db->kv_index && check_failed_count == 0 && fdb_kv_index_restore(db)) {
+        FDB_DEBUG("Restored the KV index from snapshot, skip the KV check.\n");
+        db->kv_index_ready = true;
+        db->in_recovery_check = false;
+        return result;
+    }
+#endif /* FDB_KV_USING_INDEX */
+
     /* check all sector header for recovery GC */
     sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, db, NULL, check_and_recovery_gc_cb, false);
 
 __retry:
     /* check all KV for recovery */
-    kv_iterator(db, &kv, db, NULL, check_and_recovery_kv_cb);
+    check_interrupted = false;
+    kv_iterator(db, &kv, db, &check_interrupted, check_and_recovery_kv_cb);
     if (db->gc_request) {
         gc_collect(db);
         goto __retry;
     }
 
+#ifdef FDB_KV_USING_INDEX
+    if (check_interrupted) {
+        /* the KV check is interrupted by recovery, some KV may not be indexed */
+        kv_iterator(db, &kv, db, NULL, build_kv_index_cb);
+    }
+    db->kv_index_ready = (db->kv_index != NULL);
+#else
+    (void)check_interrupted;
+#endif /* FDB_KV_USING_INDEX */
+
     db->in_recovery_check = false;
 
     return result;
 }
 
+#ifdef FDB_KV_USING_INDEX
+/*
+ * fold the address and status of all KV in the sector into the CRC32, only the KV headers are read.
+ * A deleted KV only changes its own status, so the sector status is not enough to detect it.
+ */
+static uint32_t sector_kv_status_crc(fdb_kvdb_t db, uint32_t sec_addr, uint32_t crc)
+{
+    struct kv_hdr_data kv_hdr;
+    uint32_t addr = sec_addr + SECTOR_HDR_DATA_SIZE, end = sec_addr + db_sec_size(db), info[2];
+
+    while (addr != FAILED_ADDR && addr + KV_HDR_DATA_SIZE <= end) {
+        _fdb_flash_read((fdb_db_t)db, addr, (uint32_t *)&kv_hdr, sizeof(struct kv_hdr_data));
+        info[0] = addr;
+        info[1] = _fdb_get_status(kv_hdr.status_table, FDB_KV_STATUS_NUM);
+        if (kv_hdr.magic != KV_MAGIC_WORD) {
+            if (info[1] == FDB_KV_UNUSED) {
+                /* the rest space of sector is empty */
+                break;
+            }
+            addr = find_next_kv_addr(db, addr + FDB_WG_ALIGN(1), end - SECTOR_HDR_DATA_SIZE);
+            continue;
+        }
+        crc = fdb_calc_crc32(crc, info, sizeof(info));
+        if (kv_hdr.len < KV_HDR_DATA_SIZE || kv_hdr.len > end - addr) {
+            addr = find_next_kv_addr(db, addr + FDB_WG_ALIGN(1), end - SECTOR_HDR_DATA_SIZE);
+        } else {
+            addr += kv_hdr.len;
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * Calculate the fingerprint of the database: the header status of all sectors, the empty KV address of
+ * the using sectors and the status of all KV. Only the sector and KV headers are read.
+ * It's used to validate a saved KV index snapshot before skipping the KV check on load.
+ *
+ * @param db database object
+ *
+ * @return the fingerprint
+ */
+uint32_t fdb_kvdb_sector_fingerprint(fdb_kvdb_t db)
+{
+    struct kvdb_sec_info sector;
+    uint32_t addr, crc = 0, info[5];
+
+    db_lock(db);
+    /* NOT using sector_iterator, the fingerprint should not depend on the oldest address */
+    for (addr = 0; addr < db_max_size(db); addr += db_sec_size(db)) {
+        info[0] = addr;
+        info[1] = FDB_DATA_UNUSED;
+        info[2] = FDB_SECTOR_STORE_UNUSED;
+        info[3] = FDB_SECTOR_DIRTY_UNUSED;
+        info[4] = FAILED_ADDR;
+        if (read_sector_info(db, addr, &sector, false) == FDB_NO_ERR) {
+            info[1] = sector.combined;
+            info[2] = sector.status.store;
+            info[3] = sector.status.dirty;
+            /* the empty KV address will change after each KV created in the using sector */
+            if (sector.status.store == FDB_SECTOR_STORE_USING
+                    && read_sector_info(db, addr, &sector, true) == FDB_NO_ERR) {
+                info[4] = sector.empty_kv;
+            }
+        }
+        crc = fdb_calc_crc32(crc, info, sizeof(info));
+        if (info[2] == FDB_SECTOR_STORE_USING || info[2] == FDB_SECTOR_STORE_FULL) {
+            crc = sector_kv_status_crc(db, addr, crc);
+        }
+    }
+    db_unlock(db);
+
+    return crc;
+}
+
+/**
+ * Read and validate the KV node at the address given by the index.
+ * It only reads the flash through the parent database object and NOT touches the caches or the lock,
+ * so a read-only shadow database object can run it concurrently with the writer.
+ *
+ * @param db database object
+ * @param addr the KV node address
+ * @param key the expected KV name
+ * @param kv the KV object to fill
+ *
+ * @return true: the node is a valid KV with the expected name
+ */
+bool fdb_kv_read_obj(fdb_kvdb_t db, uint32_t addr, const char *key, fdb_kv_t kv)
+{
+    size_t name_len = strlen(key);
+
+    FDB_ASSERT(db);
+    FDB_ASSERT(key);
+    FDB_ASSERT(kv);
+
+    if (addr >= db_max_size(db)) {
+        return false;
+    }
+    kv->addr.start = addr;
+    read_kv(db, kv);
+    /* the PRE_DELETE KV is still the newest one before its replacement is indexed */
+    return kv->crc_is_ok && (kv->status == FDB_KV_WRITE || kv->status == FDB_KV_PRE_DELETE)
+            && kv->name_len == name_len && !strncmp(kv->name, key, name_len);
+}
+#endif /* FDB_KV_USING_INDEX */
+
+#ifdef FDB_KV_USING_PRECHECK
+/**
+ * Verify the CRC32 of all KV in a sector, it's used to verify the sectors in parallel before the database load.
+ * The db is a private read only database object of the caller, only the sector size, max size and the
+ * flash read port of it are used. The database MUST NOT be written during the precheck.
+ *
+ * @param db read only database object
+ * @param sec_addr sector address
+ * @param cb callback for each KV which CRC32 check OK
+ * @param arg callback argument
+ *
+ * @return the KV number which CRC32 check OK
+ */
+size_t fdb_kv_sector_precheck(fdb_kvdb_t db, uint32_t sec_addr,
+        void (*cb)(uint32_t addr, uint32_t len, uint32_t crc32, void *arg), void *arg)
+{
+    struct kvdb_sec_info sector;
+    struct fdb_kv kv;
+    uint32_t crc32;
+    size_t count = 0;
+
+    FDB_ASSERT(db);
+    FDB_ASSERT(cb);
+
+#ifdef FDB_KV_USING_CACHE
+    {
+        size_t i;
+        /* the private database object is NOT initialized, make sure the cache is empty */
+        for (i = 0; i < FDB_SECTOR_CACHE_TABLE_SIZE; i++) {
+            db->sector_cache_table[i].addr = FDB_DATA_UNUSED;
+        }
+    }
+#endif
+    if (sec_addr >= db_max_size(db) || read_sector_info(db, sec_addr, &sector, false) != FDB_NO_ERR) {
+        return 0;
+    }
+    if (sector.status.store != FDB_SECTOR_STORE_USING && sector.status.store != FDB_SECTOR_STORE_FULL) {
+        return 0;
+    }
+    kv.addr.start = sector.addr + SECTOR_HDR_DATA_SIZE;
+    do {
+        if (read_kv(db, &kv) == FDB_NO_ERR && kv.crc_is_ok
+                && _fdb_flash_read((fdb_db_t)db, kv.addr.start + KV_CRC32_OFFSET, &crc32, sizeof(uint32_t)) == FDB_NO_ERR) {
+            cb(kv.addr.start, kv.len, crc32, arg);
+            count++;
+        }
+    } while ((kv.addr.start = get_next_kv_addr(db, &sector, &kv)) != FAILED_ADDR);
+
+    return count;
+}
+#endif /* FDB_KV_USING_PRECHECK */
+
 /**
  * This function will get or set some options of the database
  *
@@ -1746,6 +3064,18 @@ void fdb_kvdb_control(fdb_kvdb_t db, int cmd, void *arg)
         FDB_ASSERT(db->parent.init_ok == false);
         db->parent.not_formatable = *(bool *)arg;
         break;
+    case FDB_KVDB_CTRL_SET_GC_BUDGET:
+        db->gc_budget = *(size_t *)arg;
+        break;
+    case FDB_KVDB_CTRL_GET_GC_BUDGET:
+        *(size_t *)arg = db->gc_budget;
+        break;
+    case FDB_KVDB_CTRL_SET_GC_POLICY:
+        db->gc_policy = *(fdb_kv_gc_policy_t *)arg;
+        break;
+    case FDB_KVDB_CTRL_GET_GC_POLICY:
+        *(fdb_kv_gc_policy_t *)arg = db->gc_policy;
+        break;
     }
 }
 
@@ -49,6 +49,11 @@
 /* the next address is get failed */
 #define FAILED_ADDR                              0xFFFFFFFF
 
+/* the max TSL number of one index block write in batch append */
+#ifndef FDB_TSL_BATCH_IDX_NUM
+#define FDB_TSL_BATCH_IDX_NUM                    16
+#endif
+
 #define db_name(db)                              (((fdb_db_t)db)->name)
 #define db_init_ok(db)                           (((fdb_db_t)db)->init_ok)
 #define db_sec_size(db)                          (((fdb_db_t)db)->sec_size)
@@ -104,6 +109,11 @@ struct query_count_args {
     size_t count;
 };
 
+struct query_summary_args {
+    fdb_tsl_status_t status;
+    struct fdb_tsl_summary *summary;
+};
+
 struct check_sec_hdr_cb_args {
     fdb_tsdb_t db;
     bool check_failed;
@@ -262,6 +272,77 @@ static fdb_err_t read_sector_info(fdb_tsdb_t db, uint32_t addr, tsdb_sec_info_t
     return result;
 }
 
+#ifdef FDB_TSDB_USING_SEC_DIR
+/*
+ * Update the sector directory entry by the sector information.
+ */
+static void sec_dir_update(fdb_tsdb_t db, tsdb_sec_info_t sector)
+{
+    struct tsdb_sec_dir_entry *entry;
+
+    if (db->sec_dir == NULL) {
+        return;
+    }
+
+    entry = &db->sec_dir[sector->addr / db_sec_size(db)];
+    entry->status = sector->status;
+    entry->start_time = sector->start_time;
+    entry->end_time = sector->end_time;
+    entry->end_idx = sector->end_idx;
+    entry->summary_ok = false;
+}
+
+/*
+ * Get the sector address on the position of the iterating order.
+ * The forward order starts from the oldest sector, the reverse order starts from the current using sector.
+ */
+static uint32_t sec_dir_addr(fdb_tsdb_t db, uint32_t start_addr, size_t pos, bool forward)
+{
+    size_t sec_num = db_max_size(db) / db_sec_size(db), start = start_addr / db_sec_size(db);
+
+    if (forward) {
+        return (uint32_t)(((start + pos) % sec_num) * db_sec_size(db));
+    } else {
+        return (uint32_t)(((start + sec_num - pos) % sec_num) * db_sec_size(db));
+    }
+}
+
+/*
+ * Binary search the first sector which the time range iterator will start from.
+ *
+ * The sectors which have TSL are continuous from the start address of the iterating order and their
+ * timestamps are monotonic, so it's the first sector whose end timestamp (forward) or start timestamp
+ * (reverse) reaches the `from`. The iterator stops at the first sector without TSL, so it's also a result.
+ *
+ * @return the position of the sector in the iterating order, it's the sector number when not found
+ */
+static size_t sec_dir_search(fdb_tsdb_t db, uint32_t start_addr, fdb_time_t from, bool forward)
+{
+    size_t low = 0, high = db_max_size(db) / db_sec_size(db);
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        struct tsdb_sec_dir_entry *entry = &db->sec_dir[sec_dir_addr(db, start_addr, mid, forward) / db_sec_size(db)];
+        bool reached = true;
+
+        if (entry->status == FDB_SECTOR_STORE_USING) {
+            /* the current using sector is changed by every append, so it isn't saved in the directory */
+            reached = forward ? from <= db->cur_sec.end_time : from >= db->cur_sec.start_time;
+        } else if (entry->status == FDB_SECTOR_STORE_FULL) {
+            reached = forward ? from <= entry->end_time : from >= entry->start_time;
+        }
+
+        if (reached) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    return low;
+}
+#endif /* FDB_TSDB_USING_SEC_DIR */
+
 static fdb_err_t format_sector(fdb_tsdb_t db, uint32_t addr)
 {
     fdb_err_t result = FDB_NO_ERR;
@@ -275,6 +356,12 @@ static fdb_err_t format_sector(fdb_tsdb_t db, uint32_t addr)
         /* set the magic */
         sec_hdr.magic = SECTOR_MAGIC_WORD;
         FLASH_WRITE(db, addr + SECTOR_MAGIC_OFFSET, &sec_hdr.magic, sizeof(sec_hdr.magic), true);
+#ifdef FDB_TSDB_USING_SEC_DIR
+        if (db->sec_dir) {
+            db->sec_dir[addr / db_sec_size(db)].status = FDB_SECTOR_STORE_EMPTY;
+            db->sec_dir[addr / db_sec_size(db)].summary_ok = false;
+        }
+#endif
     }
 
     return result;
@@ -345,6 +432,9 @@ static fdb_err_t update_sec_status(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_bl
         /* change current sector to full */
         _FDB_WRITE_STATUS(db, cur_sec_addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_FULL, true);
         sector->status = FDB_SECTOR_STORE_FULL;
+#ifdef FDB_TSDB_USING_SEC_DIR
+        sec_dir_update(db, sector);
+#endif
         /* calculate next sector address */
         if (sector->addr + db_sec_size(db) < db_max_size(db)) {
             new_sec_addr = sector->addr + db_sec_size(db);
@@ -378,6 +468,9 @@ static fdb_err_t update_sec_status(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_bl
         _FDB_WRITE_STATUS(db, sector->addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_USING, true);
         /* save the start timestamp */
         FLASH_WRITE(db, sector->addr + SECTOR_START_TIME_OFFSET, (uint32_t *)&cur_time, sizeof(fdb_time_t), true);
+#ifdef FDB_TSDB_USING_SEC_DIR
+        sec_dir_update(db, sector);
+#endif
     }
 
     return result;
@@ -426,6 +519,109 @@ static fdb_err_t tsl_append(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t *timestam
     return result;
 }
 
+/*
+ * Write the TSL nodes which are all fit in the current sector.
+ * The indices are written by one flash write, then the logs, then the status of every index.
+ * Only the last status write requests a sync when the sync is needed.
+ */
+static fdb_err_t write_tsl_batch(fdb_tsdb_t db, struct fdb_tsl_batch_item *items, size_t count, bool sync)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint8_t idx_buf[FDB_TSL_BATCH_IDX_NUM * LOG_IDX_DATA_SIZE], status_table[TSL_STATUS_TABLE_SIZE];
+    struct log_idx_data idx;
+    uint32_t idx_addr = db->cur_sec.empty_idx, log_addr = db->cur_sec.empty_data;
+    size_t i;
+
+    FDB_ASSERT(count <= FDB_TSL_BATCH_IDX_NUM);
+
+    memset(idx_buf, FDB_BYTE_ERASED, sizeof(idx_buf));
+    for (i = 0; i < count; i++) {
+        memset(&idx, FDB_BYTE_ERASED, sizeof(idx));
+        _fdb_set_status(idx.status_table, FDB_TSL_STATUS_NUM, FDB_TSL_PRE_WRITE);
+        idx.time = items[i].time;
+        idx.log_len = items[i].size;
+        /* the logs are placed from the end of sector to the front, same as write_tsl */
+        log_addr -= FDB_WG_ALIGN(items[i].size);
+        idx.log_addr = log_addr;
+        memcpy(idx_buf + i * LOG_IDX_DATA_SIZE, &idx, sizeof(idx));
+    }
+    /* write all indices with the PRE_WRITE status */
+    FLASH_WRITE(db, idx_addr, idx_buf, count * LOG_IDX_DATA_SIZE, false);
+    /* write the logs */
+    for (i = 0, log_addr = db->cur_sec.empty_data; i < count; i++) {
+        log_addr -= FDB_WG_ALIGN(items[i].size);
+        FLASH_WRITE(db, log_addr, items[i].buf, items[i].size, false);
+    }
+    /* commit all nodes, the sync is only needed at the end */
+    for (i = 0; i < count; i++) {
+        _FDB_WRITE_STATUS(db, idx_addr + i * LOG_IDX_DATA_SIZE, status_table, FDB_TSL_STATUS_NUM, FDB_TSL_WRITE,
+                sync && i == count - 1);
+    }
+
+    return result;
+}
+
+static fdb_err_t tsl_append_batch(fdb_tsdb_t db, struct fdb_tsl_batch_item *items, size_t count)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    fdb_time_t last_time = db->last_time;
+    struct fdb_blob blob;
+    size_t i, num, need;
+
+    /* check all logs before writing, so an invalid item will NOT leave a part of the batch */
+    for (i = 0; i < count; i++) {
+        if (items[i].size > db->max_len) {
+            FDB_INFO("Warning: append length (%" PRIdMAX ") is more than the db->max_len (%" PRIdMAX "). This batch will be dropped.\n",
+                    (intmax_t)items[i].size, (intmax_t)(db->max_len));
+            return FDB_WRITE_ERR;
+        }
+        if (items[i].time <= last_time) {
+            FDB_INFO("Warning: timestamp (%" PRIdMAX ") is less than or equal to the previous timestamp (%" PRIdMAX "). This batch will be dropped.\n",
+                    (intmax_t)items[i].time, (intmax_t)last_time);
+            return FDB_WRITE_ERR;
+        }
+        last_time = items[i].time;
+    }
+
+    for (i = 0; i < count; i += num) {
+        /* switch to the next sector when the first node of this block doesn't fit */
+        blob.buf = (void *)items[i].buf;
+        blob.size = items[i].size;
+        result = update_sec_status(db, &db->cur_sec, &blob, items[i].time);
+        if (result != FDB_NO_ERR) {
+            FDB_INFO("Error: update the sector status failed (%d)", result);
+            return result;
+        }
+        /* collect the following nodes which are fit in the current sector */
+        for (num = 0, need = 0; i + num < count && num < FDB_TSL_BATCH_IDX_NUM; num++) {
+            size_t node_size = LOG_IDX_DATA_SIZE + FDB_WG_ALIGN(items[i + num].size);
+            if (need + node_size > db->cur_sec.remain) {
+                break;
+            }
+            need += node_size;
+        }
+        if (num == 0) {
+            return FDB_SAVED_FULL;
+        }
+        /* only sync at the end of batch, the sector switching is synced by itself */
+        result = write_tsl_batch(db, items + i, num, i + num == count);
+        if (result != FDB_NO_ERR) {
+            FDB_INFO("Error: write tsl failed (%d)", result);
+            return result;
+        }
+
+        /* recalculate the current using sector info */
+        db->cur_sec.end_idx = db->cur_sec.empty_idx + (num - 1) * LOG_IDX_DATA_SIZE;
+        db->cur_sec.end_time = items[i + num - 1].time;
+        db->cur_sec.empty_idx += num * LOG_IDX_DATA_SIZE;
+        db->cur_sec.empty_data -= need - num * LOG_IDX_DATA_SIZE;
+        db->cur_sec.remain -= need;
+        db->last_time = items[i + num - 1].time;
+    }
+
+    return result;
+}
+
 /**
  * Append a new log to TSDB.
  *
@@ -474,6 +670,36 @@ fdb_err_t fdb_tsl_append_with_ts(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t time
     return result;
 }
 
+/**
+ * Append a batch of logs to TSDB with specific timestamps.
+ * The nodes in the same sector are written together, and the flash is only synced at the end of batch
+ * (and when switching to the next sector).
+ * All items are checked before writing. When writing failed, the items before the failed one are kept.
+ *
+ * @param db database object
+ * @param items the logs, the timestamps MUST be increasing
+ * @param count the number of items
+ *
+ * @return result
+ */
+fdb_err_t fdb_tsl_append_batch(fdb_tsdb_t db, struct fdb_tsl_batch_item *items, size_t count)
+{
+    fdb_err_t result = FDB_NO_ERR;
+
+    FDB_ASSERT(items || count == 0);
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    db_lock(db);
+    result = tsl_append_batch(db, items, count);
+    db_unlock(db);
+
+    return result;
+}
+
 /**
  * The TSDB iterator for each TSL.
  *
@@ -649,6 +875,18 @@ void fdb_tsl_iter_by_time(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl
 
     sec_addr = start_addr;
     db_lock(db);
+#ifdef FDB_TSDB_USING_SEC_DIR
+    if (db->sec_dir_ready) {
+        /* skip the sectors before the start sector, their header don't need to be read */
+        size_t pos = sec_dir_search(db, start_addr, from, from <= to);
+
+        if (pos >= db_max_size(db) / db_sec_size(db)) {
+            goto __exit;
+        }
+        sec_addr = sec_dir_addr(db, start_addr, pos, from <= to);
+        traversed_len = (uint32_t)(pos * db_sec_size(db));
+    }
+#endif
     /* search all sectors */
     do {
         traversed_len += db_sec_size(db);
@@ -707,6 +945,196 @@ static bool query_count_cb(fdb_tsl_t tsl, void *arg)
     return false;
 }
 
+static bool query_summary_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct query_summary_args *args = arg;
+
+    if (tsl->status == args->status) {
+        if (args->summary->count++ == 0) {
+            args->summary->first = *tsl;
+        }
+        args->summary->last = *tsl;
+    }
+
+    return false;
+}
+
+#ifdef FDB_TSDB_USING_SEC_DIR
+/*
+ * Add the matched TSL from the index address to the end of the sector to the summary.
+ */
+static void summary_scan_sector(fdb_tsdb_t db, tsdb_sec_info_t sector, uint32_t idx_addr, fdb_time_t from, fdb_time_t to,
+        fdb_tsl_status_t status, struct fdb_tsl_summary *summary)
+{
+    struct fdb_tsl tsl;
+
+    if (idx_addr > sector->end_idx) {
+        return;
+    }
+
+    tsl.addr.index = idx_addr;
+    do {
+        read_tsl(db, &tsl);
+        if (tsl.status == FDB_TSL_UNUSED || tsl.time > to) {
+            /* the TSL index is saved in order, so there is no more matched TSL */
+            break;
+        }
+        if (tsl.status == status && tsl.time >= from) {
+            if (summary->count++ == 0) {
+                summary->first = tsl;
+            }
+            summary->last = tsl;
+        }
+    } while ((tsl.addr.index = get_next_tsl_addr(sector, &tsl)) != FAILED_ADDR);
+}
+
+/*
+ * Count the TSL number of each status in the full sector, it's saved to the sector directory.
+ */
+static void sec_dir_count(fdb_tsdb_t db, tsdb_sec_info_t sector, struct tsdb_sec_dir_entry *entry)
+{
+    struct fdb_tsl tsl;
+
+    memset(entry->tsl_num, 0, sizeof(entry->tsl_num));
+    tsl.addr.index = sector->addr + SECTOR_HDR_DATA_SIZE;
+    do {
+        read_tsl(db, &tsl);
+        entry->tsl_num[tsl.status]++;
+    } while ((tsl.addr.index = get_next_tsl_addr(sector, &tsl)) != FAILED_ADDR);
+    entry->summary_ok = true;
+}
+
+/*
+ * Query the TSL summary by the sector directory.
+ *
+ * The full sectors which are fully covered by the time range are summarized by the TSL number of each status,
+ * only the boundary sectors and the current using sector are scanned. The first or last TSL is searched in the
+ * covered sector only when it isn't found in the boundary sectors.
+ */
+static void sec_dir_summary(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_status_t status,
+        struct fdb_tsl_summary *summary)
+{
+    size_t pos, sec_num = db_max_size(db) / db_sec_size(db);
+    struct tsdb_sec_info sector, last_sec;
+    bool last_pending = false, last_all_matched = false;
+
+    for (pos = sec_dir_search(db, db_oldest_addr(db), from, true); pos < sec_num; pos++) {
+        uint32_t addr = sec_dir_addr(db, db_oldest_addr(db), pos, true);
+        struct tsdb_sec_dir_entry *entry = &db->sec_dir[addr / db_sec_size(db)];
+
+        if (entry->status == FDB_SECTOR_STORE_USING) {
+            sector = db->cur_sec;
+        } else if (entry->status == FDB_SECTOR_STORE_FULL) {
+            sector.addr = addr;
+            sector.status = FDB_SECTOR_STORE_FULL;
+            sector.start_time = entry->start_time;
+            sector.end_time = entry->end_time;
+            sector.end_idx = entry->end_idx;
+        } else {
+            break;
+        }
+        if (sector.start_time > to) {
+            break;
+        }
+
+        if (sector.status == FDB_SECTOR_STORE_FULL && from <= sector.start_time && sector.end_time <= to) {
+            /* the sector is fully covered */
+            uint32_t total = (sector.end_idx - sector.addr - SECTOR_HDR_DATA_SIZE) / LOG_IDX_DATA_SIZE + 1;
+
+            if (!entry->summary_ok) {
+                sec_dir_count(db, &sector, entry);
+            }
+            if (entry->tsl_num[status] == 0) {
+                continue;
+            }
+            if (summary->count == 0) {
+                if (entry->tsl_num[status] == total) {
+                    summary->first.addr.index = sector.addr + SECTOR_HDR_DATA_SIZE;
+                    read_tsl(db, &summary->first);
+                } else {
+                    struct fdb_tsl_summary part = { 0 };
+
+                    summary_scan_sector(db, &sector, sector.addr + SECTOR_HDR_DATA_SIZE, from, to, status, &part);
+                    summary->first = part.first;
+                }
+            }
+            summary->count += entry->tsl_num[status];
+            last_sec = sector;
+            last_pending = true;
+            last_all_matched = entry->tsl_num[status] == total;
+        } else {
+            /* the boundary sector */
+            size_t count = summary->count;
+            uint32_t start = sector.addr + SECTOR_HDR_DATA_SIZE;
+
+            if (from > sector.start_time && start <= sector.end_idx) {
+                start = search_start_tsl_addr(db, start, sector.end_idx, from, to);
+            }
+            summary_scan_sector(db, &sector, start, from, to, status, summary);
+            if (summary->count > count) {
+                last_pending = false;
+            }
+        }
+    }
+
+    if (last_pending) {
+        if (last_all_matched) {
+            summary->last.addr.index = last_sec.end_idx;
+            read_tsl(db, &summary->last);
+        } else {
+            struct fdb_tsl_summary part = { 0 };
+
+            summary_scan_sector(db, &last_sec, last_sec.addr + SECTOR_HDR_DATA_SIZE, from, to, status, &part);
+            summary->last = part.last;
+        }
+    }
+}
+#endif /* FDB_TSDB_USING_SEC_DIR */
+
+/**
+ * Query the TSL summary by timestamp and status: the matched TSL count, the first and the last matched TSL.
+ *
+ * @note The full sectors in the time range are summarized by the sector directory when FDB_TSDB_USING_SEC_DIR
+ * is enabled, otherwise all TSL in the time range are iterated.
+ *
+ * @param db database object
+ * @param from starting timestamp
+ * @param to ending timestamp
+ * @param status status
+ * @param summary the query result
+ */
+void fdb_tsl_query_summary(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_status_t status,
+        struct fdb_tsl_summary *summary)
+{
+    struct query_summary_args arg = { status, summary };
+
+    FDB_ASSERT(summary);
+
+    memset(summary, 0, sizeof(struct fdb_tsl_summary));
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
+        return;
+    }
+
+    if (from > to) {
+        fdb_time_t tmp = from;
+        from = to;
+        to = tmp;
+    }
+
+#ifdef FDB_TSDB_USING_SEC_DIR
+    if (db->sec_dir_ready) {
+        db_lock(db);
+        sec_dir_summary(db, from, to, status, summary);
+        db_unlock(db);
+        return;
+    }
+#endif
+
+    fdb_tsl_iter_by_time(db, from, to, query_summary_cb, &arg);
+}
+
 /**
  * Query some TSL's count by timestamp and status.
  *
@@ -726,6 +1154,15 @@ size_t fdb_tsl_query_count(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_ts
         return 0;
     }
 
+#ifdef FDB_TSDB_USING_SEC_DIR
+    if (db->sec_dir_ready) {
+        struct fdb_tsl_summary summary;
+
+        fdb_tsl_query_summary(db, from, to, status, &summary);
+        return summary.count;
+    }
+#endif
+
     fdb_tsl_iter_by_time(db, from, to, query_count_cb, &arg);
 
     return arg.count;
@@ -745,10 +1182,34 @@ fdb_err_t fdb_tsl_set_status(fdb_tsdb_t db, fdb_tsl_t tsl, fdb_tsl_status_t stat
 {
     fdb_err_t result = FDB_NO_ERR;
     uint8_t status_table[TSL_STATUS_TABLE_SIZE];
+#ifdef FDB_TSDB_USING_SEC_DIR
+    struct tsdb_sec_dir_entry *entry = NULL;
+    struct fdb_tsl saved;
+    fdb_tsl_status_t saved_status = FDB_TSL_UNUSED;
+
+    if (db->sec_dir && db->sec_dir[tsl->addr.index / db_sec_size(db)].summary_ok) {
+        /* the status table can't go back, so the saved status is read before and after writing.
+         * The TSL number is invalid until the writing finished, it's counted again when writing failed. */
+        entry = &db->sec_dir[tsl->addr.index / db_sec_size(db)];
+        saved.addr.index = tsl->addr.index;
+        read_tsl(db, &saved);
+        saved_status = saved.status;
+        entry->summary_ok = false;
+    }
+#endif
 
     /* write the status will by write granularity */
     _FDB_WRITE_STATUS(db, tsl->addr.index, status_table, FDB_TSL_STATUS_NUM, status, true);
 
+#ifdef FDB_TSDB_USING_SEC_DIR
+    if (entry) {
+        read_tsl(db, &saved);
+        entry->tsl_num[saved_status]--;
+        entry->tsl_num[saved.status]++;
+        entry->summary_ok = true;
+    }
+#endif
+
     return result;
 }
 
@@ -778,7 +1239,11 @@ static bool check_sec_hdr_cb(tsdb_sec_info_t sector, void *arg1, void *arg2)
         FDB_INFO("Sector (0x%08" PRIX32 ") header info is incorrect.\n", sector->addr);
         (arg->check_failed) = true;
         return true;
-    } else if (sector->status == FDB_SECTOR_STORE_USING) {
+    }
+#ifdef FDB_TSDB_USING_SEC_DIR
+    sec_dir_update(db, sector);
+#endif
+    if (sector->status == FDB_SECTOR_STORE_USING) {
         if (db->cur_sec.addr == FDB_DATA_UNUSED) {
             memcpy(&db->cur_sec, sector, sizeof(struct tsdb_sec_info));
         } else {
@@ -945,6 +1410,14 @@ fdb_err_t fdb_tsdb_init(fdb_tsdb_t db, const char *name, const char *path, fdb_g
     db->cur_sec.addr = FDB_DATA_UNUSED;
     /* must less than sector size */
     FDB_ASSERT(max_len < db_sec_size(db));
+#ifdef FDB_TSDB_USING_SEC_DIR
+    db->sec_dir_ready = false;
+    if (db->sec_dir && db->sec_dir_num < db_max_size(db) / db_sec_size(db)) {
+        FDB_INFO("Warning: the sector directory (%" PRIdMAX ") is less than the sector number, it will be not used.\n",
+                (intmax_t)db->sec_dir_num);
+        db->sec_dir = NULL;
+    }
+#endif
 
     /* check all sector header */
     sector.addr = 0;
@@ -996,6 +1469,10 @@ fdb_err_t fdb_tsdb_init(fdb_tsdb_t db, const char *name, const char *path, fdb_g
         read_sector_info(db, addr, &sec, false);
         db->last_time = sec.end_time;
     }
+#ifdef FDB_TSDB_USING_SEC_DIR
+    /* all sectors are saved in the directory by the sector header check or format */
+    db->sec_dir_ready = db->sec_dir != NULL;
+#endif
 
     /* unlock the TSDB */
     db_unlock(db);
@@ -1017,6 +1494,9 @@ __exit:
 fdb_err_t fdb_tsdb_deinit(fdb_tsdb_t db)
 {
     _fdb_deinit((fdb_db_t) db);
+#ifdef FDB_TSDB_USING_SEC_DIR
+    db->sec_dir_ready = false;
+#endif
 
     return FDB_NO_ERR;
 }
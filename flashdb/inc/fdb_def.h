@@ -52,6 +52,24 @@ extern "C" {
 #define FDB_FILE_CACHE_TABLE_SIZE    2
 #endif
 
+/* the read buffer size when scanning the flash (KV magic word searching and erased region checking),
+ * a larger buffer will reduce the flash read count, it MUST be at least 32 bytes */
+#ifndef FDB_SCAN_BUF_SIZE
+#define FDB_SCAN_BUF_SIZE              32
+#endif
+#if FDB_SCAN_BUF_SIZE < 32
+#error "FDB_SCAN_BUF_SIZE MUST be at least 32 bytes"
+#endif
+
+#ifdef FDB_KV_USING_COMPRESS
+/* the KV flags are saved in the high bit of the header name length, so the name length MUST be less than 128 */
+#if FDB_KV_NAME_MAX >= 128
+#error "FDB_KV_NAME_MAX must be less than 128 when using the KV compress flag"
+#endif
+#define FDB_KV_FLAG_COMPRESSED         0x80     /**< the KV value is compressed by the user */
+#define FDB_KV_FLAG_MASK               0x80
+#endif
+
 #ifndef FDB_WRITE_GRAN
 #define FDB_WRITE_GRAN 1
 #endif
@@ -91,6 +109,10 @@ if (!(EXPR))                                                                  \
 #define FDB_KVDB_CTRL_SET_FILE_MODE    0x09             /**< set file mode control command, this change MUST before database initialization */
 #define FDB_KVDB_CTRL_SET_MAX_SIZE     0x0A             /**< set database max size in file mode control command, this change MUST before database initialization */
 #define FDB_KVDB_CTRL_SET_NOT_FORMAT   0x0B             /**< set database NOT format mode control command, this change MUST before database initialization */
+#define FDB_KVDB_CTRL_SET_GC_BUDGET    0x0C             /**< set the incremental GC budget (moved KV number per write) control command, 0 is disabled */
+#define FDB_KVDB_CTRL_GET_GC_BUDGET    0x0D             /**< get the incremental GC budget control command */
+#define FDB_KVDB_CTRL_SET_GC_POLICY    0x0E             /**< set the GC victim policy control command, @see fdb_kv_gc_policy_t */
+#define FDB_KVDB_CTRL_GET_GC_POLICY    0x0F             /**< get the GC victim policy control command */
 
 #define FDB_TSDB_CTRL_SET_SEC_SIZE     0x00             /**< set sector size control command, this change MUST before database initialization */
 #define FDB_TSDB_CTRL_GET_SEC_SIZE     0x01             /**< get sector size control command */
@@ -122,6 +144,55 @@ struct fdb_default_kv {
     size_t num;
 };
 
+/* the item of KV batch, @see fdb_kv_set_batch */
+struct fdb_kv_batch_item {
+    const char *key;                             /**< KV name */
+    const void *value;                           /**< KV value */
+    size_t value_len;                            /**< KV value length */
+#ifdef FDB_KV_USING_COMPRESS
+    uint8_t flags;                               /**< KV flags, @see FDB_KV_FLAG_COMPRESSED */
+#endif
+};
+
+/* the streaming KV writer, @see fdb_kv_write_begin */
+struct fdb_kv_writer {
+    char name[FDB_KV_NAME_MAX + 1];              /**< KV name */
+    size_t name_len;                             /**< KV name length */
+    size_t value_len;                            /**< KV value length */
+    size_t written;                              /**< the written value length */
+    uint32_t addr;                               /**< the new KV address. DO NOT touch it. */
+    uint32_t len;                                /**< the new KV total length. DO NOT touch it. */
+    uint32_t crc32;                              /**< the running CRC32 of the new KV. DO NOT touch it. */
+    bool is_full;                                /**< the sector is full after the KV reserved. DO NOT touch it. */
+#if (FDB_WRITE_GRAN / 8 > 1)
+    uint8_t tail[FDB_WRITE_GRAN / 8];            /**< the not aligned tail of the written value. DO NOT touch it. */
+#endif
+};
+
+/* the GC pressure of KVDB, @see fdb_kv_gc_pressure */
+struct fdb_kv_gc_pressure {
+    size_t empty_sec;                            /**< empty sector number */
+    size_t dirty_sec;                            /**< dirty sector number, it has garbage KV */
+    size_t threshold;                            /**< the empty sector threshold of the incremental GC (FDB_GC_STEP_EMPTY_SEC_THRESHOLD) */
+    bool in_progress;                            /**< a sector is being collected by the incremental GC */
+};
+
+#ifdef FDB_USING_STATS
+/* the operation counters of KVDB, they are only increased, @see fdb_kvdb.stats */
+struct fdb_kv_stats {
+    uint32_t set_calls;                          /**< set (including batch and streaming write) API calls */
+    uint64_t set_bytes;                          /**< key and value bytes of the set API calls, it's the data size requested by user */
+    uint32_t get_calls;                          /**< get API calls */
+    uint32_t del_calls;                          /**< delete API calls */
+    uint32_t cache_hits;                         /**< KV cache hit when find KV */
+    uint32_t cache_misses;                       /**< KV cache miss when find KV, the KV is searched on flash */
+    uint32_t gc_runs;                            /**< full GC runs, it's triggered when the empty sector is not enough */
+    uint32_t gc_sectors;                         /**< collected sectors by the full and incremental GC */
+    uint32_t moved_kvs;                          /**< moved KV number by GC and recovery */
+    uint64_t moved_bytes;                        /**< moved KV bytes by GC and recovery */
+};
+#endif /* FDB_USING_STATS */
+
 /* error code */
 typedef enum {
     FDB_NO_ERR,
@@ -146,6 +217,14 @@ enum fdb_kv_status {
 };
 typedef enum fdb_kv_status fdb_kv_status_t;
 
+/* the GC victim policy, it decides which dirty sector is collected first */
+enum fdb_kv_gc_policy {
+    FDB_KV_GC_SEQUENTIAL,                        /**< collect the dirty sectors in address order from the oldest sector (default) */
+    FDB_KV_GC_GREEDY,                            /**< collect the dirty sector which has the least live KV size first */
+    FDB_KV_GC_COST_BENEFIT,                      /**< collect the dirty sector which has the best (free size * age) / (sector size + live KV size) first */
+};
+typedef enum fdb_kv_gc_policy fdb_kv_gc_policy_t;
+
 enum fdb_tsl_status {
     FDB_TSL_UNUSED,
     FDB_TSL_PRE_WRITE,
@@ -162,6 +241,9 @@ struct fdb_kv {
     fdb_kv_status_t status;                      /**< node status, @see fdb_kv_status_t */
     bool crc_is_ok;                              /**< node CRC32 check is OK */
     uint8_t name_len;                            /**< name length */
+#ifdef FDB_KV_USING_COMPRESS
+    uint8_t flags;                               /**< KV flags, @see FDB_KV_FLAG_COMPRESSED */
+#endif
     uint32_t magic;                              /**< magic word(`K`, `V`, `4`, `0`) */
     uint32_t len;                                /**< node total length (header + name + value), must align by FDB_WRITE_GRAN */
     uint32_t value_len;                          /**< value length */
@@ -196,6 +278,20 @@ struct fdb_tsl {
 typedef struct fdb_tsl *fdb_tsl_t;
 typedef bool (*fdb_tsl_cb)(fdb_tsl_t tsl, void *arg);
 
+/* the item of TSL batch, @see fdb_tsl_append_batch */
+struct fdb_tsl_batch_item {
+    fdb_time_t time;                             /**< log timestamp */
+    const void *buf;                             /**< log data */
+    size_t size;                                 /**< log data length */
+};
+
+/* the TSL summary of a time range, @see fdb_tsl_query_summary */
+struct fdb_tsl_summary {
+    size_t count;                                /**< the matched TSL count */
+    struct fdb_tsl first;                        /**< the first (minimum timestamp) matched TSL, only valid when count > 0 */
+    struct fdb_tsl last;                         /**< the last (maximum timestamp) matched TSL, only valid when count > 0 */
+};
+
 typedef enum {
     FDB_STORAGE_FAL,
     FDB_STORAGE_FILE,
@@ -258,6 +354,18 @@ struct tsdb_sec_info {
 };
 typedef struct tsdb_sec_info *tsdb_sec_info_t;
 
+#ifdef FDB_TSDB_USING_SEC_DIR
+/* TSDB sector directory entry, the entry N describes the sector at address N * sector size */
+struct tsdb_sec_dir_entry {
+    fdb_time_t start_time;                       /**< the first start node's timestamp */
+    fdb_time_t end_time;                         /**< the last end node's timestamp, only valid for the full sector */
+    uint32_t end_idx;                            /**< the last end node's index, only valid for the full sector */
+    fdb_sector_store_status_t status;            /**< sector store status @see fdb_sector_store_status_t */
+    uint32_t tsl_num[FDB_TSL_STATUS_NUM];        /**< the TSL number of each status, only valid when summary_ok is true */
+    bool summary_ok;                             /**< the TSL number is counted, it's counted by the first summary query of the full sector */
+};
+#endif
+
 struct kv_cache_node {
     uint16_t name_crc;                           /**< KV name's CRC32 low 16bit value */
     uint16_t active;                             /**< KV node access active degree */
@@ -309,6 +417,8 @@ struct fdb_kvdb {
     struct fdb_kv cur_kv;
     struct kvdb_sec_info cur_sector;
     bool last_is_complete_del;
+    size_t gc_budget;                            /**< the incremental GC budget, it's the max moved KV number after each write. 0: disabled */
+    fdb_kv_gc_policy_t gc_policy;                /**< the GC victim policy */
 
 #ifdef FDB_KV_USING_CACHE
     /* KV cache table */
@@ -321,6 +431,19 @@ struct fdb_kvdb {
     uint32_t ver_num;                            /**< setting version number for update */
 #endif
 
+#ifdef FDB_KV_USING_INDEX
+    void *kv_index;                              /**< full KV index object, managed by the fdb_kv_index_xxx port functions */
+    bool kv_index_ready;                         /**< the index contains all KV, it's set after the KV load finished */
+#endif
+
+#ifdef FDB_USING_STATS
+    struct fdb_kv_stats stats;                   /**< operation counters */
+#endif
+
+#ifdef FDB_KV_USING_PRECHECK
+    void *kv_precheck;                           /**< KV CRC32 precheck result, managed by the fdb_kv_precheck_xxx port functions, NULL: not used */
+#endif
+
     void *user_data;
 };
 typedef struct fdb_kvdb *fdb_kvdb_t;
@@ -334,6 +457,12 @@ struct fdb_tsdb {
     size_t max_len;                              /**< the maximum length of each log */
     bool rollover;                               /**< the oldest data will rollover by newest data, default is true */
 
+#ifdef FDB_TSDB_USING_SEC_DIR
+    struct tsdb_sec_dir_entry *sec_dir;          /**< in-RAM sector directory, provided by the user before initialization, NULL: not used */
+    size_t sec_dir_num;                          /**< the entry number of the sector directory, MUST NOT less than the sector number */
+    bool sec_dir_ready;                          /**< the directory contains all sectors, it's set after the sector check finished */
+#endif
+
     void *user_data;
 };
 typedef struct fdb_tsdb *fdb_tsdb_t;
@@ -34,6 +34,14 @@ fdb_err_t fdb_kvdb_init   (fdb_kvdb_t db, const char *name, const char *path, st
 void      fdb_kvdb_control(fdb_kvdb_t db, int cmd, void *arg);
 fdb_err_t fdb_kvdb_check(fdb_kvdb_t db);
 fdb_err_t fdb_kvdb_deinit(fdb_kvdb_t db);
+#ifdef FDB_KV_USING_INDEX
+uint32_t  fdb_kvdb_sector_fingerprint(fdb_kvdb_t db);
+bool      fdb_kv_read_obj(fdb_kvdb_t db, uint32_t addr, const char *key, fdb_kv_t kv);
+#endif
+#ifdef FDB_KV_USING_PRECHECK
+size_t    fdb_kv_sector_precheck(fdb_kvdb_t db, uint32_t sec_addr,
+        void (*cb)(uint32_t addr, uint32_t len, uint32_t crc32, void *arg), void *arg);
+#endif
 fdb_err_t fdb_tsdb_init   (fdb_tsdb_t db, const char *name, const char *path, fdb_get_time get_time, size_t max_len,
         void *user_data);
 void      fdb_tsdb_control(fdb_tsdb_t db, int cmd, void *arg);
@@ -47,6 +55,18 @@ size_t     fdb_blob_read     (fdb_db_t db, fdb_blob_t blob);
 fdb_err_t         fdb_kv_set          (fdb_kvdb_t db, const char *key, const char *value);
 char             *fdb_kv_get          (fdb_kvdb_t db, const char *key);
 fdb_err_t         fdb_kv_set_blob     (fdb_kvdb_t db, const char *key, fdb_blob_t blob);
+#ifdef FDB_KV_USING_COMPRESS
+fdb_err_t         fdb_kv_set_blob_ex  (fdb_kvdb_t db, const char *key, fdb_blob_t blob, uint8_t flags);
+#endif
+fdb_err_t         fdb_kv_set_batch    (fdb_kvdb_t db, struct fdb_kv_batch_item *items, size_t count);
+#if (FDB_WRITE_GRAN <= 32)
+fdb_err_t         fdb_kv_write_begin  (fdb_kvdb_t db, const char *key, size_t value_len, struct fdb_kv_writer *writer);
+fdb_err_t         fdb_kv_write_data   (fdb_kvdb_t db, struct fdb_kv_writer *writer, const void *buf, size_t size);
+fdb_err_t         fdb_kv_write_finish (fdb_kvdb_t db, struct fdb_kv_writer *writer);
+void              fdb_kv_write_abort  (fdb_kvdb_t db, struct fdb_kv_writer *writer);
+#endif
+fdb_err_t         fdb_kv_gc_step      (fdb_kvdb_t db, size_t budget, bool *pending);
+void              fdb_kv_gc_pressure  (fdb_kvdb_t db, struct fdb_kv_gc_pressure *pressure);
 size_t            fdb_kv_get_blob     (fdb_kvdb_t db, const char *key, fdb_blob_t blob);
 fdb_err_t         fdb_kv_del          (fdb_kvdb_t db, const char *key);
 fdb_kv_t          fdb_kv_get_obj      (fdb_kvdb_t db, const char *key, fdb_kv_t kv);
@@ -59,10 +79,12 @@ bool              fdb_kv_iterate      (fdb_kvdb_t db, fdb_kv_iterator_t itr);
 /* Time series log API like a TSDB */
 fdb_err_t  fdb_tsl_append      (fdb_tsdb_t db, fdb_blob_t blob);
 fdb_err_t  fdb_tsl_append_with_ts(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t timestamp);
+fdb_err_t  fdb_tsl_append_batch(fdb_tsdb_t db, struct fdb_tsl_batch_item *items, size_t count);
 void       fdb_tsl_iter        (fdb_tsdb_t db, fdb_tsl_cb cb, void *cb_arg);
 void       fdb_tsl_iter_reverse(fdb_tsdb_t db, fdb_tsl_cb cb, void *cb_arg);
 void       fdb_tsl_iter_by_time(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_cb cb, void *cb_arg);
 size_t     fdb_tsl_query_count (fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_status_t status);
+void       fdb_tsl_query_summary(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_status_t status, struct fdb_tsl_summary *summary);
 fdb_err_t  fdb_tsl_set_status  (fdb_tsdb_t db, fdb_tsl_t tsl, fdb_tsl_status_t status);
 void       fdb_tsl_clean       (fdb_tsdb_t db);
 fdb_blob_t fdb_tsl_to_blob     (fdb_tsl_t tsl, fdb_blob_t blob);
@@ -0,0 +1,195 @@
+use crate::{DirectRead, SyncNorFlash};
+use embedded_storage::nor_flash::{ErrorType, NorFlash, ReadNorFlash};
+
+// 空闲缓存页的标记
+const INVALID_PAGE: u32 = u32::MAX;
+
+/// 一个带页缓存的 `NorFlash` 包装。
+///
+/// C 库会发起大量细碎且相互重叠的读取：KV 头部、名称、值，扫描 KV 魔数时的窗口，
+/// 以及命中 KV 缓存后对名称的二次确认。每次读取都要经过 FFI 回调到存储后端，
+/// 对 SPI-NOR 这类每次传输都有固定开销的后端来说代价很高。
+///
+/// `CachedFlash` 以 `PAGE` 字节对齐的页为单位缓存最近读取的数据，最多缓存 `N` 页，
+/// 按 LRU 淘汰。写入和擦除会使相关的缓存页失效，因此读到的数据总是与底层存储一致。
+/// 覆盖完整页且未被缓存的读取（通常是较大的值）会直接读取底层存储，不会挤掉已缓存的页。
+///
+/// 不依赖 `alloc`，缓存页直接存放在结构体内，占用 `PAGE * N` 字节。
+///
+/// # 示例
+///
+/// ```ignore
+/// let flash = CachedFlash::<_, 256, 8>::new(spi_flash);
+/// let mut db = KVDB::new(flash);
+/// ```
+pub struct CachedFlash<S: NorFlash, const PAGE: usize = 256, const N: usize = 8> {
+    inner: S,
+    pages: [[u8; PAGE]; N],
+    // 每个缓存页对应的页起始地址，INVALID_PAGE 表示空闲
+    tags: [u32; N],
+    // 最近一次访问的时间戳，最小者被淘汰
+    stamps: [u32; N],
+    clock: u32,
+    hits: usize,
+    misses: usize,
+}
+
+impl<S: NorFlash, const PAGE: usize, const N: usize> CachedFlash<S, PAGE, N> {
+    /// 创建一个新的 `CachedFlash` 实例。
+    ///
+    /// `PAGE` 必须是 `S::READ_SIZE` 的整数倍并能整除存储容量，`N` 不能为 0。
+    pub fn new(inner: S) -> Self {
+        assert!(N > 0 && PAGE > 0, "page size and page number MUST be more than 0");
+        assert!(PAGE % S::READ_SIZE == 0, "page size MUST be a multiple of READ_SIZE");
+        assert!(inner.capacity() % PAGE == 0, "page size MUST divide the capacity");
+        Self {
+            inner,
+            pages: [[0xFF; PAGE]; N],
+            tags: [INVALID_PAGE; N],
+            stamps: [0; N],
+            clock: 0,
+            hits: 0,
+            misses: 0,
+        }
+    }
+
+    /// 获取底层存储的引用。
+    pub fn inner(&self) -> &S {
+        &self.inner
+    }
+
+    /// 获取底层存储的可变引用。
+    ///
+    /// **注意**: 绕过缓存直接修改底层存储后，必须调用 [`CachedFlash::invalidate`]。
+    pub fn inner_mut(&mut self) -> &mut S {
+        &mut self.inner
+    }
+
+    /// 取出底层存储。
+    pub fn into_inner(self) -> S {
+        self.inner
+    }
+
+    /// 清空所有缓存页。
+    pub fn invalidate(&mut self) {
+        self.tags = [INVALID_PAGE; N];
+    }
+
+    /// 缓存命中与未命中的页访问次数，格式为 `(命中, 未命中)`。
+    pub fn stats(&self) -> (usize, usize) {
+        (self.hits, self.misses)
+    }
+
+    /// 使与 `[from, to)` 有重叠的缓存页失效
+    fn invalidate_range(&mut self, from: u32, to: u32) {
+        for tag in self.tags.iter_mut() {
+            if *tag != INVALID_PAGE && *tag < to && *tag + PAGE as u32 > from {
+                *tag = INVALID_PAGE;
+            }
+        }
+    }
+
+    /// 查找页起始地址为 `page_addr` 的缓存页
+    fn lookup(&mut self, page_addr: u32) -> Option<usize> {
+        let index = self.tags.iter().position(|&tag| tag == page_addr)?;
+        self.clock = self.clock.wrapping_add(1);
+        self.stamps[index] = self.clock;
+        Some(index)
+    }
+
+    /// 从底层存储加载一页，淘汰最久未使用的缓存页
+    fn load(&mut self, page_addr: u32) -> Result<usize, S::Error> {
+        let index = match self.tags.iter().position(|&tag| tag == INVALID_PAGE) {
+            Some(index) => index,
+            None => {
+                // 以当前时间戳为基准比较，计数回绕后依然能找到最久未使用的页
+                let clock = self.clock;
+                (0..N)
+                    .max_by_key(|&i| clock.wrapping_sub(self.stamps[i]))
+                    .unwrap_or(0)
+            }
+        };
+        // 读取失败时该页保持空闲
+        self.tags[index] = INVALID_PAGE;
+        self.inner.read(page_addr, &mut self.pages[index])?;
+        self.tags[index] = page_addr;
+        self.clock = self.clock.wrapping_add(1);
+        self.stamps[index] = self.clock;
+        Ok(index)
+    }
+}
+
+impl<S: NorFlash, const PAGE: usize, const N: usize> ErrorType for CachedFlash<S, PAGE, N> {
+    type Error = S::Error;
+}
+
+impl<S: NorFlash, const PAGE: usize, const N: usize> ReadNorFlash for CachedFlash<S, PAGE, N> {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        let mut done = 0;
+        while done < bytes.len() {
+            let cur = offset + done as u32;
+            let page_addr = cur - cur % PAGE as u32;
+            let page_offset = (cur - page_addr) as usize;
+            let len = (bytes.len() - done).min(PAGE - page_offset);
+            let dst = &mut bytes[done..done + len];
+
+            match self.lookup(page_addr) {
+                Some(index) => {
+                    self.hits += 1;
+                    dst.copy_from_slice(&self.pages[index][page_offset..page_offset + len]);
+                }
+                None if len == PAGE => {
+                    // 整页读取直接交给底层存储
+                    self.misses += 1;
+                    self.inner.read(page_addr, dst)?;
+                }
+                None => {
+                    self.misses += 1;
+                    let index = self.load(page_addr)?;
+                    dst.copy_from_slice(&self.pages[index][page_offset..page_offset + len]);
+                }
+            }
+            done += len;
+        }
+        Ok(())
+    }
+
+    fn capacity(&self) -> usize {
+        self.inner.capacity()
+    }
+}
+
+impl<S: NorFlash, const PAGE: usize, const N: usize> NorFlash for CachedFlash<S, PAGE, N> {
+    const WRITE_SIZE: usize = S::WRITE_SIZE;
+    const ERASE_SIZE: usize = S::ERASE_SIZE;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        // 无论成功与否，底层数据都可能已经改变
+        self.invalidate_range(from, to);
+        self.inner.erase(from, to)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.invalidate_range(offset, offset + bytes.len() as u32);
+        self.inner.write(offset, bytes)
+    }
+}
+
+impl<S: SyncNorFlash, const PAGE: usize, const N: usize> SyncNorFlash for CachedFlash<S, PAGE, N> {
+    fn write_sync(&mut self, offset: u32, bytes: &[u8], sync: bool) -> Result<(), Self::Error> {
+        self.invalidate_range(offset, offset + bytes.len() as u32);
+        self.inner.write_sync(offset, bytes, sync)
+    }
+
+    fn sync(&mut self) -> Result<(), Self::Error> {
+        self.inner.sync()
+    }
+}
+
+impl<S: DirectRead, const PAGE: usize, const N: usize> DirectRead for CachedFlash<S, PAGE, N> {
+    fn direct(&self, offset: u32, len: usize) -> Option<&[u8]> {
+        self.inner.direct(offset, len)
+    }
+}
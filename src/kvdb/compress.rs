@@ -0,0 +1,187 @@
+//! KV 值的透明压缩（`kv_compress` 特性）。
+//!
+//! 压缩后的值以 LZ4 块格式保存，开头附加 4 字节（小端序）的原始长度：
+//! `[原始长度: u32][LZ4 块]`。KV 头部的 `FDB_KV_FLAG_COMPRESSED` 标志表示值经过压缩，
+//! C 库只负责保存该标志，压缩与解压都在 Rust 侧完成。
+//!
+//! 只实现了 LZ4 块格式本身，不包含帧格式，也不依赖 `std`。
+
+use crate::Error;
+use alloc::vec::Vec;
+
+const HEADER_LEN: usize = 4;
+const MIN_MATCH: usize = 4;
+// LZ4 块格式要求：最后 5 个字节必须是字面量，最后一个匹配必须在结尾 12 字节之前开始
+const LAST_LITERALS: usize = 5;
+const MF_LIMIT: usize = 12;
+const MAX_OFFSET: usize = 65535;
+const HASH_LOG: u32 = 12;
+
+/// 压缩一个值。
+///
+/// # 返回
+/// - `Some(Vec<u8>)`: 带长度头的压缩数据，总是比原始值短。
+/// - `None`: 压缩后没有变短，应原样保存。
+pub(crate) fn compress(value: &[u8]) -> Option<Vec<u8>> {
+    if value.len() > u32::MAX as usize {
+        return None;
+    }
+    let mut out = Vec::with_capacity(value.len());
+    out.extend_from_slice(&(value.len() as u32).to_le_bytes());
+    compress_block(value, &mut out);
+    (out.len() < value.len()).then_some(out)
+}
+
+/// 解压数据后的原始长度。
+pub(crate) fn decompressed_len(stored: &[u8]) -> Result<usize, Error> {
+    let header = stored.get(..HEADER_LEN).ok_or(Error::ReadError)?;
+    Ok(u32::from_le_bytes([header[0], header[1], header[2], header[3]]) as usize)
+}
+
+/// 将压缩数据解压到 `out` 中，返回原始长度。
+///
+/// # 返回
+/// - `Err(Error::InvalidArgument)`: `out` 比原始长度短，`out` 的内容不会被修改。
+/// - `Err(Error::ReadError)`: 数据已损坏。
+pub(crate) fn decompress_into(stored: &[u8], out: &mut [u8]) -> Result<usize, Error> {
+    let len = decompressed_len(stored)?;
+    if out.len() < len {
+        return Err(Error::InvalidArgument);
+    }
+    if decompress_block(&stored[HEADER_LEN..], &mut out[..len])? != len {
+        return Err(Error::ReadError);
+    }
+    Ok(len)
+}
+
+/// 解压数据到新分配的缓冲区中。
+pub(crate) fn decompress(stored: &[u8]) -> Result<Vec<u8>, Error> {
+    let mut out = alloc::vec![0; decompressed_len(stored)?];
+    decompress_into(stored, &mut out)?;
+    Ok(out)
+}
+
+#[inline]
+fn read_u32(src: &[u8], pos: usize) -> u32 {
+    u32::from_le_bytes([src[pos], src[pos + 1], src[pos + 2], src[pos + 3]])
+}
+
+#[inline]
+fn hash(sequence: u32) -> usize {
+    (sequence.wrapping_mul(2654435761) >> (32 - HASH_LOG)) as usize
+}
+
+fn put_len(out: &mut Vec<u8>, mut len: usize) {
+    while len >= 255 {
+        out.push(255);
+        len -= 255;
+    }
+    out.push(len as u8);
+}
+
+fn put_literals(out: &mut Vec<u8>, token: u8, literals: &[u8]) {
+    let lit_len = literals.len();
+    out.push(token | (lit_len.min(15) as u8) << 4);
+    if lit_len >= 15 {
+        put_len(out, lit_len - 15);
+    }
+    out.extend_from_slice(literals);
+}
+
+/// 贪心匹配的单趟 LZ4 压缩，哈希表只保存每个 4 字节序列最近一次出现的位置
+fn compress_block(src: &[u8], out: &mut Vec<u8>) {
+    let mut anchor = 0;
+    if src.len() > MF_LIMIT {
+        let mut table = alloc::vec![0u32; 1 << HASH_LOG];
+        let match_limit = src.len() - LAST_LITERALS;
+        let mut pos = 0;
+        while pos + MF_LIMIT <= src.len() {
+            let sequence = read_u32(src, pos);
+            let slot = &mut table[hash(sequence)];
+            let candidate = *slot as usize;
+            *slot = pos as u32;
+            if candidate >= pos || pos - candidate > MAX_OFFSET || read_u32(src, candidate) != sequence {
+                pos += 1;
+                continue;
+            }
+
+            let mut len = MIN_MATCH;
+            while pos + len < match_limit && src[candidate + len] == src[pos + len] {
+                len += 1;
+            }
+            // 向前扩展匹配，减少字面量
+            let (mut start, mut candidate) = (pos, candidate);
+            while start > anchor && candidate > 0 && src[start - 1] == src[candidate - 1] {
+                start -= 1;
+                candidate -= 1;
+                len += 1;
+            }
+
+            let match_len = len - MIN_MATCH;
+            put_literals(out, match_len.min(15) as u8, &src[anchor..start]);
+            out.extend_from_slice(&((start - candidate) as u16).to_le_bytes());
+            if match_len >= 15 {
+                put_len(out, match_len - 15);
+            }
+            pos = start + len;
+            anchor = pos;
+        }
+    }
+    put_literals(out, 0, &src[anchor..]);
+}
+
+fn read_len(src: &[u8], pos: &mut usize) -> Result<usize, Error> {
+    let mut len = 0usize;
+    loop {
+        let byte = *src.get(*pos).ok_or(Error::ReadError)?;
+        *pos += 1;
+        len = len.checked_add(byte as usize).ok_or(Error::ReadError)?;
+        if byte != 255 {
+            return Ok(len);
+        }
+    }
+}
+
+/// 解压一个 LZ4 块，所有长度和偏移都经过边界检查
+fn decompress_block(src: &[u8], dst: &mut [u8]) -> Result<usize, Error> {
+    let (mut pos, mut written) = (0, 0);
+    loop {
+        let token = *src.get(pos).ok_or(Error::ReadError)?;
+        pos += 1;
+
+        let mut lit_len = (token >> 4) as usize;
+        if lit_len == 15 {
+            lit_len += read_len(src, &mut pos)?;
+        }
+        let lit_end = pos.checked_add(lit_len).ok_or(Error::ReadError)?;
+        let literals = src.get(pos..lit_end).ok_or(Error::ReadError)?;
+        dst.get_mut(written..written + lit_len)
+            .ok_or(Error::ReadError)?
+            .copy_from_slice(literals);
+        pos = lit_end;
+        written += lit_len;
+        if pos == src.len() {
+            return Ok(written);
+        }
+
+        let offset = src.get(pos..pos + 2).ok_or(Error::ReadError)?;
+        let offset = u16::from_le_bytes([offset[0], offset[1]]) as usize;
+        pos += 2;
+        if offset == 0 || offset > written {
+            return Err(Error::ReadError);
+        }
+        let mut match_len = (token & 15) as usize;
+        if match_len == 15 {
+            match_len += read_len(src, &mut pos)?;
+        }
+        match_len += MIN_MATCH;
+        if match_len > dst.len() - written {
+            return Err(Error::ReadError);
+        }
+        // 匹配可能与输出重叠，必须逐字节复制
+        for i in written..written + match_len {
+            dst[i] = dst[i - offset];
+        }
+        written += match_len;
+    }
+}
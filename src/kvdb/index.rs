@@ -0,0 +1,312 @@
+use crate::fdb_kvdb_t;
+use alloc::boxed::Box;
+use alloc::collections::BTreeMap;
+use core::ffi::c_char;
+#[cfg(feature = "std")]
+use std::sync::{
+    atomic::{AtomicU64, Ordering},
+    Arc, RwLock, RwLockReadGuard, RwLockWriteGuard,
+};
+#[cfg(feature = "kv_snapshot")]
+use crate::{fdb_calc_crc32, fdb_kvdb_sector_fingerprint};
+#[cfg(feature = "kv_snapshot")]
+use std::path::PathBuf;
+
+/// 完整的 KV 内存索引：键名 -> 有效 KV 节点在 Flash 中的地址。
+///
+/// 索引在 C 库加载数据库（`_fdb_kv_load`）的遍历过程中建立，并在写入、删除和 GC 搬运 KV 时同步更新。
+/// 启用后，`find_kv` 不再需要遍历整个数据库：命中时只需读取一次节点进行校验，未命中则直接返回。
+///
+/// 在 `std` 环境下索引可以被 [`KVDBReader`](super::KVDBReader) 跨线程共享，
+/// 每次修改都会递增版本号，读取者据此判断读取期间索引是否发生过变化。
+#[derive(Default)]
+pub(crate) struct KvIndex {
+    #[cfg(not(feature = "std"))]
+    map: IndexMap,
+    #[cfg(feature = "std")]
+    pub(crate) shared: Arc<SharedIndex>,
+    /// 索引快照文件路径，为 `None` 时不使用快照
+    #[cfg(feature = "kv_snapshot")]
+    pub(crate) snapshot: Option<PathBuf>,
+}
+
+pub(crate) type IndexMap = BTreeMap<Box<[u8]>, u32>;
+
+/// 写入者与只读句柄共享的索引
+#[cfg(feature = "std")]
+#[derive(Default)]
+pub(crate) struct SharedIndex {
+    map: RwLock<IndexMap>,
+    generation: AtomicU64,
+}
+
+#[cfg(feature = "std")]
+impl SharedIndex {
+    pub(crate) fn read(&self) -> RwLockReadGuard<'_, IndexMap> {
+        // 索引的修改不会在中途 panic，锁中毒时数据依然完整
+        self.map.read().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn write(&self) -> RwLockWriteGuard<'_, IndexMap> {
+        let map = self.map.write().unwrap_or_else(|e| e.into_inner());
+        self.generation.fetch_add(1, Ordering::Release);
+        map
+    }
+
+    /// 索引的版本号，每次修改索引都会递增
+    pub(crate) fn generation(&self) -> u64 {
+        self.generation.load(Ordering::Acquire)
+    }
+}
+
+impl KvIndex {
+    /// 当前索引中的键数量
+    pub(crate) fn len(&self) -> usize {
+        self.map().len()
+    }
+
+    /// 按键的顺序收集从 `lower` 开始、满足 `pred` 的连续一段键及其地址
+    pub(crate) fn range(&self, lower: &[u8], mut pred: impl FnMut(&[u8]) -> bool) -> alloc::vec::Vec<(Box<[u8]>, u32)> {
+        self.map()
+            .range::<[u8], _>((core::ops::Bound::Included(lower), core::ops::Bound::Unbounded))
+            .take_while(|(name, _)| pred(name))
+            .map(|(name, addr)| (name.clone(), *addr))
+            .collect()
+    }
+
+    /// 移除指向 `addr` 的键。只有索引仍指向该节点时才移除，KV 被覆盖或搬运后索引已经指向新节点
+    pub(crate) fn remove(&mut self, name: &[u8], addr: u32) {
+        self.update(|map| {
+            if map.get(name) == Some(&addr) {
+                map.remove(name);
+            }
+        });
+    }
+
+    #[cfg(not(feature = "std"))]
+    fn map(&self) -> &IndexMap {
+        &self.map
+    }
+
+    /// 修改索引
+    #[cfg(not(feature = "std"))]
+    fn update<T>(&mut self, f: impl FnOnce(&mut IndexMap) -> T) -> T {
+        f(&mut self.map)
+    }
+
+    #[cfg(feature = "std")]
+    fn map(&self) -> RwLockReadGuard<'_, IndexMap> {
+        self.shared.read()
+    }
+
+    #[cfg(feature = "std")]
+    fn update<T>(&mut self, f: impl FnOnce(&mut IndexMap) -> T) -> T {
+        f(&mut self.shared.write())
+    }
+}
+
+// 快照文件格式（小端序）：
+// magic(4) | version | sec_size | max_size | fingerprint | count |
+// count * (name_len(1) | name | addr) | crc32(此前所有字节)
+#[cfg(feature = "kv_snapshot")]
+const SNAPSHOT_MAGIC: &[u8; 4] = b"FDBI";
+#[cfg(feature = "kv_snapshot")]
+const SNAPSHOT_VERSION: u32 = 1;
+
+#[cfg(feature = "kv_snapshot")]
+fn snapshot_crc(data: &[u8]) -> u32 {
+    unsafe { fdb_calc_crc32(0, data.as_ptr() as *const _, data.len()) }
+}
+
+#[cfg(feature = "kv_snapshot")]
+struct SnapshotReader<'a> {
+    data: &'a [u8],
+}
+
+#[cfg(feature = "kv_snapshot")]
+impl<'a> SnapshotReader<'a> {
+    fn take(&mut self, len: usize) -> Option<&'a [u8]> {
+        if self.data.len() < len {
+            return None;
+        }
+        let (head, tail) = self.data.split_at(len);
+        self.data = tail;
+        Some(head)
+    }
+
+    fn u32(&mut self) -> Option<u32> {
+        Some(u32::from_le_bytes(self.take(4)?.try_into().ok()?))
+    }
+}
+
+#[cfg(feature = "kv_snapshot")]
+impl KvIndex {
+    /// 将索引保存为快照文件，下次初始化时可跳过全量 KV 检查。
+    ///
+    /// 必须在数据库正常关闭（`deinit`）之前调用，且此前没有发生过写入失败。
+    pub(crate) unsafe fn save_snapshot(&self, db: fdb_kvdb_t) -> std::io::Result<()> {
+        let path = match &self.snapshot {
+            Some(path) => path,
+            None => return Ok(()),
+        };
+        if !(*db).kv_index_ready {
+            return Ok(());
+        }
+
+        let map = self.map();
+        let mut buf = Vec::with_capacity(28 + map.len() * 16);
+        buf.extend_from_slice(SNAPSHOT_MAGIC);
+        for word in [
+            SNAPSHOT_VERSION,
+            (*db).parent.sec_size,
+            (*db).parent.max_size,
+            fdb_kvdb_sector_fingerprint(db),
+            map.len() as u32,
+        ] {
+            buf.extend_from_slice(&word.to_le_bytes());
+        }
+        for (name, addr) in map.iter() {
+            buf.push(name.len() as u8);
+            buf.extend_from_slice(name);
+            buf.extend_from_slice(&addr.to_le_bytes());
+        }
+        let crc = snapshot_crc(&buf);
+        buf.extend_from_slice(&crc.to_le_bytes());
+
+        // 先写临时文件再重命名，避免留下不完整的快照
+        let tmp = path.with_extension("idx.tmp");
+        std::fs::write(&tmp, &buf)?;
+        std::fs::rename(&tmp, path)
+    }
+
+    /// 从快照恢复索引，快照无效或不存在时返回 `false`。
+    unsafe fn restore_snapshot(&mut self, db: fdb_kvdb_t) -> bool {
+        let path = match &self.snapshot {
+            Some(path) => path,
+            None => return false,
+        };
+        let data = match std::fs::read(path) {
+            Ok(data) => data,
+            Err(_) => return false,
+        };
+        // 快照只能使用一次：删除之后数据库的任何修改都不会与旧快照混淆，
+        // 即使之后进程异常退出，下次启动也会回退到完整的恢复检查
+        if std::fs::remove_file(path).is_err() {
+            return false;
+        }
+
+        self.update(|map| {
+            map.clear();
+            if parse_snapshot(map, db, &data).is_none() {
+                map.clear();
+                return false;
+            }
+            true
+        })
+    }
+}
+
+#[cfg(feature = "kv_snapshot")]
+unsafe fn parse_snapshot(map: &mut IndexMap, db: fdb_kvdb_t, data: &[u8]) -> Option<()> {
+    let (body, crc) = data.split_at(data.len().checked_sub(4)?);
+    if u32::from_le_bytes(crc.try_into().ok()?) != snapshot_crc(body) {
+        return None;
+    }
+
+    let max_size = (*db).parent.max_size;
+    let mut reader = SnapshotReader { data: body };
+    if reader.take(4)? != SNAPSHOT_MAGIC
+        || reader.u32()? != SNAPSHOT_VERSION
+        || reader.u32()? != (*db).parent.sec_size
+        || reader.u32()? != max_size
+        || reader.u32()? != fdb_kvdb_sector_fingerprint(db)
+    {
+        return None;
+    }
+    let count = reader.u32()?;
+    for _ in 0..count {
+        let name_len = reader.take(1)?[0] as usize;
+        let name = reader.take(name_len)?;
+        let addr = reader.u32()?;
+        if addr >= max_size {
+            return None;
+        }
+        map.insert(name.into(), addr);
+    }
+    reader.data.is_empty().then_some(())
+}
+
+unsafe fn index_of<'a>(db: fdb_kvdb_t) -> Option<&'a mut KvIndex> {
+    ((*db).kv_index as *mut KvIndex).as_mut()
+}
+
+unsafe fn name_of<'a>(name: *const c_char, name_len: usize) -> &'a [u8] {
+    core::slice::from_raw_parts(name as *const u8, name_len)
+}
+
+// --- 暴露给 C 库的索引接口，见 fdb_kvdb.c 中的 FDB_KV_USING_INDEX ---
+
+#[no_mangle]
+pub unsafe extern "C" fn fdb_kv_index_get(
+    db: fdb_kvdb_t,
+    name: *const c_char,
+    name_len: usize,
+    addr: *mut u32,
+) -> bool {
+    let found = index_of(db).and_then(|index| index.map().get(name_of(name, name_len)).copied());
+    match found {
+        Some(found) => {
+            *addr = found;
+            true
+        }
+        None => false,
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn fdb_kv_index_set(
+    db: fdb_kvdb_t,
+    name: *const c_char,
+    name_len: usize,
+    addr: u32,
+) {
+    if let Some(index) = index_of(db) {
+        let name = name_of(name, name_len);
+        index.update(|map| match map.get_mut(name) {
+            Some(old) => *old = addr,
+            None => {
+                map.insert(name.into(), addr);
+            }
+        });
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn fdb_kv_index_del(
+    db: fdb_kvdb_t,
+    name: *const c_char,
+    name_len: usize,
+    addr: u32,
+) {
+    if let Some(index) = index_of(db) {
+        index.remove(name_of(name, name_len), addr);
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn fdb_kv_index_clear(db: fdb_kvdb_t) {
+    if let Some(index) = index_of(db) {
+        index.update(|map| map.clear());
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn fdb_kv_index_restore(db: fdb_kvdb_t) -> bool {
+    #[cfg(feature = "kv_snapshot")]
+    if let Some(index) = index_of(db) {
+        return index.restore_snapshot(db);
+    }
+    #[cfg(not(feature = "kv_snapshot"))]
+    let _ = db;
+    false
+}
@@ -1,6 +1,10 @@
 use embedded_storage::nor_flash::NorFlash;
 
 use crate::{fdb_kv_iterate, fdb_kv_iterator, Error, RawHandle};
+#[cfg(feature = "alloc")]
+use crate::PrefetchWindow;
+#[cfg(feature = "alloc")]
+use alloc::boxed::Box;
 
 use super::{KVEntry, KVReader, KVDB};
 
@@ -8,6 +12,8 @@ pub struct KVDBIterator<'a, S: NorFlash> {
     inner: &'a mut KVDB<S>,    // 数据库实例的可变引用
     iterator: fdb_kv_iterator, // 底层C库的迭代器结构体
     is_done: bool,             // 迭代是否已完成的标志
+    #[cfg(feature = "alloc")]
+    prefetch: Option<Box<PrefetchWindow>>, // 预读窗口，地址必须稳定
 }
 
 impl<'a, S: NorFlash> KVDBIterator<'a, S> {
@@ -16,6 +22,32 @@ impl<'a, S: NorFlash> KVDBIterator<'a, S> {
             inner,
             iterator: Default::default(),
             is_done: false,
+            #[cfg(feature = "alloc")]
+            prefetch: None,
+        }
+    }
+
+    /// 启用预读（`alloc` 特性）：每次从扇区边界开始整块读取 `sectors` 个扇区，
+    /// 之后 KV 头部、名称以及通过 [`KVDBIterator::next_reader`] 读取的值都直接从内存中解析。
+    ///
+    /// `sectors` 大于 1 时，下一个扇区会随当前扇区一起读入，跨扇区时无需再次访问存储后端。
+    /// 窗口占用 `sectors * 扇区大小` 字节内存，`0` 按 1 处理。
+    /// 对每次传输都有固定开销的存储后端（如 SPI-NOR），全量遍历的读取次数可以减少一个数量级。
+    #[cfg(feature = "alloc")]
+    pub fn prefetch(mut self, sectors: usize) -> Self {
+        let sec_size = unsafe { (*(self.inner.handle() as crate::fdb_db_t)).sec_size } as usize;
+        let mut window = Box::new(PrefetchWindow::new(sectors.max(1) * sec_size));
+        self.inner.user_data.prefetch = &mut *window;
+        self.prefetch = Some(window);
+        self
+    }
+}
+
+#[cfg(feature = "alloc")]
+impl<'a, S: NorFlash> Drop for KVDBIterator<'a, S> {
+    fn drop(&mut self) {
+        if self.prefetch.is_some() {
+            self.inner.user_data.prefetch = core::ptr::null_mut();
         }
     }
 }
@@ -52,3 +84,52 @@ impl<'a, S: NorFlash> Iterator for KVDBIterator<'a, S> {
         return Some(self.iterator.curr_kv.into());
     }
 }
+
+/// 复用缓冲区读取值的 KV 迭代器
+///
+/// 每次调用 [`KVDBValueIter::next`] 都会把当前 KV 的值读入构造时传入的缓冲区，
+/// 并返回指向该缓冲区的切片，因此在读取下一个 KV 之前必须处理完上一个值。
+/// 由于返回的切片借用了迭代器，它没有实现标准库的 `Iterator` trait，可以使用 `while let` 遍历：
+///
+/// ```ignore
+/// let mut buf = [0u8; 256];
+/// let mut iter = db.iter_values(&mut buf);
+/// while let Some(item) = iter.next() {
+///     let (entry, value) = item?;
+/// }
+/// ```
+pub struct KVDBValueIter<'a, 'b, S: NorFlash> {
+    inner: KVDBIterator<'a, S>,
+    buf: &'b mut [u8],
+}
+
+impl<'a, 'b, S: NorFlash> KVDBValueIter<'a, 'b, S> {
+    pub fn new(inner: &'a mut KVDB<S>, buf: &'b mut [u8]) -> Self {
+        Self {
+            inner: KVDBIterator::new(inner),
+            buf,
+        }
+    }
+
+    /// 启用预读（`alloc` 特性），值也直接从预读窗口中复制，参见 [`KVDBIterator::prefetch`]。
+    #[cfg(feature = "alloc")]
+    pub fn prefetch(self, sectors: usize) -> Self {
+        Self {
+            inner: self.inner.prefetch(sectors),
+            buf: self.buf,
+        }
+    }
+
+    /// 读取下一个 KV 及其值。
+    ///
+    /// 值超过缓冲区长度时，该项返回 `Err(Error::InvalidArgument)`，迭代可以继续。
+    pub fn next(&mut self) -> Option<Result<(KVEntry, &[u8]), Error>> {
+        let entry = self.inner.next()?;
+        Some(
+            self.inner
+                .inner
+                .read_value_into(&entry, self.buf)
+                .map(move |len| (entry, &self.buf[..len])),
+        )
+    }
+}
@@ -1,15 +1,38 @@
 mod reader;
 pub use reader::*;
+mod writer;
+pub use writer::*;
 mod types;
 pub use types::*;
 mod iter;
 pub use iter::*;
+#[cfg(feature = "kv_index")]
+mod index;
+#[cfg(feature = "std")]
+mod shared;
+#[cfg(feature = "std")]
+pub use shared::*;
+#[cfg(feature = "std")]
+mod sharded;
+#[cfg(feature = "std")]
+pub use sharded::*;
+#[cfg(all(feature = "kv_index", feature = "std"))]
+mod read_handle;
+#[cfg(all(feature = "kv_index", feature = "std"))]
+pub use read_handle::*;
+#[cfg(feature = "kv_compress")]
+mod compress;
+#[cfg(feature = "alloc")]
+mod scan;
+#[cfg(feature = "kv_parallel_load")]
+mod precheck;
 
 use crate::{
     fdb_blob, fdb_blob__bindgen_ty_1, fdb_blob_read, fdb_db_t, fdb_kv, fdb_kv_del, fdb_kv_get_obj,
     fdb_kv_set_blob, fdb_kv_set_default, fdb_kvdb, fdb_kvdb_control_read, fdb_kvdb_control_write,
-    fdb_kvdb_deinit, fdb_kvdb_init, Error, FlashDispatch, RawHandle, FDB_KVDB_CTRL_SET_MAX_SIZE,
-    FDB_KVDB_CTRL_SET_NOT_FORMAT, FDB_KVDB_CTRL_SET_SEC_SIZE, FDB_KV_NAME_MAX,
+    fdb_kvdb_deinit, fdb_kvdb_init, DirectRead, Error, FlashDispatch, RawHandle, SyncNorFlash,
+    FDB_KVDB_CTRL_SET_MAX_SIZE, FDB_KVDB_CTRL_SET_NOT_FORMAT, FDB_KVDB_CTRL_SET_SEC_SIZE,
+    FDB_KV_NAME_MAX,
 };
 use core::{
     ffi::{c_char, c_void, CStr},
@@ -25,6 +48,10 @@ pub struct KVDB<S: NorFlash> {
     key_buf: [u8; FDB_KV_NAME_MAX as usize + 1],
     #[cfg(feature = "log")]
     name_buf: [u8; FDB_KV_NAME_MAX as usize + 1],
+    #[cfg(feature = "kv_index")]
+    index: index::KvIndex,
+    #[cfg(feature = "kv_compress")]
+    compress_threshold: usize,
     initialized: bool,
     // 由于fdb_kvdb内部引用了 storage 和 name_buf 所以结构体无法移动，否则会导致悬空指针
     _marker: PhantomData<*const ()>, // for !Send and !Sync
@@ -43,6 +70,9 @@ impl KVDB<crate::storage::StdStorage> {
     /// - `sec_size`: 扇区大小
     /// - `max_size`: 数据库最大容量
     /// - `default_kvs`: 可选的默认键值对
+    ///
+    /// 启用 `kv_snapshot` 特性时，会在 `path` 下使用 `{name}.fdb.idx` 作为索引快照文件，
+    /// 参见 [`KVDB::set_index_snapshot`]。
     pub fn new_file(
         name: &str,
         path: &str,
@@ -58,13 +88,30 @@ impl KVDB<crate::storage::StdStorage> {
             crate::storage::FileStrategy::Multi,
         )?;
 
-        let mut db = Box::new(KVDB::new(storage));
+        let mut db = Box::new(KVDB::new_with_sync(storage));
         db.set_name(name)?;
+        #[cfg(feature = "kv_snapshot")]
+        db.set_index_snapshot(std::path::Path::new(path).join(format!("{}.fdb.idx", name)));
         db.init(default_kvs)?;
         Ok(db)
     }
 }
 
+impl<S: SyncNorFlash> KVDB<S> {
+    /// 与 [`KVDB::new`] 相同，但会把 C 库的 `sync` 提示传递给存储后端，
+    /// 使存储可以按自身的持久化策略只在关键写入后同步。
+    pub fn new_with_sync(storage: S) -> Self {
+        let mut db = Self::new(storage);
+        db.user_data = FlashDispatch::with_sync::<S>();
+        db
+    }
+
+    /// 将存储后端中尚未持久化的写入同步到介质。
+    pub fn sync(&mut self) -> Result<(), S::Error> {
+        self.storage.sync()
+    }
+}
+
 impl<S: NorFlash> KVDB<S> {
     /// 创建一个未初始化的 KVDB 实例。
     ///
@@ -81,11 +128,36 @@ impl<S: NorFlash> KVDB<S> {
             key_buf: [0; FDB_KV_NAME_MAX as usize + 1],
             #[cfg(feature = "log")]
             name_buf: [0; FDB_KV_NAME_MAX as usize + 1],
+            #[cfg(feature = "kv_index")]
+            index: Default::default(),
+            #[cfg(feature = "kv_compress")]
+            compress_threshold: 0,
             initialized: false,
             _marker: PhantomData,
         }
     }
 
+    /// 获取内存索引中的键数量（`kv_index` 特性）。
+    ///
+    /// 索引包含数据库中所有有效的 KV，因此该值即为当前的键数量。
+    #[cfg(feature = "kv_index")]
+    pub fn index_len(&self) -> usize {
+        self.index.len()
+    }
+
+    /// 设置索引快照文件（`kv_snapshot` 特性）。
+    ///
+    /// 数据库正常关闭（实例被丢弃）时，内存索引会连同扇区表指纹一起保存到该文件；
+    /// 下次 `init()` 时若快照与 Flash 上的扇区表一致，将直接恢复索引并跳过全量 KV 检查，
+    /// 否则回退到原有的恢复流程。快照在恢复后立即删除，因此异常退出后总是执行完整检查。
+    /// 期间发生过写入或擦除失败时不会保存快照。
+    ///
+    /// **注意**: 此方法必须在 `init()` 之前调用。
+    #[cfg(feature = "kv_snapshot")]
+    pub fn set_index_snapshot<P: Into<std::path::PathBuf>>(&mut self, path: P) {
+        self.index.snapshot = Some(path.into());
+    }
+
     /// 设置数据库名称，仅用于日志输出。
     ///
     /// **注意**: 此方法必须在 `init()` 之前调用。
@@ -115,6 +187,55 @@ impl<S: NorFlash> KVDB<S> {
         self.fdb_kvdb_control_read(FDB_KVDB_CTRL_SET_NOT_FORMAT, &mut enable);
         return enable;
     }
+
+    /// 设置增量 GC 的预算，即每次写入后最多搬移的 KV 数量，`0` 表示禁用（默认）。
+    ///
+    /// 启用后，写入触发的 GC 不再一次性回收所有脏扇区，而是每次写入只搬移有限数量的 KV，
+    /// 从而限制单次写入的最大停顿时间。未完成的扇区会在后续写入或 [`KVDB::gc_step`] 中继续回收，
+    /// 掉电后则由初始化时的恢复检查完成。空间不足时仍会执行完整 GC。
+    pub fn set_gc_budget(&mut self, budget: usize) {
+        self.fdb_kvdb_control_write(crate::FDB_KVDB_CTRL_SET_GC_BUDGET, budget);
+    }
+
+    /// 获取增量 GC 的预算。
+    pub fn gc_budget(&self) -> usize {
+        let mut budget = 0usize;
+        self.fdb_kvdb_control_read(crate::FDB_KVDB_CTRL_GET_GC_BUDGET, &mut budget);
+        budget
+    }
+
+    /// 设置 GC 回收策略，默认为 [`GcPolicy::Sequential`]。
+    ///
+    /// 少量热点键频繁更新时，按地址顺序回收会反复搬移几乎全是有效数据的冷扇区，
+    /// [`GcPolicy::Greedy`] 或 [`GcPolicy::CostBenefit`] 会优先回收能以最少搬移量释放最多空间的扇区，
+    /// 从而降低写放大和擦除次数。代价是选择扇区时需要读取脏扇区内所有 KV 的头部。
+    pub fn set_gc_policy(&mut self, policy: GcPolicy) {
+        self.fdb_kvdb_control_write(crate::FDB_KVDB_CTRL_SET_GC_POLICY, policy as crate::fdb_kv_gc_policy_t);
+    }
+
+    /// 获取 GC 回收策略。
+    pub fn gc_policy(&self) -> GcPolicy {
+        let mut policy: crate::fdb_kv_gc_policy_t = 0;
+        self.fdb_kvdb_control_read(crate::FDB_KVDB_CTRL_GET_GC_POLICY, &mut policy);
+        policy.into()
+    }
+
+    /// 设置值压缩的阈值（`kv_compress` 特性），`0` 表示禁用压缩（默认）。
+    ///
+    /// 长度不小于阈值的值在写入时以 LZ4 压缩，并在 KV 头部记录压缩标志，
+    /// 只有压缩后确实变短时才会保存压缩数据。读取时根据标志透明解压，
+    /// 因此修改阈值不影响已写入的数据。压缩减少了每次写入的 Flash 流量，
+    /// 也减少了 GC 搬移 KV 时复制的数据量；阈值太小时压缩头部的开销得不偿失，一般取 128 左右。
+    #[cfg(feature = "kv_compress")]
+    pub fn set_compress_threshold(&mut self, threshold: usize) {
+        self.compress_threshold = threshold;
+    }
+
+    /// 获取值压缩的阈值（`kv_compress` 特性）。
+    #[cfg(feature = "kv_compress")]
+    pub fn compress_threshold(&self) -> usize {
+        self.compress_threshold
+    }
     /// 初始化数据库。
     ///
     /// 此方法会加载现有数据库或根据 `storage` 的容量创建一个新的数据库。
@@ -144,6 +265,10 @@ impl<S: NorFlash> KVDB<S> {
 
             // 只有这里获取才不会导致悬空指针
             self.user_data.instance = &mut self.storage as *mut _ as *mut c_void;
+            #[cfg(feature = "kv_index")]
+            {
+                self.inner.kv_index = &mut self.index as *mut _ as *mut c_void;
+            }
 
             #[cfg(feature = "log")]
             let name = self.name_buf.as_ptr() as *const c_char;
@@ -214,6 +339,26 @@ impl<S: NorFlash> KVDB<S> {
         unsafe { fdb_blob_read(self.handle() as *mut _, blob) }
     }
 
+    /// 内部方法：按阈值压缩值，不需要压缩或压缩后没有变短时返回 None
+    #[cfg(feature = "kv_compress")]
+    fn compress_value(&self, value: &[u8]) -> Option<alloc::vec::Vec<u8>> {
+        if self.compress_threshold == 0 || value.len() < self.compress_threshold {
+            return None;
+        }
+        compress::compress(value)
+    }
+
+    /// 内部方法：读取 KV 在 Flash 上保存的原始（可能是压缩的）值
+    #[cfg(feature = "kv_compress")]
+    pub(super) fn read_stored(&mut self, entry: &KVEntry) -> Result<alloc::vec::Vec<u8>, Error> {
+        let mut stored = alloc::vec![0u8; entry.value_len()];
+        let mut blob = fdb_blob_make_by(&mut stored, entry, 0);
+        if self.fdb_blob_read(&mut blob) != stored.len() {
+            return Err(Error::ReadError);
+        }
+        Ok(stored)
+    }
+
     /// 内部方法：控制数据库写入操作
     #[inline]
     fn fdb_kvdb_control_write<T>(&mut self, cmd: u32, arg: T) {
@@ -236,11 +381,75 @@ impl<S: NorFlash> KVDB<S> {
     /// # 参数
     /// - `key`: 键
     /// - `value`: 值，一个字节切片。
+    ///
+    /// 启用 `kv_compress` 特性时，较长的值会被压缩后保存，参见 [`KVDB::set_compress_threshold`]。
     pub fn set(&mut self, key: &str, value: &[u8]) -> Result<(), Error> {
+        #[cfg(feature = "kv_compress")]
+        if let Some(stored) = self.compress_value(value) {
+            let handle = self.handle();
+            let cstr_key = self.to_cstr(key)?;
+            let mut blob = fdb_blob_make_write(&stored);
+            return Error::convert(unsafe {
+                crate::fdb_kv_set_blob_ex(handle, cstr_key.as_ptr(), &mut blob, crate::FDB_KV_FLAG_COMPRESSED as u8)
+            });
+        }
         let mut blob = fdb_blob_make_write(value); // 创建写入用的blob结构
         self.fdb_blob_write(key, &mut blob)
     }
 
+    /// 原子地写入一批键值对。
+    ///
+    /// 所有键值对在同一个扇区内连续写入，并通过一次状态提交（仅一次同步）生效：
+    /// 即使中途掉电，重启后也只会看到“全部写入”或“全部未写入”两种结果。
+    ///
+    /// # 参数
+    /// - `items`: 要写入的 `(键, 值)` 列表，键不能重复。
+    ///
+    /// # 返回
+    /// - `Err(Error::KvNameExist)`: 列表中存在重复的键。
+    /// - `Err(Error::SavedFull)`: 整批数据超过一个扇区或空间不足。
+    #[cfg(feature = "alloc")]
+    pub fn write_batch(&mut self, items: &[(&str, &[u8])]) -> Result<(), Error> {
+        // 所有键以 '\0' 结尾依次存放在同一个缓冲区中
+        let mut keys = alloc::vec::Vec::new();
+        for (key, _) in items {
+            if key.len() > FDB_KV_NAME_MAX as usize {
+                return Err(Error::KvNameError);
+            }
+            keys.extend_from_slice(key.as_bytes());
+            keys.push(0);
+        }
+        let mut offset = 0;
+        let mut batch: alloc::vec::Vec<crate::fdb_kv_batch_item> = items
+            .iter()
+            .map(|(key, value)| {
+                let item = crate::fdb_kv_batch_item {
+                    key: keys[offset..].as_ptr() as *const c_char,
+                    value: value.as_ptr() as *const c_void,
+                    value_len: value.len(),
+                    #[cfg(feature = "kv_compress")]
+                    flags: 0,
+                };
+                offset += key.len() + 1;
+                item
+            })
+            .collect();
+        // 压缩后的值必须存活到整批写入完成
+        #[cfg(feature = "kv_compress")]
+        let compressed: alloc::vec::Vec<_> = items.iter().map(|(_, value)| self.compress_value(value)).collect();
+        #[cfg(feature = "kv_compress")]
+        for (item, stored) in batch.iter_mut().zip(&compressed) {
+            if let Some(stored) = stored {
+                item.value = stored.as_ptr() as *const c_void;
+                item.value_len = stored.len();
+                item.flags = crate::FDB_KV_FLAG_COMPRESSED as u8;
+            }
+        }
+        Error::convert(unsafe {
+            crate::fdb_kv_set_batch(self.handle(), batch.as_mut_ptr(), batch.len())
+        })
+    }
+
     /// 根据键获取其值。
     ///
     /// # 参数
@@ -263,13 +472,17 @@ impl<S: NorFlash> KVDB<S> {
                     unsafe { data.set_len(kv.value_len()) }; // 预分配缓冲区大小
 
                     // 创建读取用的blob结构
-                    let mut blob = fdb_blob_make_by(&mut data, &kv.into(), 0);
+                    let mut blob = fdb_blob_make_by(&mut data, &kv, 0);
 
                     // 读取数据
                     let read_len = self.fdb_blob_read(&mut blob);
                     if read_len != data.len() {
                         return Err(Error::ReadError);
                     }
+                    #[cfg(feature = "kv_compress")]
+                    if kv.is_compressed() {
+                        return compress::decompress(&data).map(Some);
+                    }
                     Ok(Some(data))
                 }
                 _ => Ok(None), // 其他状态(如已删除)返回None
@@ -278,6 +491,126 @@ impl<S: NorFlash> KVDB<S> {
         }
     }
 
+    /// 根据键获取其值，并读入调用者提供的缓冲区，不分配内存。
+    ///
+    /// 值的长度可以事先通过 [`KVDB::get_entry`] 获取，压缩保存的值除外（参见 [`KVEntry::is_compressed`]），
+    /// 其解压后的长度只能在读取时得知。
+    ///
+    /// # 参数
+    /// - `key`: 要查询的键。
+    /// - `buf`: 接收值的缓冲区，长度不能小于值的长度。
+    ///
+    /// # 返回
+    /// - `Ok(usize)`: 值的长度，值保存在 `buf[..len]` 中。
+    /// - `Err(Error::KeyNotFound)`: 未找到键。
+    /// - `Err(Error::InvalidArgument)`: 缓冲区太小，`buf` 的内容不会被修改。
+    pub fn get_into(&mut self, key: &str, buf: &mut [u8]) -> Result<usize, Error> {
+        match self.fdb_kv_get_obj(key)? {
+            Some(entry) => self.read_value_into(&entry, buf),
+            None => Err(Error::KeyNotFound),
+        }
+    }
+
+    /// 将 KV 的值读入缓冲区，返回值的长度（压缩保存的值会被解压）。
+    ///
+    /// `entry` 来自 [`KVDB::get_entry`]、迭代器或 [`KVDB::scan_prefix`]，并且期间没有写入过数据库。
+    ///
+    /// # 返回
+    /// - `Err(Error::KeyNotFound)`: KV 已被删除。
+    /// - `Err(Error::InvalidArgument)`: 缓冲区太小，`buf` 的内容不会被修改。
+    pub fn read_value_into(&mut self, entry: &KVEntry, buf: &mut [u8]) -> Result<usize, Error> {
+        if !matches!(entry.status(), KVStatus::PRE_WRITE | KVStatus::Write) {
+            return Err(Error::KeyNotFound);
+        }
+        #[cfg(feature = "kv_compress")]
+        if entry.is_compressed() {
+            let stored = self.read_stored(entry)?;
+            return compress::decompress_into(&stored, buf);
+        }
+        let value_len = entry.value_len();
+        if buf.len() < value_len {
+            return Err(Error::InvalidArgument);
+        }
+        let mut blob = fdb_blob_make_by(&mut buf[..value_len], entry, 0);
+        if self.fdb_blob_read(&mut blob) != value_len {
+            return Err(Error::ReadError);
+        }
+        Ok(value_len)
+    }
+
+    /// 获取键对应的 KV 元数据，不读取值。
+    ///
+    /// # 返回
+    /// - `Ok(Some(KVEntry))`: 找到键。
+    /// - `Ok(None)`: 未找到键。
+    pub fn get_entry(&mut self, key: &str) -> Result<Option<KVEntry>, Error> {
+        self.fdb_kv_get_obj(key)
+    }
+
+    /// 零拷贝地获取 KV 的值，返回的切片直接指向存储后端的内存。
+    ///
+    /// 切片借用了数据库，因此在其有效期内无法写入，数据不会被修改或回收。
+    ///
+    /// # 返回
+    /// - `Some(&[u8])`: KV 有效且存储后端能直接访问其值。
+    /// - `None`: KV 已被删除、值以压缩形式保存，或存储后端不能直接访问该区间。
+    pub fn value_slice(&self, entry: &KVEntry) -> Option<&[u8]>
+    where
+        S: DirectRead,
+    {
+        #[cfg(feature = "kv_compress")]
+        if entry.is_compressed() {
+            return None;
+        }
+        match entry.status() {
+            KVStatus::PRE_WRITE | KVStatus::Write => self
+                .storage
+                .direct(entry.inner.addr.value, entry.value_len()),
+            _ => None,
+        }
+    }
+
+    /// 以借用切片的形式访问键对应的值，并返回闭包的结果。
+    ///
+    /// 存储后端能直接访问该值时不会分配内存也不会拷贝；否则（启用 `alloc` 时）
+    /// 退回到普通读取，将值读入临时缓冲区后再调用闭包。
+    ///
+    /// # 返回
+    /// - `Ok(Some(R))`: 找到键，返回闭包的结果。
+    /// - `Ok(None)`: 未找到键。
+    /// - `Err(Error::ReadError)`: 无法直接访问且未启用 `alloc`，或读取失败。
+    pub fn with_value<R, F>(&mut self, key: &str, f: F) -> Result<Option<R>, Error>
+    where
+        S: DirectRead,
+        F: FnOnce(&[u8]) -> R,
+    {
+        let entry = match self.fdb_kv_get_obj(key)? {
+            Some(entry) => entry,
+            None => return Ok(None),
+        };
+        if !matches!(entry.status(), KVStatus::PRE_WRITE | KVStatus::Write) {
+            return Ok(None);
+        }
+        if let Some(value) = self.value_slice(&entry) {
+            return Ok(Some(f(value)));
+        }
+        #[cfg(feature = "alloc")]
+        {
+            let mut data = alloc::vec![0u8; entry.value_len()];
+            let mut blob = fdb_blob_make_by(&mut data, &entry, 0);
+            if self.fdb_blob_read(&mut blob) != data.len() {
+                return Err(Error::ReadError);
+            }
+            #[cfg(feature = "kv_compress")]
+            if entry.is_compressed() {
+                return Ok(Some(f(&compress::decompress(&data)?)));
+            }
+            Ok(Some(f(&data)))
+        }
+        #[cfg(not(feature = "alloc"))]
+        Err(Error::ReadError)
+    }
+
     /// 删除一个键值对。
     ///
     /// 这是一个逻辑删除，数据占用的空间将在未来的垃圾回收 (GC) 过程中被回收。
@@ -297,9 +630,55 @@ impl<S: NorFlash> KVDB<S> {
         Error::convert(unsafe { fdb_kv_set_default(self.handle()) })
     }
 
+    /// 执行一步增量 GC，最多搬移 `budget` 个 KV。
+    ///
+    /// 可在空闲时主动调用，提前回收脏扇区，避免写入路径上发生长时间的 GC。
+    /// 只有空扇区不足时才会开始回收新的扇区。
+    ///
+    /// # 返回
+    /// - `Ok(true)`: 仍有待回收的工作，可以继续调用。
+    /// - `Ok(false)`: 当前无需回收。
+    /// - `Err(Error::InvalidArgument)`: `budget` 为 0。
+    pub fn gc_step(&mut self, budget: usize) -> Result<bool, Error> {
+        if budget == 0 {
+            return Err(Error::InvalidArgument);
+        }
+        let mut pending = false;
+        Error::convert(unsafe { crate::fdb_kv_gc_step(self.handle(), budget, &mut pending) })?;
+        Ok(pending)
+    }
+
+    /// 获取当前的 GC 压力，用于判断 GC 是否跟不上写入。
+    pub fn gc_pressure(&self) -> GcPressure {
+        let mut pressure = unsafe { core::mem::zeroed::<crate::fdb_kv_gc_pressure>() };
+        unsafe { crate::fdb_kv_gc_pressure(self.handle(), &mut pressure) };
+        pressure.into()
+    }
+
+    /// 获取存储后端的引用，例如读取 [`SimFlash`](crate::SimFlash) 的访问计数。
+    pub fn storage(&self) -> &S {
+        &self.storage
+    }
+
+    /// 获取运行统计（`stats` 特性），包括存储后端的访问次数和 C 库的写入、查找、GC 计数。
+    ///
+    /// 统计从创建实例开始累计，包括初始化过程中的访问，可用 [`KVDB::reset_stats`] 清零。
+    #[cfg(feature = "stats")]
+    pub fn stats(&self) -> crate::KvStats {
+        crate::KvStats::new(&self.inner.stats, self.user_data.stats.borrow().clone())
+    }
+
+    /// 清零运行统计（`stats` 特性）。
+    #[cfg(feature = "stats")]
+    pub fn reset_stats(&mut self) {
+        self.inner.stats = Default::default();
+        *self.user_data.stats.borrow_mut() = Default::default();
+    }
+
     /// 获取一个用于流式读取键值的 `KVReader`。
     ///
     /// 这对于读取大尺寸的值非常有用，可以避免一次性将整个值加载到内存中。
+    /// 压缩保存的值除外，它们会在读取时整体解压，参见 [`KVReader`]。
     pub fn get_reader<'a>(&'_ mut self, key: &str) -> Result<KVReader<'_, S>, Error> {
         let handle = self.handle();
         let cstr_key = self.to_cstr(key)?;
@@ -316,6 +695,13 @@ impl<S: NorFlash> KVDB<S> {
     pub fn iter(&mut self) -> KVDBIterator<'_, S> {
         KVDBIterator::new(self)
     }
+
+    /// 获取一个同时读取值的迭代器，所有值都读入同一个调用者提供的缓冲区，不分配内存。
+    ///
+    /// 详见 [`KVDBValueIter`]。
+    pub fn iter_values<'b>(&mut self, buf: &'b mut [u8]) -> KVDBValueIter<'_, 'b, S> {
+        KVDBValueIter::new(self, buf)
+    }
 }
 
 impl<S: NorFlash> RawHandle for KVDB<S> {
@@ -329,6 +715,10 @@ impl<S: NorFlash> Drop for KVDB<S> {
     fn drop(&mut self) {
         if self.initialized {
             unsafe {
+                #[cfg(feature = "kv_snapshot")]
+                if !self.user_data.failed.get() {
+                    let _ = self.index.save_snapshot(self.handle());
+                }
                 fdb_kvdb_deinit(self.handle());
             }
         }
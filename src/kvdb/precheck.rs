@@ -0,0 +1,161 @@
+//! 并行的启动校验（`kv_parallel_load` 特性）。
+//!
+//! 加载数据库时，C 库需要读取每个 KV 的全部数据来校验 CRC32，这部分工作量与数据库大小成正比，
+//! 而且各个扇区之间互不相关。[`KVDB::init_parallel`] 在加载之前把扇区分给多个线程，
+//! 每个线程使用自己的只读存储实例调用 `fdb_kv_sector_precheck` 校验 KV，
+//! 结果以 `地址 -> (长度, CRC32)` 的形式交给 C 库。加载过程中头部与结果一致的 KV 不再重新读取数据，
+//! 掉电恢复、GC 等会修改 Flash 的操作仍然在调用线程中按原有顺序执行。
+
+use super::KVDB;
+use crate::{fdb_kv_sector_precheck, fdb_kvdb, fdb_kvdb_t, Error, FlashDispatch};
+use core::ffi::c_void;
+use embedded_storage::nor_flash::{NorFlash, ReadNorFlash};
+use std::collections::HashMap;
+
+/// 校验通过的 KV：地址 -> (长度, CRC32)
+#[derive(Default)]
+pub(crate) struct Precheck {
+    map: HashMap<u32, (u32, u32)>,
+}
+
+type Checked = Vec<(u32, u32, u32)>;
+
+unsafe extern "C" fn precheck_cb(addr: u32, len: u32, crc32: u32, arg: *mut c_void) {
+    (*(arg as *mut Checked)).push((addr, len, crc32));
+}
+
+/// 使用独立的只读数据库对象校验一组扇区
+fn precheck_sectors<R: ReadNorFlash>(
+    mut storage: R,
+    sec_size: u32,
+    max_size: u32,
+    sectors: core::ops::Range<u32>,
+) -> Checked {
+    // 与 KVDBReader 相同，只有 parent 中的扇区大小、容量和读取回调会被 C 库使用
+    let mut inner: fdb_kvdb = Default::default();
+    inner.parent.mode = crate::fdb_storage_type_FDB_STORAGE_CUSTOM;
+    inner.parent.sec_size = sec_size;
+    inner.parent.max_size = max_size;
+    inner.parent.init_ok = true;
+    let mut dispatch = FlashDispatch::read_only::<R>();
+    dispatch.instance = &mut storage as *mut _ as *mut c_void;
+    inner.parent.user_data = &mut dispatch as *mut _ as *mut c_void;
+
+    let mut checked = Checked::new();
+    for sector in sectors {
+        unsafe {
+            fdb_kv_sector_precheck(
+                &mut inner,
+                sector * sec_size,
+                Some(precheck_cb),
+                &mut checked as *mut _ as *mut c_void,
+            )
+        };
+    }
+    checked
+}
+
+impl<S: NorFlash> KVDB<S> {
+    /// 与 [`KVDB::init`] 相同，但使用多个线程并行校验各个扇区中的 KV（`kv_parallel_load` 特性）。
+    ///
+    /// 每个线程通过 `open` 打开一个只读的存储实例，它们必须与数据库使用同一份数据，
+    /// 容量也必须相同（例如对同一目录再次调用 [`StdStorage::new`](crate::storage::StdStorage::new)）。
+    /// 校验期间不会写入 Flash；之后的掉电恢复和 GC 仍在当前线程中串行执行。
+    /// 数据库较大、存储后端支持并发读取（如 SSD 上的文件）时，启动时间随线程数近似线性缩短。
+    ///
+    /// # 参数
+    /// - `default_kvs`: 同 [`KVDB::init`]。
+    /// - `threads`: 线程数，`0` 表示使用 CPU 的可用并行度。
+    /// - `open`: 为每个线程打开只读存储实例。
+    ///
+    /// # 返回
+    /// - `Err(Error::InvalidArgument)`: 存储容量与数据库不一致。
+    pub fn init_parallel<R, F>(
+        &mut self,
+        default_kvs: Option<&'static crate::fdb_default_kv>,
+        threads: usize,
+        open: F,
+    ) -> Result<(), Error>
+    where
+        R: ReadNorFlash,
+        F: Fn() -> Result<R, Error> + Sync,
+    {
+        if self.initialized {
+            return Ok(());
+        }
+        let sec_size = S::ERASE_SIZE as u32;
+        let max_size = self.storage.capacity() as u32;
+        let sector_num = max_size / sec_size;
+        let threads = match threads {
+            0 => std::thread::available_parallelism().map_or(1, |n| n.get()),
+            n => n,
+        }
+        .clamp(1, sector_num.max(1) as usize) as u32;
+
+        // 每个线程校验一段连续的扇区，保持存储后端的顺序读取
+        let per_thread = sector_num.div_ceil(threads);
+        let results: Vec<Result<Checked, Error>> = std::thread::scope(|scope| {
+            let open = &open;
+            let workers: Vec<_> = (0..threads)
+                .map(|i| {
+                    let sectors = (i * per_thread).min(sector_num)..((i + 1) * per_thread).min(sector_num);
+                    scope.spawn(move || {
+                        let storage = open()?;
+                        if storage.capacity() != max_size as usize {
+                            return Err(Error::InvalidArgument);
+                        }
+                        Ok(precheck_sectors(storage, sec_size, max_size, sectors))
+                    })
+                })
+                .collect();
+            workers
+                .into_iter()
+                .map(|worker| worker.join().unwrap_or(Err(Error::ReadError)))
+                .collect()
+        });
+
+        let mut precheck = Box::new(Precheck::default());
+        for checked in results {
+            precheck
+                .map
+                .extend(checked?.into_iter().map(|(addr, len, crc32)| (addr, (len, crc32))));
+        }
+
+        self.inner.kv_precheck = &mut *precheck as *mut Precheck as *mut c_void;
+        let result = self.init(default_kvs);
+        // 结果只在加载期间有效
+        self.inner.kv_precheck = core::ptr::null_mut();
+        result
+    }
+}
+
+impl KVDB<crate::storage::StdStorage> {
+    /// 与 [`KVDB::new_file`] 相同，但使用 `threads` 个线程并行校验数据库（`kv_parallel_load` 特性），
+    /// 参见 [`KVDB::init_parallel`]。
+    pub fn new_file_parallel(
+        name: &str,
+        path: &str,
+        sec_size: u32,
+        max_size: u32,
+        default_kvs: Option<&'static crate::fdb_default_kv>,
+        threads: usize,
+    ) -> Result<Box<Self>, Error> {
+        use crate::storage::{FileStrategy, StdStorage};
+        let open = || StdStorage::new(path, name, sec_size, max_size, FileStrategy::Multi).map_err(Error::from);
+
+        let mut db = Box::new(KVDB::new_with_sync(open()?));
+        db.set_name(name)?;
+        #[cfg(feature = "kv_snapshot")]
+        db.set_index_snapshot(std::path::Path::new(path).join(format!("{}.fdb.idx", name)));
+        db.init_parallel(default_kvs, threads, open)?;
+        Ok(db)
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn fdb_kv_precheck_get(db: fdb_kvdb_t, addr: u32, len: u32, crc32: u32) -> bool {
+    match ((*db).kv_precheck as *const Precheck).as_ref() {
+        Some(precheck) => precheck.map.get(&addr) == Some(&(len, crc32)),
+        None => false,
+    }
+}
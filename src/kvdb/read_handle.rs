@@ -0,0 +1,167 @@
+use super::index::SharedIndex;
+use super::{KVEntry, KVDB};
+use crate::{fdb_kv, fdb_kv_read_obj, fdb_kvdb, Error, FlashDispatch, FDB_KV_NAME_MAX};
+use core::ffi::{c_char, c_void};
+use embedded_storage::nor_flash::{NorFlash, ReadNorFlash};
+use std::sync::Arc;
+
+/// KVDB 的只读句柄，可以移动到其他线程中与写入者并发读取。
+///
+/// 通过 [`KVDB::reader`] 创建。每个句柄拥有自己的存储实例和一个只用于读取的 C 数据库对象，
+/// 与写入者共享的只有内存索引。因此多个句柄之间、句柄与写入者之间都不需要互斥，
+/// 存储后端只需要支持多个实例同时读取同一份数据（例如以独立文件描述符进行定位读取的
+/// [`StdStorage`](crate::storage::StdStorage)）。
+///
+/// 一致性由索引的版本号保证（与 seqlock 相同）：读取前后分别记录版本号，
+/// 期间索引发生过变化则重新读取。KV 节点的 CRC 校验则保证不会读到写了一半的数据。
+/// 读取到的值总是某一时刻的最新值，但句柄之间不保证读取的先后顺序。
+pub struct KVDBReader<R: ReadNorFlash> {
+    // 只读的数据库对象，只有 parent 中的扇区大小、容量和读取回调会被 C 库使用
+    inner: fdb_kvdb,
+    storage: R,
+    user_data: FlashDispatch,
+    index: Arc<SharedIndex>,
+    key_buf: [u8; FDB_KV_NAME_MAX as usize + 1],
+}
+
+// 内部的裸指针只在调用 C 库前指向句柄自身的字段，不会与其他线程共享
+unsafe impl<R: ReadNorFlash + Send> Send for KVDBReader<R> {}
+
+impl<S: NorFlash> KVDB<S> {
+    /// 创建一个只读句柄（`kv_index` + `std` 特性）。
+    ///
+    /// # 参数
+    /// - `storage`: 句柄使用的存储实例，必须与数据库使用同一份数据，容量也必须相同。
+    ///
+    /// # 返回
+    /// - `Err(Error::InitFailed)`: 数据库尚未初始化或索引不可用。
+    /// - `Err(Error::InvalidArgument)`: 存储容量与数据库不一致。
+    pub fn reader<R: ReadNorFlash + Send>(&self, storage: R) -> Result<KVDBReader<R>, Error> {
+        if !self.initialized || !self.inner.kv_index_ready {
+            return Err(Error::InitFailed);
+        }
+        if storage.capacity() != self.storage.capacity() {
+            return Err(Error::InvalidArgument);
+        }
+
+        let mut inner: fdb_kvdb = Default::default();
+        inner.parent.mode = crate::fdb_storage_type_FDB_STORAGE_CUSTOM;
+        inner.parent.sec_size = self.inner.parent.sec_size;
+        inner.parent.max_size = self.inner.parent.max_size;
+        inner.parent.init_ok = true;
+        Ok(KVDBReader {
+            inner,
+            storage,
+            user_data: FlashDispatch::read_only::<R>(),
+            index: self.index.shared.clone(),
+            key_buf: [0; FDB_KV_NAME_MAX as usize + 1],
+        })
+    }
+
+    /// 内存索引的版本号（`kv_index` + `std` 特性），每次修改索引都会递增。
+    pub fn generation(&self) -> u64 {
+        self.index.shared.generation()
+    }
+}
+
+impl<R: ReadNorFlash> KVDBReader<R> {
+    /// 根据键获取其值。
+    ///
+    /// # 返回
+    /// - `Ok(Some(Vec<u8>))`: 找到键，返回值的副本。
+    /// - `Ok(None)`: 未找到键。
+    pub fn get(&mut self, key: &str) -> Result<Option<alloc::vec::Vec<u8>>, Error> {
+        self.lookup(key, |storage, entry| {
+            let mut data = alloc::vec![0; entry.value_len()];
+            storage
+                .read(entry.inner.addr.value, &mut data)
+                .map_err(|_| Error::ReadError)?;
+            #[cfg(feature = "kv_compress")]
+            if entry.is_compressed() {
+                return super::compress::decompress(&data);
+            }
+            Ok(data)
+        })
+    }
+
+    /// 根据键获取其值，并读入调用者提供的缓冲区，不分配内存。
+    ///
+    /// # 返回
+    /// - `Ok(usize)`: 值的长度，值保存在 `buf[..len]` 中。
+    /// - `Err(Error::KeyNotFound)`: 未找到键。
+    /// - `Err(Error::InvalidArgument)`: 缓冲区太小。
+    pub fn get_into(&mut self, key: &str, buf: &mut [u8]) -> Result<usize, Error> {
+        let found = self.lookup(key, |storage, entry| {
+            #[cfg(feature = "kv_compress")]
+            if entry.is_compressed() {
+                let mut stored = alloc::vec![0; entry.value_len()];
+                storage
+                    .read(entry.inner.addr.value, &mut stored)
+                    .map_err(|_| Error::ReadError)?;
+                return super::compress::decompress_into(&stored, buf);
+            }
+            let value_len = entry.value_len();
+            if buf.len() < value_len {
+                return Err(Error::InvalidArgument);
+            }
+            storage
+                .read(entry.inner.addr.value, &mut buf[..value_len])
+                .map_err(|_| Error::ReadError)?;
+            Ok(value_len)
+        })?;
+        found.ok_or(Error::KeyNotFound)
+    }
+
+    /// 获取键对应的 KV 元数据，不读取值。
+    pub fn get_entry(&mut self, key: &str) -> Result<Option<KVEntry>, Error> {
+        self.lookup(key, |_, entry| Ok(entry.clone()))
+    }
+
+    /// 内存索引的版本号，参见 [`KVDB::generation`]。
+    pub fn generation(&self) -> u64 {
+        self.index.generation()
+    }
+
+    /// 查找键并校验 KV 节点，在版本号不变的前提下对其执行 `f`
+    fn lookup<T, F>(&mut self, key: &str, mut f: F) -> Result<Option<T>, Error>
+    where
+        F: FnMut(&mut R, &KVEntry) -> Result<T, Error>,
+    {
+        let key_len = key.len();
+        if key_len > FDB_KV_NAME_MAX as usize {
+            return Err(Error::KvNameError);
+        }
+        self.key_buf[..key_len].copy_from_slice(key.as_bytes());
+        self.key_buf[key_len] = 0;
+
+        loop {
+            let generation = self.index.generation();
+            // 索引包含所有有效的 KV，不在索引中即不存在
+            let addr = match self.index.read().get(key.as_bytes()) {
+                Some(&addr) => addr,
+                None => return Ok(None),
+            };
+
+            // 句柄可能被移动过，每次调用 C 库前重新设置指针
+            self.user_data.instance = &mut self.storage as *mut _ as *mut c_void;
+            self.inner.parent.user_data = &mut self.user_data as *mut _ as *mut c_void;
+            let handle = &mut self.inner as *mut fdb_kvdb;
+
+            let mut kv_obj = unsafe { core::mem::zeroed::<fdb_kv>() };
+            let valid = unsafe {
+                fdb_kv_read_obj(handle, addr, self.key_buf.as_ptr() as *const c_char, &mut kv_obj)
+            };
+            let result = valid.then(|| f(&mut self.storage, &kv_obj.into()));
+
+            if self.index.generation() != generation {
+                // 读取期间索引发生了变化，节点可能已被覆盖或回收
+                std::thread::yield_now();
+                continue;
+            }
+            return match result {
+                Some(result) => result.map(Some),
+                None => Err(Error::ReadError),
+            };
+        }
+    }
+}
@@ -7,10 +7,15 @@ use super::{KVEntry, KVDB};
 ///
 /// 实现了embedded-io的Read和Seek trait，用于流式读取KV值，适合处理大型数据
 /// 生命周期`'a`确保读取器不会超过其关联的KVDB实例的生命周期
+///
+/// 压缩保存的值（`kv_compress` 特性）会在第一次读取或定位时整体解压到内存中，
+/// 之后的读取与定位都针对解压后的数据。
 pub struct KVReader<'a, S: NorFlash> {
     position: usize,        // 当前读取位置
     inner: &'a mut KVDB<S>, // 指向KVDB实例的指针
     pub entry: KVEntry,     // KV对象元数据
+    #[cfg(feature = "kv_compress")]
+    decoded: Option<alloc::vec::Vec<u8>>, // 解压后的值
 }
 
 impl<'a, S: NorFlash> KVReader<'a, S> {
@@ -19,8 +24,23 @@ impl<'a, S: NorFlash> KVReader<'a, S> {
             inner: kvdb,
             entry: entry,
             position: 0,
+            #[cfg(feature = "kv_compress")]
+            decoded: None,
         };
     }
+
+    /// 值的长度，压缩保存的值为解压后的长度
+    fn total_len(&mut self) -> Result<usize, Error> {
+        #[cfg(feature = "kv_compress")]
+        if self.entry.is_compressed() {
+            if self.decoded.is_none() {
+                let stored = self.inner.read_stored(&self.entry)?;
+                self.decoded = Some(super::compress::decompress(&stored)?);
+            }
+            return Ok(self.decoded.as_ref().map_or(0, |decoded| decoded.len()));
+        }
+        Ok(self.entry.value_len())
+    }
 }
 
 impl<'a, S: NorFlash> embedded_io::ErrorType for KVReader<'a, S> {
@@ -36,9 +56,17 @@ impl<'a, S: NorFlash> embedded_io::Read for KVReader<'a, S> {
     /// # 返回值
     /// 成功时返回读取的字节数，失败时返回Error
     fn read(&mut self, buf: &mut [u8]) -> Result<usize, Self::Error> {
-        if self.position >= self.entry.value_len() {
+        let total_len = self.total_len()?;
+        if self.position >= total_len {
             return Ok(0); // EOF
         }
+        #[cfg(feature = "kv_compress")]
+        if let Some(decoded) = &self.decoded {
+            let read_len = buf.len().min(total_len - self.position);
+            buf[..read_len].copy_from_slice(&decoded[self.position..self.position + read_len]);
+            self.position += read_len;
+            return Ok(read_len);
+        }
         let mut blob = fdb_blob_make_by(buf, &self.entry, self.position);
         let read_len = unsafe { fdb_blob_read(self.inner.handle() as *mut _, &mut blob) };
         self.position += read_len;
@@ -55,7 +83,7 @@ impl<'a, S: NorFlash> embedded_io::Seek for KVReader<'a, S> {
     /// # 返回值
     /// 成功时返回新的位置，失败时返回Error
     fn seek(&mut self, pos: embedded_io::SeekFrom) -> Result<u64, Self::Error> {
-        let total_len = self.entry.value_len();
+        let total_len = self.total_len()?;
         // 根据SeekFrom计算新位置
         let new_pos = match pos {
             embedded_io::SeekFrom::Start(offset) => offset as usize,
@@ -0,0 +1,73 @@
+use super::{KVEntry, KVDB};
+use crate::Error;
+use alloc::vec::Vec;
+use embedded_storage::nor_flash::NorFlash;
+
+impl<S: NorFlash> KVDB<S> {
+    /// 列出所有以 `prefix` 开头的键（`alloc` 特性），结果按键排序。
+    ///
+    /// 适用于以 `dev/<id>/<field>` 这类带命名空间的键：启用 `kv_index` 且索引可用时，
+    /// 直接在有序的内存索引中定位该前缀的区间，耗时只与结果数量有关；
+    /// 否则退回到遍历整个数据库，只比较 KV 名称，不读取任何值。
+    ///
+    /// # 返回
+    /// - `Ok(Vec<KVEntry>)`: 匹配的 KV 元数据，值可以通过 [`KVDB::read_value_into`] 读取，无需再次查找。
+    pub fn scan_prefix(&mut self, prefix: &str) -> Result<Vec<KVEntry>, Error> {
+        let prefix = prefix.as_bytes();
+        self.scan(prefix, |name| name.starts_with(prefix))
+    }
+
+    /// 列出所有位于 `[start, end)` 区间内的键（`alloc` 特性），按字节序比较，结果按键排序。
+    ///
+    /// 查找方式与 [`KVDB::scan_prefix`] 相同。
+    pub fn scan_range(&mut self, start: &str, end: &str) -> Result<Vec<KVEntry>, Error> {
+        let end = end.as_bytes();
+        self.scan(start.as_bytes(), |name| name < end)
+    }
+
+    /// 内部方法：收集键不小于 `lower` 且满足 `pred` 的 KV，`pred` 对排序后的键必须是前缀连续的
+    fn scan(&mut self, lower: &[u8], pred: impl Fn(&[u8]) -> bool) -> Result<Vec<KVEntry>, Error> {
+        #[cfg(feature = "kv_index")]
+        if self.initialized && self.inner.kv_index_ready {
+            return self.scan_index(lower, pred);
+        }
+
+        let mut entries: Vec<KVEntry> = self
+            .iter()
+            .filter(|entry| {
+                let name = entry.name_bytes();
+                name >= lower && pred(name)
+            })
+            .collect();
+        entries.sort_unstable_by(|a, b| a.name_bytes().cmp(b.name_bytes()));
+        Ok(entries)
+    }
+
+    /// 内部方法：在内存索引中查找区间，逐个读取并校验 KV 节点，校验失败时回退到在 Flash 上查找该键
+    #[cfg(feature = "kv_index")]
+    fn scan_index(&mut self, lower: &[u8], pred: impl Fn(&[u8]) -> bool) -> Result<Vec<KVEntry>, Error> {
+        use crate::RawHandle;
+        let found = self.index.range(lower, pred);
+        let mut entries = Vec::with_capacity(found.len());
+        for (name, addr) in found {
+            // 索引中的键必然不超过 FDB_KV_NAME_MAX
+            self.key_buf[..name.len()].copy_from_slice(&name);
+            self.key_buf[name.len()] = 0;
+            let mut kv_obj = unsafe { core::mem::zeroed::<crate::fdb_kv>() };
+            let valid = unsafe {
+                crate::fdb_kv_read_obj(self.handle(), addr, self.key_buf.as_ptr() as *const core::ffi::c_char, &mut kv_obj)
+            };
+            // 索引可能已经过期（例如节点被其他对象覆盖或被外部损坏），此时与 find_kv 一致：
+            // 在 Flash 上重新查找该键并修正索引，确实不存在时才从索引中移除
+            let live = valid
+                || unsafe {
+                    !crate::fdb_kv_get_obj(self.handle(), self.key_buf.as_ptr() as *const core::ffi::c_char, &mut kv_obj)
+                        .is_null()
+                };
+            if live {
+                entries.push(kv_obj.into());
+            }
+        }
+        Ok(entries)
+    }
+}
@@ -0,0 +1,167 @@
+use super::{KVEntry, SharedKVDB, KVDB};
+use crate::{fdb_calc_crc32, Error};
+use embedded_storage::nor_flash::NorFlash;
+
+/// 按键的哈希把数据分布到多个独立 KVDB 实例上的数据库（`std` 特性）。
+///
+/// 每个分片都是一个完整的 [`SharedKVDB`]，拥有自己的存储（目录或 Flash 分区）、写入路径、GC 和索引，
+/// 因此查找、GC 和加载的开销只与单个分片的大小有关，不同分片上的操作也可以在多个线程中同时进行。
+///
+/// 键通过 CRC32 映射到分片，结果与平台和进程无关；分片数量一旦确定就不能修改，
+/// 否则已有的键会被路由到错误的分片，[`ShardedKVDB::new_file`] 会拒绝以不同的分片数量打开。跨分片的操作（如 [`ShardedKVDB::iter`]）逐个分片进行，
+/// 不保证所有分片处于同一时刻的状态。
+pub struct ShardedKVDB<S: NorFlash> {
+    shards: Vec<SharedKVDB<S>>,
+}
+
+impl<S: NorFlash> ShardedKVDB<S> {
+    /// 由一组 KVDB 实例创建分片数据库，分片的顺序决定了键的路由，每次打开时必须保持一致。
+    ///
+    /// # 返回
+    /// - `Err(Error::InvalidArgument)`: 没有提供任何分片。
+    pub fn new(shards: Vec<Box<KVDB<S>>>) -> Result<Self, Error> {
+        if shards.is_empty() {
+            return Err(Error::InvalidArgument);
+        }
+        Ok(Self {
+            shards: shards.into_iter().map(SharedKVDB::new).collect(),
+        })
+    }
+
+    /// 分片数量。
+    pub fn shard_count(&self) -> usize {
+        self.shards.len()
+    }
+
+    /// 键所在的分片序号。
+    pub fn shard_of(&self, key: &str) -> usize {
+        let hash = unsafe { fdb_calc_crc32(0, key.as_ptr() as *const _, key.len()) };
+        hash as usize % self.shards.len()
+    }
+
+    /// 获取一个分片，可以直接对其调用 [`SharedKVDB`] 的方法。
+    pub fn shard(&self, index: usize) -> &SharedKVDB<S> {
+        &self.shards[index]
+    }
+
+    fn route(&self, key: &str) -> &SharedKVDB<S> {
+        &self.shards[self.shard_of(key)]
+    }
+
+    /// 根据键获取其值，参见 [`KVDB::get`]。
+    pub fn get(&self, key: &str) -> Result<Option<Vec<u8>>, Error> {
+        self.route(key).get(key)
+    }
+
+    /// 根据键获取其值并读入缓冲区，参见 [`KVDB::get_into`]。
+    pub fn get_into(&self, key: &str, buf: &mut [u8]) -> Result<usize, Error> {
+        self.route(key).get_into(key, buf)
+    }
+
+    /// 设置键值对，参见 [`KVDB::set`]。
+    pub fn set(&self, key: &str, value: &[u8]) -> Result<(), Error> {
+        self.route(key).set(key, value)
+    }
+
+    /// 删除键值对，参见 [`KVDB::delete`]。
+    pub fn delete(&self, key: &str) -> Result<(), Error> {
+        self.route(key).delete(key)
+    }
+
+    /// 列出所有分片中的 KV。
+    ///
+    /// 每个分片在加锁期间完成遍历，遍历完立即解锁，其他分片在此期间仍可正常写入。
+    pub fn iter(&self) -> std::vec::IntoIter<KVEntry> {
+        let mut entries = Vec::new();
+        for shard in &self.shards {
+            entries.extend(shard.lock().iter());
+        }
+        entries.into_iter()
+    }
+
+    /// 列出所有分片中以 `prefix` 开头的键，结果按键排序，参见 [`KVDB::scan_prefix`]。
+    pub fn scan_prefix(&self, prefix: &str) -> Result<Vec<KVEntry>, Error> {
+        let mut entries = Vec::new();
+        for shard in &self.shards {
+            entries.extend(shard.lock().scan_prefix(prefix)?);
+        }
+        entries.sort_unstable_by(|a, b| a.name_bytes().cmp(b.name_bytes()));
+        Ok(entries)
+    }
+}
+
+impl<S: NorFlash + Send> ShardedKVDB<S> {
+    /// 在每个分片上各用一个线程执行一步增量 GC，参见 [`KVDB::gc_step`]。
+    ///
+    /// # 返回
+    /// - `Ok(true)`: 至少一个分片仍有待回收的工作。
+    pub fn gc_step(&self, budget: usize) -> Result<bool, Error> {
+        std::thread::scope(|scope| {
+            let workers: Vec<_> = self
+                .shards
+                .iter()
+                .map(|shard| scope.spawn(move || shard.gc_step(budget)))
+                .collect();
+            let mut pending = false;
+            for worker in workers {
+                pending |= worker.join().unwrap_or(Err(Error::UnknownError))?;
+            }
+            Ok(pending)
+        })
+    }
+}
+
+impl ShardedKVDB<crate::storage::StdStorage> {
+    /// 在 `path` 下为每个分片创建独立的目录 `{name}-{序号}`，并在多个线程中并行加载各个分片。
+    ///
+    /// 分片数量保存在 `path` 下的 `{name}.shards` 文件中，重新打开时会检查分片数量是否一致。
+    ///
+    /// # 参数
+    /// - `name`: 数据库名称
+    /// - `path`: 数据库所在的目录
+    /// - `shards`: 分片数量，打开已有的数据库时必须与创建时相同
+    /// - `sec_size`: 扇区大小
+    /// - `max_size`: 每个分片的最大容量
+    ///
+    /// # 返回
+    /// - `Err(Error::InvalidArgument)`: `shards` 为 0，或与已有数据库的分片数量不同。
+    pub fn new_file(name: &str, path: &str, shards: usize, sec_size: u32, max_size: u32) -> Result<Self, Error> {
+        if shards == 0 {
+            return Err(Error::InvalidArgument);
+        }
+        // 分片数量决定了键的路由，与创建时不同会把已有的键路由到错误的分片
+        let meta = std::path::Path::new(path).join(format!("{}.shards", name));
+        match std::fs::read_to_string(&meta) {
+            Ok(saved) => {
+                if saved.trim().parse::<usize>() != Ok(shards) {
+                    return Err(Error::InvalidArgument);
+                }
+            }
+            Err(err) if err.kind() == std::io::ErrorKind::NotFound => {
+                std::fs::create_dir_all(path)?;
+                std::fs::write(&meta, shards.to_string())?;
+            }
+            Err(err) => return Err(err.into()),
+        }
+        // 分片独立完成掉电恢复和 GC，互不等待
+        let opened: Vec<Result<SharedKVDB<_>, Error>> = std::thread::scope(|scope| {
+            let workers: Vec<_> = (0..shards)
+                .map(|i| {
+                    scope.spawn(move || {
+                        let dir = std::path::Path::new(path).join(format!("{}-{}", name, i));
+                        std::fs::create_dir_all(&dir)?;
+                        let dir = dir.to_str().ok_or(Error::InvalidArgument)?;
+                        Ok(SharedKVDB::new(KVDB::new_file(name, dir, sec_size, max_size, None)?))
+                    })
+                })
+                .collect();
+            workers
+                .into_iter()
+                .map(|worker| worker.join().unwrap_or(Err(Error::InitFailed)))
+                .collect()
+        });
+        Ok(Self {
+            shards: opened.into_iter().collect::<Result<_, _>>()?,
+        })
+    }
+}
@@ -0,0 +1,101 @@
+use super::KVDB;
+use crate::sync::{db_lock_hook, db_unlock_hook, DbGuard, DbLock};
+use crate::{fdb_db_t, fdb_kvdb_control, Error, RawHandle, FDB_KVDB_CTRL_SET_LOCK, FDB_KVDB_CTRL_SET_UNLOCK};
+use core::cell::UnsafeCell;
+use core::ffi::c_void;
+use embedded_storage::nor_flash::NorFlash;
+
+/// 可以在线程间共享的 KVDB（`std` 特性）。
+///
+/// 创建时会通过 `FDB_KVDB_CTRL_SET_LOCK`/`FDB_KVDB_CTRL_SET_UNLOCK` 为 C 库安装锁钩子，
+/// 所有方法都只需要 `&self`，写入、删除以及写入时触发的 GC 都在锁内完成。
+///
+/// FlashDB 的读取路径同样会更新 KV 缓存和扇区缓存，存储后端的读取也需要 `&mut`，
+/// 因此经过此类型的读取与写入同样互斥。需要真正并行读取时，使用 [`SharedKVDB::reader`]
+/// 为每个读取线程创建独立的只读句柄，它们只共享内存索引，完全不经过此锁。
+pub struct SharedKVDB<S: NorFlash> {
+    // db 必须先于 lock 释放：deinit 期间 C 库仍可能调用锁钩子
+    db: UnsafeCell<Box<KVDB<S>>>,
+    lock: Box<DbLock>,
+}
+
+unsafe impl<S: NorFlash + Send> Send for SharedKVDB<S> {}
+unsafe impl<S: NorFlash + Send> Sync for SharedKVDB<S> {}
+
+impl<S: NorFlash> SharedKVDB<S> {
+    /// 将一个 KVDB 实例转换为可共享的实例。
+    ///
+    /// 数据库是否已经初始化均可，未初始化时可以通过 [`SharedKVDB::lock`] 完成初始化。
+    pub fn new(mut db: Box<KVDB<S>>) -> Self {
+        let lock = Box::new(DbLock::default());
+        db.user_data.lock = &*lock as *const DbLock as *const c_void;
+        unsafe {
+            // 钩子通过 user_data 找到锁，初始化之前也要能找到，否则加锁与解锁无法配对
+            (*(db.handle() as fdb_db_t)).user_data = &mut db.user_data as *mut _ as *mut c_void;
+            // C 库直接把参数当作函数指针使用
+            fdb_kvdb_control(db.handle(), FDB_KVDB_CTRL_SET_LOCK as i32, db_lock_hook as *mut c_void);
+            fdb_kvdb_control(db.handle(), FDB_KVDB_CTRL_SET_UNLOCK as i32, db_unlock_hook as *mut c_void);
+        }
+        Self {
+            db: UnsafeCell::new(db),
+            lock,
+        }
+    }
+
+    /// 获取数据库的独占访问权，可以调用 [`KVDB`] 的任意方法。
+    ///
+    /// **注意**: 同一线程在持有守卫期间再次调用 `lock`（包括此类型的其他方法）会 panic。
+    pub fn lock(&self) -> DbGuard<'_, KVDB<S>> {
+        self.lock.guard(unsafe { &mut **self.db.get() as *mut KVDB<S> })
+    }
+
+    /// 根据键获取其值，参见 [`KVDB::get`]。
+    pub fn get(&self, key: &str) -> Result<Option<Vec<u8>>, Error> {
+        self.lock().get(key)
+    }
+
+    /// 根据键获取其值并读入缓冲区，参见 [`KVDB::get_into`]。
+    pub fn get_into(&self, key: &str, buf: &mut [u8]) -> Result<usize, Error> {
+        self.lock().get_into(key, buf)
+    }
+
+    /// 设置键值对，参见 [`KVDB::set`]。
+    pub fn set(&self, key: &str, value: &[u8]) -> Result<(), Error> {
+        self.lock().set(key, value)
+    }
+
+    /// 原子地写入一批键值对，参见 [`KVDB::write_batch`]。
+    pub fn write_batch(&self, items: &[(&str, &[u8])]) -> Result<(), Error> {
+        self.lock().write_batch(items)
+    }
+
+    /// 删除键值对，参见 [`KVDB::delete`]。
+    pub fn delete(&self, key: &str) -> Result<(), Error> {
+        self.lock().delete(key)
+    }
+
+    /// 执行一步增量 GC，参见 [`KVDB::gc_step`]。
+    pub fn gc_step(&self, budget: usize) -> Result<bool, Error> {
+        self.lock().gc_step(budget)
+    }
+
+    /// 创建一个可以在其他线程中并行读取的只读句柄（`kv_index` 特性），参见 [`KVDB::reader`]。
+    #[cfg(feature = "kv_index")]
+    pub fn reader<R>(&self, storage: R) -> Result<super::KVDBReader<R>, Error>
+    where
+        R: embedded_storage::nor_flash::ReadNorFlash + Send,
+    {
+        self.lock().reader(storage)
+    }
+
+    /// 卸载锁钩子并取回 KVDB 实例。
+    pub fn into_inner(self) -> Box<KVDB<S>> {
+        let mut db = self.db.into_inner();
+        unsafe {
+            fdb_kvdb_control(db.handle(), FDB_KVDB_CTRL_SET_LOCK as i32, core::ptr::null_mut());
+            fdb_kvdb_control(db.handle(), FDB_KVDB_CTRL_SET_UNLOCK as i32, core::ptr::null_mut());
+        }
+        db.user_data.lock = core::ptr::null();
+        db
+    }
+}
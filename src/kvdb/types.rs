@@ -1,5 +1,5 @@
 use crate::{
-    fdb_kv, fdb_kv_status, fdb_kv_status_FDB_KV_DELETED, fdb_kv_status_FDB_KV_ERR_HDR, fdb_kv_status_FDB_KV_PRE_DELETE, fdb_kv_status_FDB_KV_PRE_WRITE, fdb_kv_status_FDB_KV_UNUSED, fdb_kv_status_FDB_KV_WRITE, fdb_kv_t, RawHandle
+    fdb_kv, fdb_kv_gc_policy, fdb_kv_gc_policy_FDB_KV_GC_COST_BENEFIT, fdb_kv_gc_policy_FDB_KV_GC_GREEDY, fdb_kv_gc_policy_FDB_KV_GC_SEQUENTIAL, fdb_kv_gc_pressure, fdb_kv_status, fdb_kv_status_FDB_KV_DELETED, fdb_kv_status_FDB_KV_ERR_HDR, fdb_kv_status_FDB_KV_PRE_DELETE, fdb_kv_status_FDB_KV_PRE_WRITE, fdb_kv_status_FDB_KV_UNUSED, fdb_kv_status_FDB_KV_WRITE, fdb_kv_t, RawHandle
 };
 
 /// 键值对状态枚举
@@ -31,6 +31,31 @@ impl From<fdb_kv_status> for KVStatus {
     }
 }
 
+/// GC 回收策略
+///
+/// 决定垃圾回收时优先回收哪一个脏扇区
+#[repr(u32)]
+#[derive(Debug, PartialEq, Eq, Clone, Copy, Default)]
+pub enum GcPolicy {
+    /// 从最旧的扇区开始按地址顺序回收所有脏扇区（默认，与 FlashDB 原有行为一致）
+    #[default]
+    Sequential = fdb_kv_gc_policy_FDB_KV_GC_SEQUENTIAL,
+    /// 贪心策略：优先回收有效数据最少的扇区，搬移的数据量最小
+    Greedy = fdb_kv_gc_policy_FDB_KV_GC_GREEDY,
+    /// 成本收益策略：综合考虑可回收空间与扇区年龄，冷数据扇区不会被反复搬移
+    CostBenefit = fdb_kv_gc_policy_FDB_KV_GC_COST_BENEFIT,
+}
+impl From<fdb_kv_gc_policy> for GcPolicy {
+    /// 从底层C类型转换为Rust枚举类型，未知的值视为默认策略
+    fn from(value: fdb_kv_gc_policy) -> Self {
+        match value {
+            fdb_kv_gc_policy_FDB_KV_GC_GREEDY => GcPolicy::Greedy,
+            fdb_kv_gc_policy_FDB_KV_GC_COST_BENEFIT => GcPolicy::CostBenefit,
+            _ => GcPolicy::Sequential,
+        }
+    }
+}
+
 #[derive(Debug, Clone, Default)]
 pub struct KVEntry {
     pub(super) inner: fdb_kv,
@@ -62,10 +87,25 @@ impl KVEntry {
         .ok()
     }
 
+    /// 获取 KV 名称的原始字节。
+    pub fn name_bytes(&self) -> &[u8] {
+        let name_slice = &self.inner.name[..self.inner.name_len as usize];
+        unsafe { core::slice::from_raw_parts(name_slice.as_ptr() as *const u8, name_slice.len()) }
+    }
+
     /// 检查内部的 CRC 校验是否通过。
     pub fn is_valid(&self) -> bool {
         self.inner.crc_is_ok
     }
+
+    /// 值是否以压缩形式保存（`kv_compress` 特性）。
+    ///
+    /// 压缩的值由 [`KVDB::get`](super::KVDB::get) 等读取方法透明解压，
+    /// 此时 [`KVEntry::value_len`] 是压缩后在 Flash 上占用的长度。
+    #[cfg(feature = "kv_compress")]
+    pub fn is_compressed(&self) -> bool {
+        self.inner.flags & crate::FDB_KV_FLAG_COMPRESSED as u8 != 0
+    }
 }
 
 impl RawHandle for KVEntry {
@@ -80,3 +120,36 @@ impl From<fdb_kv> for KVEntry {
         Self { inner: value }
     }
 }
+
+/// KVDB 的 GC 压力
+///
+/// 由 [`KVDB::gc_pressure`](super::KVDB::gc_pressure) 返回，用于判断 GC 是否跟不上写入速度
+#[derive(Debug, PartialEq, Eq, Clone, Copy, Default)]
+pub struct GcPressure {
+    /// 空扇区数量
+    pub empty_sectors: usize,
+    /// 含有垃圾数据的脏扇区数量
+    pub dirty_sectors: usize,
+    /// 增量 GC 的空扇区阈值，空扇区多于该值前 [`KVDB::gc_step`](super::KVDB::gc_step) 会持续回收
+    pub threshold: usize,
+    /// 是否有扇区正在被增量 GC 回收
+    pub in_progress: bool,
+}
+
+impl GcPressure {
+    /// GC 是否已经落后：空扇区不多于阈值且仍有脏扇区待回收
+    pub fn is_behind(&self) -> bool {
+        self.empty_sectors <= self.threshold && self.dirty_sectors > 0
+    }
+}
+
+impl From<fdb_kv_gc_pressure> for GcPressure {
+    fn from(value: fdb_kv_gc_pressure) -> Self {
+        Self {
+            empty_sectors: value.empty_sec,
+            dirty_sectors: value.dirty_sec,
+            threshold: value.threshold,
+            in_progress: value.in_progress,
+        }
+    }
+}
@@ -0,0 +1,104 @@
+use crate::{
+    fdb_kv_write_abort, fdb_kv_write_begin, fdb_kv_write_data, fdb_kv_write_finish, fdb_kv_writer, Error,
+    RawHandle,
+};
+use core::ffi::c_void;
+use embedded_storage::nor_flash::NorFlash;
+
+use super::KVDB;
+
+/// KV值写入器
+///
+/// 实现了embedded-io的Write trait，是 [`KVReader`](super::KVReader) 的对应类型，
+/// 用于流式写入大型的值：数据分块直接写入 Flash，CRC32 随写入增量计算，
+/// 因此内存占用与值的大小无关。
+///
+/// 创建时即按值的总长度预留空间并写入 KV 头部，之后的写入总量必须恰好等于该长度，
+/// 最后调用 [`KVWriter::finish`] 提交。提交之前旧值保持有效，读取到的仍是旧值；
+/// 未提交就被丢弃（或掉电）时，预留的空间会作为垃圾在 GC 时回收。
+///
+/// 与 [`KVDB::set`] 一样，一个值不能跨扇区保存，其长度受扇区大小限制。
+/// 写入的值总是原样保存，不会被压缩（`kv_compress` 特性）。
+pub struct KVWriter<'a, S: NorFlash> {
+    inner: &'a mut KVDB<S>, // 写入期间独占数据库，不会有其他写入穿插
+    writer: fdb_kv_writer,
+    finished: bool,
+}
+
+impl<S: NorFlash> KVDB<S> {
+    /// 获取一个用于流式写入键值的 `KVWriter`。
+    ///
+    /// # 参数
+    /// - `key`: 键
+    /// - `value_len`: 值的总长度
+    ///
+    /// # 返回
+    /// - `Err(Error::SavedFull)`: 值超过一个扇区或空间不足。
+    pub fn get_writer(&mut self, key: &str, value_len: usize) -> Result<KVWriter<'_, S>, Error> {
+        let handle = self.handle();
+        let cstr_key = self.to_cstr(key)?;
+        let mut writer = fdb_kv_writer::default();
+        Error::convert(unsafe { fdb_kv_write_begin(handle, cstr_key.as_ptr(), value_len, &mut writer) })?;
+        Ok(KVWriter {
+            inner: self,
+            writer,
+            finished: false,
+        })
+    }
+}
+
+impl<'a, S: NorFlash> KVWriter<'a, S> {
+    /// 尚未写入的值长度。
+    pub fn remaining(&self) -> usize {
+        self.writer.value_len - self.writer.written
+    }
+
+    /// 提交写入的值，成功后旧值被删除。
+    ///
+    /// # 返回
+    /// - `Err(Error::InvalidArgument)`: 写入的数据少于创建时指定的长度，写入被放弃。
+    pub fn finish(mut self) -> Result<(), Error> {
+        if self.remaining() != 0 {
+            return Err(Error::InvalidArgument);
+        }
+        self.finished = true;
+        Error::convert(unsafe { fdb_kv_write_finish(self.inner.handle(), &mut self.writer) })
+    }
+}
+
+impl<'a, S: NorFlash> embedded_io::ErrorType for KVWriter<'a, S> {
+    type Error = Error;
+}
+
+impl<'a, S: NorFlash> embedded_io::Write for KVWriter<'a, S> {
+    /// 将缓冲区中的数据写入KV值
+    ///
+    /// # 返回值
+    /// 成功时返回写入的字节数，超出剩余长度的部分不会被写入；
+    /// 已经写满时返回 `Error::InvalidArgument`
+    fn write(&mut self, buf: &[u8]) -> Result<usize, Self::Error> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+        let len = buf.len().min(self.remaining());
+        if len == 0 {
+            return Err(Error::InvalidArgument);
+        }
+        Error::convert(unsafe {
+            fdb_kv_write_data(self.inner.handle(), &mut self.writer, buf.as_ptr() as *const c_void, len)
+        })?;
+        Ok(len)
+    }
+
+    fn flush(&mut self) -> Result<(), Self::Error> {
+        Ok(())
+    }
+}
+
+impl<'a, S: NorFlash> Drop for KVWriter<'a, S> {
+    fn drop(&mut self) {
+        if !self.finished {
+            unsafe { fdb_kv_write_abort(self.inner.handle(), &mut self.writer) };
+        }
+    }
+}
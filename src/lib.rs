@@ -9,24 +9,40 @@
 #[cfg(feature = "alloc")]
 extern crate alloc;
 
+pub mod cache;
 pub mod error;
 pub mod kvdb;
+#[cfg(feature = "alloc")]
+pub mod sim;
+#[cfg(feature = "stats")]
+pub mod stats;
 // pub mod time;
 pub mod tsdb;
 pub mod utils;
 
 use core::ffi::c_void;
 
-use embedded_storage::nor_flash::NorFlash;
+use embedded_storage::nor_flash::{NorFlash, ReadNorFlash};
 
 #[cfg(feature = "std")]
 pub mod storage;
 #[cfg(feature = "std")]
-pub use storage::StdStorage;
+mod sync;
+#[cfg(feature = "std")]
+pub use storage::{Durability, StdStorage};
+#[cfg(feature = "std")]
+pub use sync::DbGuard;
+#[cfg(feature = "mmap")]
+pub use storage::MmapStorage;
 
+pub use cache::CachedFlash;
 pub use error::*;
 
 pub use kvdb::*;
+#[cfg(feature = "alloc")]
+pub use sim::{SimCounters, SimFlash, SimTiming};
+#[cfg(feature = "stats")]
+pub use stats::{FlashStats, KvStats};
 pub use tsdb::*;
 pub use utils::*;
 
@@ -102,8 +118,13 @@ pub extern "C" fn rust_log(message: *const core::ffi::c_char) {
 pub struct FlashVTable {
     pub read:
         unsafe extern "C" fn(storage: *mut c_void, addr: u32, buf: *mut u8, size: usize) -> i32,
-    pub write:
-        unsafe extern "C" fn(storage: *mut c_void, addr: u32, buf: *const u8, size: usize) -> i32,
+    pub write: unsafe extern "C" fn(
+        storage: *mut c_void,
+        addr: u32,
+        buf: *const u8,
+        size: usize,
+        sync: bool,
+    ) -> i32,
     pub erase: unsafe extern "C" fn(storage: *mut c_void, addr: u32, size: usize) -> i32,
 }
 
@@ -113,6 +134,16 @@ pub struct FlashVTable {
 pub struct FlashDispatch {
     pub vtable: FlashVTable,
     pub instance: *mut c_void,
+    /// 是否发生过写入或擦除失败，此时 Flash 上可能残留需要恢复检查的数据
+    pub failed: core::cell::Cell<bool>,
+    /// C 库的 `db_lock`/`db_unlock` 钩子使用的锁，为空时不加锁
+    pub lock: *const c_void,
+    /// 迭代期间使用的预读窗口，为空时所有读取都直接访问存储后端
+    #[cfg(feature = "alloc")]
+    pub(crate) prefetch: *mut PrefetchWindow,
+    /// 存储后端的访问统计
+    #[cfg(feature = "stats")]
+    pub(crate) stats: core::cell::RefCell<stats::FlashStats>,
 }
 
 impl FlashDispatch {
@@ -124,12 +155,135 @@ impl FlashDispatch {
                 erase: vtable_erase::<T>,
             },
             instance: core::ptr::null_mut(),
+            failed: core::cell::Cell::new(false),
+            lock: core::ptr::null(),
+            #[cfg(feature = "alloc")]
+            prefetch: core::ptr::null_mut(),
+            #[cfg(feature = "stats")]
+            stats: Default::default(),
+        };
+    }
+
+    /// 与 [`FlashDispatch::new`] 相同，但会把 C 库的 `sync` 提示传递给 [`SyncNorFlash::write_sync`]。
+    pub fn with_sync<T: SyncNorFlash>() -> Self {
+        let mut dispatch = Self::new::<T>();
+        dispatch.vtable.write = vtable_write_sync::<T>;
+        dispatch
+    }
+
+    /// 只读的分发表，写入和擦除总是失败。
+    pub fn read_only<T: ReadNorFlash>() -> Self {
+        return Self {
+            vtable: FlashVTable {
+                read: vtable_read::<T>,
+                write: vtable_write_denied,
+                erase: vtable_erase_denied,
+            },
+            instance: core::ptr::null_mut(),
+            failed: core::cell::Cell::new(false),
+            lock: core::ptr::null(),
+            #[cfg(feature = "alloc")]
+            prefetch: core::ptr::null_mut(),
+            #[cfg(feature = "stats")]
+            stats: Default::default(),
         };
     }
 }
 
+impl FlashDispatch {
+    /// 通过分发表读取存储后端，所有实际发送给后端的读取都经过这里
+    unsafe fn read_raw(&self, addr: u32, buf: *mut u8, size: usize) -> i32 {
+        #[cfg(feature = "stats")]
+        self.stats.borrow_mut().record_read(size);
+        (self.vtable.read)(self.instance, addr, buf, size)
+    }
+}
+
+/// 预读窗口：从扇区边界开始整块读取连续的若干个扇区，之后落在窗口内的读取直接从内存返回。
+///
+/// C 库遍历 KV 时会对每个 KV 发起多次细碎的读取（头部、名称、值），跨扇区时还要重新读取扇区头部。
+/// 窗口包含多个扇区时，下一个扇区会随当前扇区一起读入，切换扇区时不需要再访问存储后端。
+/// 写入和擦除会清空窗口，因此读到的数据总是与底层存储一致。
+#[cfg(feature = "alloc")]
+pub(crate) struct PrefetchWindow {
+    buf: alloc::vec::Vec<u8>,
+    start: u32,
+    // 窗口内有效数据的长度，0 表示窗口为空
+    len: usize,
+}
+
+#[cfg(feature = "alloc")]
+impl PrefetchWindow {
+    pub(crate) fn new(size: usize) -> Self {
+        Self {
+            buf: alloc::vec![0; size],
+            start: 0,
+            len: 0,
+        }
+    }
+
+    fn invalidate(&mut self) {
+        self.len = 0;
+    }
+
+    fn contains(&self, addr: u32, size: usize) -> bool {
+        addr >= self.start && (addr - self.start) as usize + size <= self.len
+    }
+
+    /// 通过窗口读取数据，无法由窗口满足时（读取跨出窗口或预读失败）返回 `false`，由调用者直接读取
+    unsafe fn read(&mut self, db: fdb_db_t, dispatch: &FlashDispatch, addr: u32, buf: *mut u8, size: usize) -> bool {
+        if !self.contains(addr, size) {
+            let (sec_size, max_size) = ((*db).sec_size, (*db).max_size);
+            if sec_size == 0 || addr >= max_size {
+                return false;
+            }
+            self.start = addr - addr % sec_size;
+            self.len = self.buf.len().min((max_size - self.start) as usize);
+            // 逐个扇区读取：C 库从不跨扇区读取，部分存储后端（如按扇区分文件的 StdStorage）也不支持
+            for offset in (0..self.len).step_by(sec_size as usize) {
+                let size = (sec_size as usize).min(self.len - offset);
+                let sec_buf = self.buf.as_mut_ptr().add(offset);
+                if dispatch.read_raw(self.start + offset as u32, sec_buf, size) != 0 {
+                    self.invalidate();
+                    return false;
+                }
+            }
+            if !self.contains(addr, size) {
+                return false;
+            }
+        }
+        let offset = (addr - self.start) as usize;
+        core::ptr::copy_nonoverlapping(self.buf.as_ptr().add(offset), buf, size);
+        true
+    }
+}
+
+/// 能够区分“普通写入”与“需要同步的写入”的存储后端。
+///
+/// C 库在写入扇区头部、状态位等决定掉电恢复结果的位置时会要求同步（`sync = true`），
+/// 其余写入（例如 KV 头部、GC 搬运的数据）不要求立即落盘。实现此 trait 的存储可以据此
+/// 只在必要时执行 `fsync` 等开销较大的操作。未实现此 trait 的存储会忽略该提示。
+pub trait SyncNorFlash: NorFlash {
+    /// 写入数据，`sync` 为 `true` 表示该写入需要按存储的持久化策略同步到介质。
+    fn write_sync(&mut self, offset: u32, bytes: &[u8], sync: bool) -> Result<(), Self::Error>;
+
+    /// 将此前所有尚未持久化的写入同步到介质。
+    fn sync(&mut self) -> Result<(), Self::Error>;
+}
+
+/// 能够直接暴露连续内存的存储后端，例如内存映射文件或 RAM。
+///
+/// 实现此 trait 的存储可以通过 `KVDB::with_value` / `KVDB::value_slice` 零拷贝地访问 KV 的值，
+/// 不需要分配缓冲区，也不需要经过 C 库的读取回调。
+pub trait DirectRead: NorFlash {
+    /// 返回 `[offset, offset + len)` 区间的只读切片。
+    ///
+    /// 区间越界、不连续或暂时无法直接访问时返回 `None`，调用者会退回到普通读取。
+    fn direct(&self, offset: u32, len: usize) -> Option<&[u8]>;
+}
+
 // --- VTable 的具体实现函数  ---
-unsafe extern "C" fn vtable_read<F: NorFlash>(
+unsafe extern "C" fn vtable_read<F: ReadNorFlash>(
     storage: *mut c_void,
     addr: u32,
     buf: *mut u8,
@@ -148,6 +302,7 @@ unsafe extern "C" fn vtable_write<F: NorFlash>(
     addr: u32,
     buf: *const u8,
     size: usize,
+    _sync: bool,
 ) -> i32 {
     let flash = &mut *(storage as *mut F);
     let slice = core::slice::from_raw_parts(buf, size);
@@ -157,6 +312,21 @@ unsafe extern "C" fn vtable_write<F: NorFlash>(
     }
 }
 
+unsafe extern "C" fn vtable_write_sync<F: SyncNorFlash>(
+    storage: *mut c_void,
+    addr: u32,
+    buf: *const u8,
+    size: usize,
+    sync: bool,
+) -> i32 {
+    let flash = &mut *(storage as *mut F);
+    let slice = core::slice::from_raw_parts(buf, size);
+    match flash.write_sync(addr, slice, sync) {
+        Ok(_) => 0,
+        Err(_) => -1,
+    }
+}
+
 unsafe extern "C" fn vtable_erase<F: NorFlash>(
     storage: *mut c_void,
     addr: u32,
@@ -169,6 +339,20 @@ unsafe extern "C" fn vtable_erase<F: NorFlash>(
     }
 }
 
+unsafe extern "C" fn vtable_write_denied(
+    _storage: *mut c_void,
+    _addr: u32,
+    _buf: *const u8,
+    _size: usize,
+    _sync: bool,
+) -> i32 {
+    -1
+}
+
+unsafe extern "C" fn vtable_erase_denied(_storage: *mut c_void, _addr: u32, _size: usize) -> i32 {
+    -1
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn fdb_custom_read(
     db: fdb_db_t,
@@ -177,7 +361,13 @@ pub unsafe extern "C" fn fdb_custom_read(
     size: usize,
 ) -> fdb_err_t {
     let dispatch = &*((*db).user_data as *const FlashDispatch);
-    let result = (dispatch.vtable.read)(dispatch.instance, addr, buf as *mut u8, size);
+    #[cfg(feature = "alloc")]
+    if let Some(window) = dispatch.prefetch.as_mut() {
+        if window.read(db, dispatch, addr, buf as *mut u8, size) {
+            return crate::fdb_err_t_FDB_NO_ERR;
+        }
+    }
+    let result = dispatch.read_raw(addr, buf as *mut u8, size);
     if result == 0 {
         crate::fdb_err_t_FDB_NO_ERR
     } else {
@@ -191,13 +381,20 @@ pub unsafe extern "C" fn fdb_custom_write(
     addr: u32,
     buf: *const c_void,
     size: usize,
-    _sync: bool,
+    sync: bool,
 ) -> fdb_err_t {
     let dispatch = &*((*db).user_data as *const FlashDispatch);
-    let result = (dispatch.vtable.write)(dispatch.instance, addr, buf as *const u8, size);
+    #[cfg(feature = "alloc")]
+    if let Some(window) = dispatch.prefetch.as_mut() {
+        window.invalidate();
+    }
+    #[cfg(feature = "stats")]
+    dispatch.stats.borrow_mut().record_write(size, sync);
+    let result = (dispatch.vtable.write)(dispatch.instance, addr, buf as *const u8, size, sync);
     if result == 0 {
         crate::fdb_err_t_FDB_NO_ERR
     } else {
+        dispatch.failed.set(true);
         crate::fdb_err_t_FDB_WRITE_ERR
     }
 }
@@ -205,10 +402,27 @@ pub unsafe extern "C" fn fdb_custom_write(
 #[no_mangle]
 pub unsafe extern "C" fn fdb_custom_erase(db: fdb_db_t, addr: u32, size: usize) -> fdb_err_t {
     let dispatch = &*((*db).user_data as *const FlashDispatch);
+    #[cfg(feature = "alloc")]
+    if let Some(window) = dispatch.prefetch.as_mut() {
+        window.invalidate();
+    }
+    #[cfg(feature = "stats")]
+    {
+        let mut stats = dispatch.stats.borrow_mut();
+        stats.record_erase(addr, size, (*db).sec_size, (*db).max_size);
+        #[cfg(feature = "log")]
+        log::trace!(
+            "erase 0x{:08X} ({} bytes), sector erase count {}",
+            addr,
+            size,
+            stats.sector_erases.get((addr / (*db).sec_size.max(1)) as usize).copied().unwrap_or(0)
+        );
+    }
     let result = (dispatch.vtable.erase)(dispatch.instance, addr, size);
     if result == 0 {
         crate::fdb_err_t_FDB_NO_ERR
     } else {
+        dispatch.failed.set(true);
         crate::fdb_err_t_FDB_ERASE_ERR
     }
 }
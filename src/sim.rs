@@ -0,0 +1,308 @@
+use core::time::Duration;
+
+use alloc::vec;
+use alloc::vec::Vec;
+
+use crate::error::Error;
+use crate::SyncNorFlash;
+use embedded_storage::nor_flash::{ErrorType, NorFlash, ReadNorFlash};
+
+/// [`SimFlash`] 的时序模型。
+///
+/// 每次访问的耗时为固定延迟加上按吞吐量折算的传输时间，吞吐量为 0 表示传输不耗时。
+/// 编程按页计算延迟：写入涉及的每一页都要付出一次 `program_latency`，与 SPI-NOR 的页编程一致。
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SimTiming {
+    /// 每次读取的固定延迟（指令、地址等开销）
+    pub read_latency: Duration,
+    /// 读取吞吐量，单位为字节每秒
+    pub read_throughput: u64,
+    /// 每页的编程延迟
+    pub program_latency: Duration,
+    /// 编程吞吐量，单位为字节每秒
+    pub program_throughput: u64,
+    /// 编程页大小，为 0 时每次写入只计一次 `program_latency`
+    pub program_page: usize,
+    /// 擦除一个 `ERASE_SIZE` 块的延迟
+    pub erase_latency: Duration,
+}
+
+impl SimTiming {
+    /// 不耗时的理想存储，只统计访问次数。
+    pub const IDEAL: Self = Self {
+        read_latency: Duration::ZERO,
+        read_throughput: 0,
+        program_latency: Duration::ZERO,
+        program_throughput: 0,
+        program_page: 0,
+        erase_latency: Duration::ZERO,
+    };
+
+    /// 典型 SPI-NOR（W25Q 系列，单线 SPI 约 10MB/s）的数据手册典型值：
+    /// 256 字节页编程约 0.7ms，4KB 扇区擦除约 45ms。
+    pub const SPI_NOR: Self = Self {
+        read_latency: Duration::from_micros(1),
+        read_throughput: 10_000_000,
+        program_latency: Duration::from_micros(700),
+        program_throughput: 0,
+        program_page: 256,
+        erase_latency: Duration::from_millis(45),
+    };
+
+    fn transfer(bytes: usize, throughput: u64) -> Duration {
+        if throughput == 0 {
+            return Duration::ZERO;
+        }
+        Duration::from_nanos((bytes as u128 * 1_000_000_000 / throughput as u128) as u64)
+    }
+
+    fn read(&self, bytes: usize) -> Duration {
+        self.read_latency + Self::transfer(bytes, self.read_throughput)
+    }
+
+    fn program(&self, offset: u32, bytes: usize) -> Duration {
+        let pages = match self.program_page {
+            0 => 1,
+            page => {
+                let first = offset as usize / page;
+                let last = (offset as usize + bytes.max(1) - 1) / page;
+                last - first + 1
+            }
+        };
+        self.program_latency * pages as u32 + Self::transfer(bytes, self.program_throughput)
+    }
+}
+
+impl Default for SimTiming {
+    fn default() -> Self {
+        Self::IDEAL
+    }
+}
+
+/// [`SimFlash`] 的访问计数和按时序模型累计的耗时
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct SimCounters {
+    /// 读取次数
+    pub reads: u64,
+    /// 读取的字节数
+    pub read_bytes: u64,
+    /// 写入次数
+    pub programs: u64,
+    /// 写入的字节数
+    pub program_bytes: u64,
+    /// 要求同步的写入次数
+    pub sync_programs: u64,
+    /// 擦除的块数
+    pub erases: u64,
+    /// 读取累计耗时
+    pub read_time: Duration,
+    /// 写入累计耗时
+    pub program_time: Duration,
+    /// 擦除累计耗时
+    pub erase_time: Duration,
+}
+
+impl SimCounters {
+    /// 所有访问的累计耗时，即存储处于忙状态的总时间。
+    pub fn busy_time(&self) -> Duration {
+        self.read_time + self.program_time + self.erase_time
+    }
+}
+
+/// 基于内存的模拟 NOR Flash。
+///
+/// 严格按照 NOR Flash 的语义工作：擦除后所有位为 1，写入只能把位从 1 变为 0，
+/// 需要把 0 变回 1 的写入会返回 [`Error::WriteError`]；擦除必须以 `ERASE` 字节对齐，
+/// 写入必须以 `WRITE` 字节对齐。因此它既可以在主机上代替真实 Flash 运行数据库，
+/// 也能发现依赖文件存储“可覆盖写入”特性的错误。
+///
+/// 每次访问按 [`SimTiming`] 计算耗时并累计到 [`SimCounters`]，同时记录每个块的擦除次数，
+/// 可用于在 CI 上预测设备上的写入延迟和磨损，结果与主机性能无关，可以复现。
+/// 启用 `std` 特性时，还可以通过 [`SimFlash::set_realtime`] 让每次访问真实地休眠相应时间。
+///
+/// # 示例
+///
+/// ```ignore
+/// let flash = SimFlash::<4096>::with_timing(64 * 4096, SimTiming::SPI_NOR);
+/// let mut db = Box::new(KVDB::new(flash));
+/// db.init(None)?;
+/// ```
+pub struct SimFlash<const ERASE: usize = 4096, const WRITE: usize = 1> {
+    data: Vec<u8>,
+    timing: SimTiming,
+    counters: SimCounters,
+    erase_counts: Vec<u32>,
+    last_op: Duration,
+    #[cfg(feature = "std")]
+    realtime: bool,
+}
+
+impl<const ERASE: usize, const WRITE: usize> SimFlash<ERASE, WRITE> {
+    /// 创建一个已擦除、不耗时的模拟 Flash。
+    ///
+    /// `capacity` 必须是 `ERASE` 的整数倍，`ERASE` 必须是 `WRITE` 的整数倍。
+    pub fn new(capacity: usize) -> Self {
+        Self::with_timing(capacity, SimTiming::IDEAL)
+    }
+
+    /// 创建一个使用指定时序模型的已擦除模拟 Flash。
+    pub fn with_timing(capacity: usize, timing: SimTiming) -> Self {
+        assert!(WRITE > 0 && ERASE % WRITE == 0, "erase size MUST be a multiple of write size");
+        assert!(capacity % ERASE == 0, "capacity MUST be a multiple of erase size");
+        Self {
+            data: vec![0xFF; capacity],
+            timing,
+            counters: SimCounters::default(),
+            erase_counts: vec![0; capacity / ERASE],
+            last_op: Duration::ZERO,
+            #[cfg(feature = "std")]
+            realtime: false,
+        }
+    }
+
+    /// 获取时序模型。
+    pub fn timing(&self) -> &SimTiming {
+        &self.timing
+    }
+
+    /// 更换时序模型，不影响已累计的计数。
+    pub fn set_timing(&mut self, timing: SimTiming) {
+        self.timing = timing;
+    }
+
+    /// 设置是否按时序模型真实休眠（`std` 特性），默认关闭，只累计模拟耗时。
+    #[cfg(feature = "std")]
+    pub fn set_realtime(&mut self, enable: bool) {
+        self.realtime = enable;
+    }
+
+    /// 获取访问计数。
+    pub fn counters(&self) -> &SimCounters {
+        &self.counters
+    }
+
+    /// 清零访问计数和最近一次访问的耗时，擦除次数不受影响。
+    pub fn reset_counters(&mut self) {
+        self.counters = SimCounters::default();
+        self.last_op = Duration::ZERO;
+    }
+
+    /// 最近一次访问按时序模型计算的耗时。
+    pub fn last_op(&self) -> Duration {
+        self.last_op
+    }
+
+    /// 每个擦除块的累计擦除次数。
+    pub fn erase_counts(&self) -> &[u32] {
+        &self.erase_counts
+    }
+
+    /// 擦除次数最多的块的擦除次数。
+    pub fn max_erase_count(&self) -> u32 {
+        self.erase_counts.iter().copied().max().unwrap_or(0)
+    }
+
+    /// 获取存储的全部内容。
+    pub fn data(&self) -> &[u8] {
+        &self.data
+    }
+
+    fn check(&self, offset: u32, len: usize, align: usize) -> Result<core::ops::Range<usize>, Error> {
+        let start = offset as usize;
+        if start % align != 0 || len % align != 0 {
+            return Err(Error::InvalidArgument);
+        }
+        match start.checked_add(len) {
+            Some(end) if end <= self.data.len() => Ok(start..end),
+            _ => Err(Error::InvalidArgument),
+        }
+    }
+
+    fn elapse(&mut self, cost: Duration) {
+        self.last_op = cost;
+        #[cfg(feature = "std")]
+        if self.realtime && !cost.is_zero() {
+            std::thread::sleep(cost);
+        }
+    }
+
+    fn program(&mut self, offset: u32, bytes: &[u8], sync: bool) -> Result<(), Error> {
+        let range = self.check(offset, bytes.len(), WRITE)?;
+        let dst = &mut self.data[range];
+        // NOR Flash 的编程只能把位从 1 变为 0
+        if dst.iter().zip(bytes).any(|(old, new)| old & new != *new) {
+            return Err(Error::WriteError);
+        }
+        dst.copy_from_slice(bytes);
+
+        let cost = self.timing.program(offset, bytes.len());
+        self.counters.programs += 1;
+        self.counters.program_bytes += bytes.len() as u64;
+        self.counters.sync_programs += sync as u64;
+        self.counters.program_time += cost;
+        self.elapse(cost);
+        Ok(())
+    }
+}
+
+impl<const ERASE: usize, const WRITE: usize> ErrorType for SimFlash<ERASE, WRITE> {
+    type Error = Error;
+}
+
+impl<const ERASE: usize, const WRITE: usize> ReadNorFlash for SimFlash<ERASE, WRITE> {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        let range = self.check(offset, bytes.len(), Self::READ_SIZE)?;
+        bytes.copy_from_slice(&self.data[range]);
+
+        let cost = self.timing.read(bytes.len());
+        self.counters.reads += 1;
+        self.counters.read_bytes += bytes.len() as u64;
+        self.counters.read_time += cost;
+        self.elapse(cost);
+        Ok(())
+    }
+
+    fn capacity(&self) -> usize {
+        self.data.len()
+    }
+}
+
+impl<const ERASE: usize, const WRITE: usize> NorFlash for SimFlash<ERASE, WRITE> {
+    const WRITE_SIZE: usize = WRITE;
+    const ERASE_SIZE: usize = ERASE;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        if to < from {
+            return Err(Error::InvalidArgument);
+        }
+        let range = self.check(from, (to - from) as usize, ERASE)?;
+        let blocks = range.len() / ERASE;
+        for count in &mut self.erase_counts[range.start / ERASE..range.end / ERASE] {
+            *count += 1;
+        }
+        self.data[range].fill(0xFF);
+
+        let cost = self.timing.erase_latency * blocks as u32;
+        self.counters.erases += blocks as u64;
+        self.counters.erase_time += cost;
+        self.elapse(cost);
+        Ok(())
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.program(offset, bytes, false)
+    }
+}
+
+impl<const ERASE: usize, const WRITE: usize> SyncNorFlash for SimFlash<ERASE, WRITE> {
+    fn write_sync(&mut self, offset: u32, bytes: &[u8], sync: bool) -> Result<(), Self::Error> {
+        self.program(offset, bytes, sync)
+    }
+
+    /// 模拟 Flash 的写入总是立即生效，无需同步。
+    fn sync(&mut self) -> Result<(), Self::Error> {
+        Ok(())
+    }
+}
@@ -0,0 +1,158 @@
+//! 运行统计（`stats` 特性）。
+//!
+//! [`FlashStats`] 在 Flash 读写回调层统计实际发送给存储后端的访问，[`KvStats`] 额外包含 C 库在
+//! 写入、查找和 GC 过程中累加的计数器。两者都只是快照，通过 `KVDB::stats` / `TSDB::stats` 获取，
+//! 开销只有每次访问时的几次加法。同时启用 `log` 特性时，每次擦除都会以 `trace` 级别输出日志。
+
+use alloc::vec::Vec;
+use core::fmt;
+
+/// 存储后端的访问统计
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct FlashStats {
+    /// 读取次数
+    pub read_calls: u64,
+    /// 读取的字节数
+    pub read_bytes: u64,
+    /// 写入次数
+    pub write_calls: u64,
+    /// 写入的字节数
+    pub write_bytes: u64,
+    /// C 库要求同步的写入次数，`SyncNorFlash` 后端据此执行 `fsync` 等操作
+    pub sync_writes: u64,
+    /// 擦除次数
+    pub erase_calls: u64,
+    /// 擦除的字节数
+    pub erase_bytes: u64,
+    /// 每个扇区的擦除次数，下标为扇区序号
+    pub sector_erases: Vec<u32>,
+}
+
+impl FlashStats {
+    pub(crate) fn record_read(&mut self, size: usize) {
+        self.read_calls += 1;
+        self.read_bytes += size as u64;
+    }
+
+    pub(crate) fn record_write(&mut self, size: usize, sync: bool) {
+        self.write_calls += 1;
+        self.write_bytes += size as u64;
+        self.sync_writes += sync as u64;
+    }
+
+    pub(crate) fn record_erase(&mut self, addr: u32, size: usize, sec_size: u32, max_size: u32) {
+        self.erase_calls += 1;
+        self.erase_bytes += size as u64;
+        if sec_size == 0 {
+            return;
+        }
+        let first = (addr / sec_size) as usize;
+        let last = first + (size as u32).div_ceil(sec_size).max(1) as usize;
+        // 按数据库的全部扇区计数，从未擦除过的扇区也要计入最小擦除次数
+        let sectors = last.max((max_size / sec_size) as usize);
+        if self.sector_erases.len() < sectors {
+            self.sector_erases.resize(sectors, 0);
+        }
+        for count in &mut self.sector_erases[first..last] {
+            *count += 1;
+        }
+    }
+
+    /// 擦除次数最多的扇区的擦除次数，用于评估磨损均衡。
+    pub fn max_sector_erases(&self) -> u32 {
+        self.sector_erases.iter().copied().max().unwrap_or(0)
+    }
+
+    /// 擦除次数最少的扇区的擦除次数，从未擦除过的扇区计为 0。
+    pub fn min_sector_erases(&self) -> u32 {
+        self.sector_erases.iter().copied().min().unwrap_or(0)
+    }
+}
+
+impl fmt::Display for FlashStats {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(
+            f,
+            "read {}B/{} calls, write {}B/{} calls ({} sync), erase {}B/{} calls (sector max {} min {})",
+            self.read_bytes,
+            self.read_calls,
+            self.write_bytes,
+            self.write_calls,
+            self.sync_writes,
+            self.erase_bytes,
+            self.erase_calls,
+            self.max_sector_erases(),
+            self.min_sector_erases()
+        )
+    }
+}
+
+/// KVDB 的运行统计
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct KvStats {
+    /// 存储后端的访问统计
+    pub flash: FlashStats,
+    /// 写入调用次数，包括批量写入和流式写入
+    pub set_calls: u32,
+    /// 写入调用提交的键和值的字节数
+    pub set_bytes: u64,
+    /// 读取调用次数
+    pub get_calls: u32,
+    /// 删除调用次数
+    pub del_calls: u32,
+    /// 查找 KV 时命中 KV 缓存的次数
+    pub cache_hits: u32,
+    /// 查找 KV 时未命中 KV 缓存、需要遍历 Flash 的次数（启用 `kv_index` 时索引优先，不经过缓存）
+    pub cache_misses: u32,
+    /// 完整 GC 的次数
+    pub gc_runs: u32,
+    /// 完整 GC 和增量 GC 回收的扇区数
+    pub gc_sectors: u32,
+    /// GC 和掉电恢复搬移的 KV 数量
+    pub moved_kvs: u32,
+    /// GC 和掉电恢复搬移的字节数
+    pub moved_bytes: u64,
+}
+
+impl KvStats {
+    pub(crate) fn new(stats: &crate::fdb_kv_stats, flash: FlashStats) -> Self {
+        Self {
+            flash,
+            set_calls: stats.set_calls,
+            set_bytes: stats.set_bytes,
+            get_calls: stats.get_calls,
+            del_calls: stats.del_calls,
+            cache_hits: stats.cache_hits,
+            cache_misses: stats.cache_misses,
+            gc_runs: stats.gc_runs,
+            gc_sectors: stats.gc_sectors,
+            moved_kvs: stats.moved_kvs,
+            moved_bytes: stats.moved_bytes,
+        }
+    }
+
+    /// 写放大系数：写入 Flash 的字节数与写入调用提交的字节数之比，尚未写入时返回 `None`。
+    pub fn write_amplification(&self) -> Option<f64> {
+        (self.set_bytes > 0).then(|| self.flash.write_bytes as f64 / self.set_bytes as f64)
+    }
+}
+
+impl fmt::Display for KvStats {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(
+            f,
+            "set {} ({}B), get {}, del {}, cache hit {} miss {}, gc {} runs {} sectors, moved {} KVs {}B; {}",
+            self.set_calls,
+            self.set_bytes,
+            self.get_calls,
+            self.del_calls,
+            self.cache_hits,
+            self.cache_misses,
+            self.gc_runs,
+            self.gc_sectors,
+            self.moved_kvs,
+            self.moved_bytes,
+            self.flash
+        )
+    }
+}
@@ -0,0 +1,264 @@
+use super::{Durability, FileStrategy, SyncPolicy};
+use crate::error::Error;
+use crate::{DirectRead, SyncNorFlash};
+use embedded_storage::nor_flash::{ErrorType, NorFlash, ReadNorFlash};
+use memmap2::{MmapMut, MmapOptions};
+use std::fs::OpenOptions;
+use std::path::{Path, PathBuf};
+
+/// 一个基于内存映射文件的 `NorFlash` 实现。
+///
+/// 与 [`StdStorage`](super::StdStorage) 每次读写都要发起 `seek` + `read`/`write` 系统调用不同，
+/// `MmapStorage` 将数据库文件（单文件模式）或每个扇区文件（多文件模式）映射到内存中，
+/// 读写都只是一次 `memcpy`，由操作系统的页缓存负责回写。
+///
+/// 写入不会立即落盘，持久化时机由 [`Durability`] 策略或调用者通过 [`MmapStorage::sync`]
+/// 显式控制（底层为 `msync`），实例被丢弃时也会自动同步一次。
+///
+/// 文件布局与 `StdStorage` 完全一致，两者可以打开同一个数据库。
+pub struct MmapStorage {
+    strategy: FileStrategy,
+    db_name: String,
+    base_path: PathBuf,
+    sec_size: u32,
+    capacity: u32,
+    // 单文件模式只有一个映射；多文件模式每个扇区一个映射，首次访问时才建立
+    maps: Vec<Option<MmapMut>>,
+    // 记录自上次同步以来被修改过的扇区
+    dirty: Vec<bool>,
+    policy: SyncPolicy,
+}
+
+impl MmapStorage {
+    /// 创建一个新的 `MmapStorage` 实例。
+    ///
+    /// 参数含义与 [`StdStorage::new`](super::StdStorage::new) 相同。
+    /// 不存在或长度不足的文件会被扩展，并以 `0xFF` 填充新增的部分。
+    pub fn new<P: AsRef<Path>>(
+        path: P,
+        db_name: &str,
+        sec_size: u32,
+        capacity: u32,
+        strategy: FileStrategy,
+    ) -> Result<Self, std::io::Error> {
+        if sec_size == 0 || capacity % sec_size != 0 {
+            return Err(std::io::ErrorKind::InvalidInput.into());
+        }
+        let base_path = path.as_ref().to_path_buf();
+        let sector_num = (capacity / sec_size) as usize;
+        let map_num = match strategy {
+            FileStrategy::Multi => {
+                std::fs::create_dir_all(&base_path)?;
+                sector_num
+            }
+            FileStrategy::Single => {
+                // 单文件模式，确保父目录存在
+                if let Some(parent) = base_path.parent() {
+                    std::fs::create_dir_all(parent)?;
+                }
+                1
+            }
+        };
+
+        let mut storage = Self {
+            strategy,
+            db_name: db_name.to_string(),
+            base_path,
+            sec_size,
+            capacity,
+            maps: (0..map_num).map(|_| None).collect(),
+            dirty: vec![false; sector_num],
+            policy: SyncPolicy::new(Durability::None),
+        };
+        if strategy == FileStrategy::Single {
+            storage.map(0)?;
+        }
+        Ok(storage)
+    }
+
+    /// 设置持久化策略，默认为 [`Durability::None`]（仅在 [`MmapStorage::sync`] 和丢弃时同步）。
+    pub fn with_durability(mut self, durability: Durability) -> Self {
+        self.policy = SyncPolicy::new(durability);
+        self
+    }
+
+    /// 将所有修改过的扇区同步到磁盘（`msync`）。
+    pub fn sync(&mut self) -> Result<(), Error> {
+        for sector_index in 0..self.dirty.len() {
+            if !self.dirty[sector_index] {
+                continue;
+            }
+            match self.strategy {
+                FileStrategy::Single => {
+                    if let Some(map) = &self.maps[0] {
+                        let offset = sector_index * self.sec_size as usize;
+                        map.flush_range(offset, self.sec_size as usize)?;
+                    }
+                }
+                FileStrategy::Multi => {
+                    if let Some(map) = &self.maps[sector_index] {
+                        map.flush()?;
+                    }
+                }
+            }
+            self.dirty[sector_index] = false;
+        }
+        self.policy.synced();
+        Ok(())
+    }
+
+    fn file_path(&self, map_index: usize) -> PathBuf {
+        match self.strategy {
+            FileStrategy::Single => self.base_path.clone(),
+            FileStrategy::Multi => self
+                .base_path
+                .join(format!("{}.fdb.{}", self.db_name, map_index)),
+        }
+    }
+
+    /// 获取（必要时建立）指定编号的映射。
+    fn map(&mut self, map_index: usize) -> Result<&mut MmapMut, std::io::Error> {
+        if self.maps[map_index].is_none() {
+            let map_len = match self.strategy {
+                FileStrategy::Single => self.capacity,
+                FileStrategy::Multi => self.sec_size,
+            } as u64;
+            let file = OpenOptions::new()
+                .read(true)
+                .write(true)
+                .create(true)
+                .open(self.file_path(map_index))?;
+            let file_len = file.metadata()?.len();
+            if file_len < map_len {
+                file.set_len(map_len)?;
+            }
+            let mut map = unsafe { MmapOptions::new().len(map_len as usize).map_mut(&file)? };
+            if file_len < map_len {
+                // 新扩展出的区域视为已擦除
+                map[file_len as usize..].fill(0xFF);
+            }
+            self.maps[map_index] = Some(map);
+        }
+        Ok(self.maps[map_index].as_mut().unwrap())
+    }
+
+    /// 将一段绝对地址区间按映射边界拆分，依次交给 `f` 处理。
+    ///
+    /// `f` 的参数为映射内的切片以及该切片在整个区间中的起始偏移。
+    fn for_each_segment<F>(&mut self, addr: u32, len: usize, mut f: F) -> Result<(), Error>
+    where
+        F: FnMut(&mut [u8], usize),
+    {
+        if addr as u64 + len as u64 > self.capacity as u64 {
+            return Err(Error::InvalidArgument);
+        }
+        let mut done = 0;
+        while done < len {
+            let cur = addr as usize + done;
+            let (map_index, offset, seg_len) = match self.strategy {
+                FileStrategy::Single => (0, cur, len - done),
+                FileStrategy::Multi => {
+                    let sec_size = self.sec_size as usize;
+                    let offset = cur % sec_size;
+                    (cur / sec_size, offset, (len - done).min(sec_size - offset))
+                }
+            };
+            let map = self.map(map_index)?;
+            f(&mut map[offset..offset + seg_len], done);
+            done += seg_len;
+        }
+        Ok(())
+    }
+
+    /// 标记被修改的扇区，并按持久化策略决定是否立即同步
+    fn mark_dirty(&mut self, addr: u32, len: usize, sync: bool) -> Result<(), Error> {
+        if len == 0 {
+            return Ok(());
+        }
+        let first = addr / self.sec_size;
+        let last = (addr + len as u32 - 1) / self.sec_size;
+        for sector_index in first..=last {
+            self.dirty[sector_index as usize] = true;
+        }
+        if self.policy.on_write(sync) {
+            self.sync()?;
+        }
+        Ok(())
+    }
+}
+
+impl Drop for MmapStorage {
+    fn drop(&mut self) {
+        let _ = self.sync();
+    }
+}
+
+impl ErrorType for MmapStorage {
+    type Error = Error;
+}
+
+impl ReadNorFlash for MmapStorage {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        self.for_each_segment(offset, bytes.len(), |seg, pos| {
+            bytes[pos..pos + seg.len()].copy_from_slice(seg);
+        })
+    }
+
+    fn capacity(&self) -> usize {
+        self.capacity as usize
+    }
+}
+
+impl NorFlash for MmapStorage {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = 4096; // 与 StdStorage 一致
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        if to < from {
+            return Err(Error::InvalidArgument);
+        }
+        let size = (to - from) as usize;
+        self.for_each_segment(from, size, |seg, _| seg.fill(0xFF))?;
+        self.mark_dirty(from, size, false)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.write_sync(offset, bytes, false)
+    }
+}
+
+impl SyncNorFlash for MmapStorage {
+    fn write_sync(&mut self, offset: u32, bytes: &[u8], sync: bool) -> Result<(), Self::Error> {
+        self.for_each_segment(offset, bytes.len(), |seg, pos| {
+            seg.copy_from_slice(&bytes[pos..pos + seg.len()]);
+        })?;
+        self.mark_dirty(offset, bytes.len(), sync)
+    }
+
+    fn sync(&mut self) -> Result<(), Self::Error> {
+        MmapStorage::sync(self)
+    }
+}
+
+impl DirectRead for MmapStorage {
+    fn direct(&self, offset: u32, len: usize) -> Option<&[u8]> {
+        if offset as u64 + len as u64 > self.capacity as u64 {
+            return None;
+        }
+        let offset = offset as usize;
+        match self.strategy {
+            FileStrategy::Single => Some(&self.maps[0].as_ref()?[offset..offset + len]),
+            FileStrategy::Multi => {
+                // 多文件模式下只能访问单个扇区内的数据，且该扇区必须已经映射
+                let sec_size = self.sec_size as usize;
+                let sec_offset = offset % sec_size;
+                if sec_offset + len > sec_size {
+                    return None;
+                }
+                Some(&self.maps[offset / sec_size].as_ref()?[sec_offset..sec_offset + len])
+            }
+        }
+    }
+}
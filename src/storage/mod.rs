@@ -0,0 +1,411 @@
+use crate::error::Error;
+use crate::SyncNorFlash;
+use embedded_storage::nor_flash::{ErrorType, NorFlash, ReadNorFlash};
+use lru::LruCache;
+use std::collections::HashSet;
+use std::fs::{File, OpenOptions};
+use std::io::ErrorKind;
+use std::num::NonZeroUsize;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+
+#[cfg(feature = "mmap")]
+mod mmap;
+#[cfg(feature = "mmap")]
+pub use mmap::MmapStorage;
+
+/// 定义文件存储策略
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FileStrategy {
+    /// **单文件模式**: 整个数据库存储在一个大文件中。
+    Single,
+    /// **多文件模式**: 每个扇区存储在一个独立的文件中 (例如 `kv_db.fdb.0`, `kv_db.fdb.1`)。
+    /// 这兼容原始 C 库的文件模式。
+    Multi,
+}
+
+/// 文件存储的持久化策略，决定何时把写入同步到磁盘（`fsync`/`msync`）。
+///
+/// 除 [`Durability::None`] 外，存储在被丢弃时都会同步一次尚未持久化的写入，
+/// 也可以随时调用存储的 `sync()` 方法手动同步。
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum Durability {
+    /// 从不主动同步，落盘时机完全交给操作系统（默认）。
+    ///
+    /// 进程崩溃不会丢失数据，但系统掉电可能丢失最近的写入。
+    #[default]
+    None,
+    /// 每次写入和擦除后都立即同步，最安全也最慢。
+    PerWrite,
+    /// 仅在 C 库标记为需要同步的写入（扇区头部、状态变化等）之后同步。
+    ///
+    /// 需要通过 `KVDB::new_with_sync` / `TSDB::new_with_sync` 创建数据库才能收到该提示，
+    /// 否则等同于 [`Durability::None`]。
+    StatusChange,
+    /// 组提交：累积需要同步的写入，挂起次数达到 `max_pending`，
+    /// 或距离第一次挂起超过 `max_delay` 时统一同步一次。
+    ///
+    /// 时间阈值只在下一次写入时检查，不会启动后台线程。
+    GroupCommit {
+        max_pending: usize,
+        max_delay: Duration,
+    },
+}
+
+/// 根据 [`Durability`] 判断何时需要执行同步
+#[derive(Debug)]
+struct SyncPolicy {
+    durability: Durability,
+    // 组提交模式下挂起的同步请求数量及第一次挂起的时间
+    pending: usize,
+    since: Option<Instant>,
+}
+
+impl SyncPolicy {
+    fn new(durability: Durability) -> Self {
+        Self {
+            durability,
+            pending: 0,
+            since: None,
+        }
+    }
+
+    /// 记录一次写入，返回是否需要立即同步所有未持久化的数据
+    fn on_write(&mut self, sync: bool) -> bool {
+        match self.durability {
+            Durability::None => false,
+            Durability::PerWrite => true,
+            Durability::StatusChange => sync,
+            Durability::GroupCommit {
+                max_pending,
+                max_delay,
+            } => {
+                if sync {
+                    self.pending += 1;
+                    self.since.get_or_insert_with(Instant::now);
+                }
+                match self.since {
+                    Some(since) => self.pending >= max_pending || since.elapsed() >= max_delay,
+                    None => false,
+                }
+            }
+        }
+    }
+
+    fn synced(&mut self) {
+        self.pending = 0;
+        self.since = None;
+    }
+}
+
+/// 默认缓存的文件句柄数量
+pub const DEFAULT_FILE_CACHE_CAPACITY: usize = 64;
+
+// 用于填充已擦除区域的 0xFF 数据块，避免每次擦除都分配缓冲区
+const ERASED_CHUNK: [u8; 4096] = [0xFF; 4096];
+
+/// 缓存的文件句柄，同时记录文件长度，避免每次写入都查询元数据
+struct CachedFile {
+    file: File,
+    len: u64,
+}
+
+/// 一个基于 `std::fs::File` 的 `NorFlash` 实现，用于桌面环境。
+///
+/// 通过 LRU 缓存高效管理文件句柄，读写使用定位 I/O（`pread`/`pwrite`），无需额外的 `seek`。
+/// 写入何时落盘由 [`Durability`] 决定，默认不主动同步。
+///
+/// 文件末尾之后的区域视为已擦除（读取为 `0xFF`），因此擦除只需截断文件，
+/// 不必真正写入 `0xFF`；写入位置超过文件末尾时，中间的空洞会先以 `0xFF` 填充。
+pub struct StdStorage {
+    strategy: FileStrategy,
+    db_name: String,
+    base_path: PathBuf,
+    sec_size: u32,
+    capacity: u32,
+    file_cache: LruCache<u32, CachedFile>,
+    policy: SyncPolicy,
+    // 自上次同步以来写入过的文件（以文件编号标识）
+    dirty: HashSet<u32>,
+}
+
+impl StdStorage {
+    /// 创建一个新的 `StdStorage` 实例。
+    pub fn new<P: AsRef<Path>>(
+        path: P,
+        db_name: &str,
+        sec_size: u32,
+        capacity: u32,
+        strategy: FileStrategy,
+    ) -> Result<Self, std::io::Error> {
+        let base_path = path.as_ref().to_path_buf();
+        if strategy == FileStrategy::Multi {
+            std::fs::create_dir_all(&base_path)?;
+        } else {
+            // 单文件模式，确保父目录存在
+            if let Some(parent) = base_path.parent() {
+                std::fs::create_dir_all(parent)?;
+            }
+        }
+        Ok(Self {
+            strategy,
+            db_name: db_name.to_string(),
+            sec_size,
+            capacity,
+            base_path,
+            file_cache: LruCache::new(NonZeroUsize::new(DEFAULT_FILE_CACHE_CAPACITY).unwrap()),
+            policy: SyncPolicy::new(Durability::None),
+            dirty: HashSet::new(),
+        })
+    }
+
+    /// 设置持久化策略，默认为 [`Durability::None`]。
+    pub fn with_durability(mut self, durability: Durability) -> Self {
+        self.policy = SyncPolicy::new(durability);
+        self
+    }
+
+    /// 将所有尚未持久化的写入同步到磁盘（`fdatasync`）。
+    ///
+    /// 已经被移出句柄缓存的文件会被重新打开后再同步。
+    pub fn sync(&mut self) -> Result<(), Error> {
+        let dirty: Vec<u32> = self.dirty.iter().copied().collect();
+        for file_index in dirty {
+            match self.file_cache.get_mut(&file_index) {
+                Some(cached) => cached.file.sync_data()?,
+                None => OpenOptions::new()
+                    .write(true)
+                    .open(self.file_path(file_index))?
+                    .sync_data()?,
+            }
+            self.dirty.remove(&file_index);
+        }
+        self.policy.synced();
+        Ok(())
+    }
+
+    /// 记录一次对 `file_index` 的修改，并按持久化策略决定是否立即同步
+    fn on_write(&mut self, file_index: u32, sync: bool) -> Result<(), Error> {
+        self.dirty.insert(file_index);
+        if self.policy.on_write(sync) {
+            self.sync()?;
+        }
+        Ok(())
+    }
+
+    fn file_index(&self, addr: u32) -> u32 {
+        match self.strategy {
+            FileStrategy::Single => 0,
+            FileStrategy::Multi => addr / self.sec_size,
+        }
+    }
+
+    fn file_path(&self, file_index: u32) -> PathBuf {
+        match self.strategy {
+            FileStrategy::Single => self.base_path.clone(),
+            FileStrategy::Multi => self
+                .base_path
+                .join(format!("{}.fdb.{}", self.db_name, file_index)),
+        }
+    }
+
+    /// 设置缓存的文件句柄数量，默认为 [`DEFAULT_FILE_CACHE_CAPACITY`]。
+    ///
+    /// 多文件模式下每个扇区对应一个文件，缓存容量过小会导致 GC 和启动加载时频繁重新打开文件。
+    /// 传入 `0` 表示不限制容量，所有打开过的扇区文件都会保持打开状态（注意进程的文件描述符上限）。
+    pub fn with_cache_capacity(mut self, capacity: usize) -> Self {
+        self.file_cache = match NonZeroUsize::new(capacity) {
+            Some(capacity) => LruCache::new(capacity),
+            None => LruCache::unbounded(),
+        };
+        self
+    }
+
+    /// 根据地址获取对应的文件句柄和文件内偏移量。
+    fn get_file_and_offset(
+        &mut self,
+        addr: u32,
+    ) -> Result<(&mut CachedFile, u64), std::io::Error> {
+        let (sector_index, offset_in_file) = match self.strategy {
+            FileStrategy::Single => (0, addr as u64),
+            FileStrategy::Multi => {
+                let sector_index = addr / self.sec_size;
+                let offset = (addr % self.sec_size) as u64;
+                (sector_index, offset)
+            }
+        };
+
+        if !self.file_cache.contains(&sector_index) {
+            let file = OpenOptions::new()
+                .read(true)
+                .write(true)
+                .create(true)
+                .open(self.file_path(sector_index))?;
+            let len = file.metadata()?.len();
+            self.file_cache.put(sector_index, CachedFile { file, len });
+        }
+
+        let cached = self.file_cache.get_mut(&sector_index).unwrap();
+        Ok((cached, offset_in_file))
+    }
+}
+
+// 定位读写，不改变（也不依赖）文件游标
+#[cfg(unix)]
+fn read_at(file: &File, buf: &mut [u8], offset: u64) -> std::io::Result<usize> {
+    std::os::unix::fs::FileExt::read_at(file, buf, offset)
+}
+
+#[cfg(unix)]
+fn write_at(file: &File, buf: &[u8], offset: u64) -> std::io::Result<usize> {
+    std::os::unix::fs::FileExt::write_at(file, buf, offset)
+}
+
+#[cfg(windows)]
+fn read_at(file: &File, buf: &mut [u8], offset: u64) -> std::io::Result<usize> {
+    std::os::windows::fs::FileExt::seek_read(file, buf, offset)
+}
+
+#[cfg(windows)]
+fn write_at(file: &File, buf: &[u8], offset: u64) -> std::io::Result<usize> {
+    std::os::windows::fs::FileExt::seek_write(file, buf, offset)
+}
+
+#[cfg(not(any(unix, windows)))]
+fn read_at(mut file: &File, buf: &mut [u8], offset: u64) -> std::io::Result<usize> {
+    use std::io::{Read as StdRead, Seek as StdSeek};
+    file.seek(std::io::SeekFrom::Start(offset))?;
+    file.read(buf)
+}
+
+#[cfg(not(any(unix, windows)))]
+fn write_at(mut file: &File, buf: &[u8], offset: u64) -> std::io::Result<usize> {
+    use std::io::{Seek as StdSeek, Write as StdWrite};
+    file.seek(std::io::SeekFrom::Start(offset))?;
+    file.write(buf)
+}
+
+/// 从 `offset` 处读满 `buf`，超出文件末尾的部分按未写入的 Flash 处理，填充 0xFF。
+fn read_exact_at(file: &File, mut buf: &mut [u8], mut offset: u64) -> std::io::Result<()> {
+    while !buf.is_empty() {
+        match read_at(file, buf, offset) {
+            Ok(0) => {
+                buf.fill(0xFF);
+                break;
+            }
+            Ok(n) => {
+                buf = &mut buf[n..];
+                offset += n as u64;
+            }
+            Err(e) if e.kind() == ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(())
+}
+
+/// 以 `0xFF` 填充 `[offset, offset + len)`
+fn fill_erased_at(file: &File, mut offset: u64, len: u64) -> std::io::Result<()> {
+    let end = offset + len;
+    while offset < end {
+        let chunk = (end - offset).min(ERASED_CHUNK.len() as u64) as usize;
+        write_all_at(file, &ERASED_CHUNK[..chunk], offset)?;
+        offset += chunk as u64;
+    }
+    Ok(())
+}
+
+fn write_all_at(file: &File, mut buf: &[u8], mut offset: u64) -> std::io::Result<()> {
+    while !buf.is_empty() {
+        match write_at(file, buf, offset) {
+            Ok(0) => return Err(ErrorKind::WriteZero.into()),
+            Ok(n) => {
+                buf = &buf[n..];
+                offset += n as u64;
+            }
+            Err(e) if e.kind() == ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(())
+}
+
+impl ErrorType for StdStorage {
+    type Error = Error;
+}
+
+impl ReadNorFlash for StdStorage {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        let (cached, file_offset) = self.get_file_and_offset(offset)?;
+        // Flash 存储在未写入区域读取时通常返回0xFF
+        read_exact_at(&cached.file, bytes, file_offset)?;
+        Ok(())
+    }
+
+    fn capacity(&self) -> usize {
+        self.capacity as usize
+    }
+}
+
+impl NorFlash for StdStorage {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = 4096; // 这是一个典型值，我们将 sec_size 作为擦除大小
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        if to < from {
+            return Err(Error::InvalidArgument);
+        }
+        let size = (to - from) as u64;
+        if self.strategy == FileStrategy::Multi
+            && (from % self.sec_size != 0 || size != self.sec_size as u64)
+        {
+            return Err(Error::InvalidArgument);
+        }
+
+        // 擦除操作是基于绝对地址的
+        let (cached, offset) = self.get_file_and_offset(from)?;
+        if offset + size >= cached.len {
+            // 擦除范围覆盖到文件末尾：直接截断，末尾之后的区域读取时即为 0xFF
+            if offset < cached.len {
+                cached.file.set_len(offset)?;
+                cached.len = offset;
+            }
+        } else {
+            // 单文件模式下擦除中间的扇区，只能真正写入 0xFF
+            fill_erased_at(&cached.file, offset, size)?;
+        }
+        self.on_write(self.file_index(from), false)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.write_sync(offset, bytes, false)
+    }
+}
+
+impl SyncNorFlash for StdStorage {
+    fn write_sync(&mut self, offset: u32, bytes: &[u8], sync: bool) -> Result<(), Self::Error> {
+        let (cached, file_offset) = self.get_file_and_offset(offset)?;
+        if file_offset > cached.len {
+            // 文件末尾与写入位置之间的空洞属于已擦除区域，不能留作文件系统默认的 0x00
+            fill_erased_at(&cached.file, cached.len, file_offset - cached.len)?;
+        }
+        // `File` 没有用户态缓冲，`flush` 不会落盘，持久化完全由同步策略负责
+        write_all_at(&cached.file, bytes, file_offset)?;
+        cached.len = cached.len.max(file_offset + bytes.len() as u64);
+        self.on_write(self.file_index(offset), sync)
+    }
+
+    fn sync(&mut self) -> Result<(), Self::Error> {
+        StdStorage::sync(self)
+    }
+}
+
+impl Drop for StdStorage {
+    fn drop(&mut self) {
+        if self.policy.durability != Durability::None {
+            let _ = self.sync();
+        }
+    }
+}
\ No newline at end of file
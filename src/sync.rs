@@ -0,0 +1,109 @@
+use crate::{fdb_db_t, FlashDispatch};
+use core::ops::{Deref, DerefMut};
+use std::sync::{Condvar, Mutex, MutexGuard};
+use std::thread::{self, ThreadId};
+
+/// `SharedKVDB`/`SharedTSDB` 使用的数据库锁。
+///
+/// Rust 侧每次访问数据库都要独占此锁；C 库通过 `db_lock`/`db_unlock` 钩子在同一线程内
+/// 可重入地获取它，因此 C 库内部的临界区（包括 GC）与 Rust 侧的访问始终互斥。
+#[derive(Default)]
+pub(crate) struct DbLock {
+    state: Mutex<LockState>,
+    released: Condvar,
+}
+
+#[derive(Default)]
+struct LockState {
+    owner: Option<ThreadId>,
+    depth: usize,
+}
+
+impl DbLock {
+    fn state(&self) -> MutexGuard<'_, LockState> {
+        self.state.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// 获取锁，已被当前线程持有时只增加计数
+    fn enter(&self) {
+        let current = thread::current().id();
+        let mut state = self.state();
+        while state.owner.is_some() && state.owner != Some(current) {
+            state = self.released.wait(state).unwrap_or_else(|e| e.into_inner());
+        }
+        state.owner = Some(current);
+        state.depth += 1;
+    }
+
+    fn exit(&self) {
+        let mut state = self.state();
+        state.depth -= 1;
+        if state.depth == 0 {
+            state.owner = None;
+            self.released.notify_one();
+        }
+    }
+
+    /// 独占地访问 `value`。
+    ///
+    /// 返回的守卫提供 `&mut T`，因此同一线程在持有守卫时不能再次获取，否则 panic。
+    pub(crate) fn guard<'a, T: ?Sized>(&'a self, value: *mut T) -> DbGuard<'a, T> {
+        {
+            let state = self.state();
+            assert!(
+                state.owner != Some(thread::current().id()),
+                "the database is already locked by the current thread"
+            );
+        }
+        self.enter();
+        DbGuard {
+            lock: self,
+            value: unsafe { &mut *value },
+        }
+    }
+}
+
+/// 数据库锁的守卫，离开作用域时释放锁。
+pub struct DbGuard<'a, T: ?Sized> {
+    lock: &'a DbLock,
+    value: &'a mut T,
+}
+
+impl<T: ?Sized> Deref for DbGuard<'_, T> {
+    type Target = T;
+
+    fn deref(&self) -> &T {
+        self.value
+    }
+}
+
+impl<T: ?Sized> DerefMut for DbGuard<'_, T> {
+    fn deref_mut(&mut self) -> &mut T {
+        self.value
+    }
+}
+
+impl<T: ?Sized> Drop for DbGuard<'_, T> {
+    fn drop(&mut self) {
+        self.lock.exit();
+    }
+}
+
+unsafe fn lock_of<'a>(db: fdb_db_t) -> Option<&'a DbLock> {
+    let dispatch = ((*db).user_data as *const FlashDispatch).as_ref()?;
+    (dispatch.lock as *const DbLock).as_ref()
+}
+
+// --- 通过 FDB_KVDB_CTRL_SET_LOCK / FDB_TSDB_CTRL_SET_LOCK 安装到 C 库的钩子 ---
+
+pub(crate) unsafe extern "C" fn db_lock_hook(db: fdb_db_t) {
+    if let Some(lock) = lock_of(db) {
+        lock.enter();
+    }
+}
+
+pub(crate) unsafe extern "C" fn db_unlock_hook(db: fdb_db_t) {
+    if let Some(lock) = lock_of(db) {
+        lock.exit();
+    }
+}
@@ -0,0 +1,545 @@
+use super::TSDB;
+use crate::Error;
+use core::marker::PhantomData;
+use embedded_storage::nor_flash::NorFlash;
+
+// 块头：编码方式（1 字节）+ 样本数量（u16，小端），之后是按位写入的样本
+const HEADER_SIZE: usize = 3;
+// 单个样本编码后的最大位数：时间戳 4 + 64，数值 2 + 5 + 6 + 64（XOR）或 80（varint）
+const SAMPLE_MAX_BITS: usize = 148;
+
+/// 样本数值的编码方式。
+#[repr(u8)]
+#[derive(Debug, PartialEq, Eq, Clone, Copy)]
+pub enum SampleCodec {
+    /// 与前一个值按位异或，只保存有效位（Gorilla），适合缓慢变化的浮点数。
+    Xor = 1,
+    /// 与前一个值的差值经 zigzag 后按 varint 保存，适合计数器等整数。
+    Varint = 2,
+}
+
+/// 可以保存在 [`SampleBlock`] 中的数值类型。
+pub trait SampleValue: Copy {
+    /// 此类型使用的编码方式
+    const CODEC: SampleCodec;
+    fn to_raw(self) -> u64;
+    fn from_raw(raw: u64) -> Self;
+}
+
+impl SampleValue for f64 {
+    const CODEC: SampleCodec = SampleCodec::Xor;
+    fn to_raw(self) -> u64 {
+        self.to_bits()
+    }
+    fn from_raw(raw: u64) -> Self {
+        f64::from_bits(raw)
+    }
+}
+
+impl SampleValue for f32 {
+    const CODEC: SampleCodec = SampleCodec::Xor;
+    fn to_raw(self) -> u64 {
+        self.to_bits() as u64
+    }
+    fn from_raw(raw: u64) -> Self {
+        f32::from_bits(raw as u32)
+    }
+}
+
+impl SampleValue for i64 {
+    const CODEC: SampleCodec = SampleCodec::Varint;
+    fn to_raw(self) -> u64 {
+        self as u64
+    }
+    fn from_raw(raw: u64) -> Self {
+        raw as i64
+    }
+}
+
+impl SampleValue for i32 {
+    const CODEC: SampleCodec = SampleCodec::Varint;
+    fn to_raw(self) -> u64 {
+        self as i64 as u64
+    }
+    fn from_raw(raw: u64) -> Self {
+        raw as i64 as i32
+    }
+}
+
+impl SampleValue for u32 {
+    const CODEC: SampleCodec = SampleCodec::Varint;
+    fn to_raw(self) -> u64 {
+        self as u64
+    }
+    fn from_raw(raw: u64) -> Self {
+        raw as u32
+    }
+}
+
+/// 编码与解码共用的前一个样本的状态
+#[derive(Debug, Clone, Copy, Default)]
+struct CodecState {
+    time: i64,
+    delta: i64,
+    value: u64,
+    // XOR 编码上一次使用的有效位窗口，`window_bits` 为 0 表示没有可复用的窗口
+    leading: u32,
+    window_bits: u32,
+}
+
+/// 按列压缩的样本块，编码后的内容作为一条 TSL 保存。
+///
+/// 时间戳使用 delta-of-delta 编码，固定采样间隔的样本每个只占 1 位；数值按 [`SampleValue::CODEC`]
+/// 使用 XOR 或 varint 编码。块内容保存在长度为 `N` 的内部缓冲区中，不需要分配内存，
+/// `N` 不能超过数据库的 `entry_max`。
+///
+/// 通常通过 [`TSDB::append_sample`] 写入，块写满时会自动作为一条 TSL 追加到数据库，
+/// TSL 的时间戳为块内最后一个样本的时间戳。读取时使用 [`SampleDecoder`] 逐个解码，
+/// 或者通过 [`TSDB::samples_by_time`] 按时间范围遍历。
+pub struct SampleBlock<V: SampleValue, const N: usize> {
+    buf: [u8; N],
+    // 已写入的位数
+    bit_len: usize,
+    count: u16,
+    state: CodecState,
+    _marker: PhantomData<V>,
+}
+
+impl<V: SampleValue, const N: usize> Default for SampleBlock<V, N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<V: SampleValue, const N: usize> SampleBlock<V, N> {
+    /// 创建一个空的样本块。
+    pub fn new() -> Self {
+        assert!(N > HEADER_SIZE, "the sample block is too small");
+        let mut block = Self {
+            buf: [0; N],
+            bit_len: HEADER_SIZE * 8,
+            count: 0,
+            state: CodecState::default(),
+            _marker: PhantomData,
+        };
+        block.buf[0] = V::CODEC as u8;
+        block
+    }
+
+    /// 块内的样本数量
+    pub fn len(&self) -> usize {
+        self.count as usize
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.count == 0
+    }
+
+    /// 块内最后一个样本的时间戳，块为空时返回 `None`
+    pub fn last_time(&self) -> Option<i64> {
+        (self.count > 0).then_some(self.state.time)
+    }
+
+    /// 编码后的块内容
+    pub fn as_bytes(&self) -> &[u8] {
+        &self.buf[..(self.bit_len + 7) / 8]
+    }
+
+    /// 清空块，以便写入下一批样本
+    pub fn clear(&mut self) {
+        *self = Self::new();
+    }
+
+    /// 向块中追加一个样本。
+    ///
+    /// # 返回
+    /// - `Err(Error::WriteError)`: 时间戳不大于块内最后一个样本的时间戳
+    /// - `Err(Error::SavedFull)`: 块已满，块内容保持不变
+    pub fn push(&mut self, time: i64, value: V) -> Result<(), Error> {
+        if self.count > 0 && time <= self.state.time {
+            return Err(Error::WriteError);
+        }
+        if self.count == u16::MAX {
+            return Err(Error::SavedFull);
+        }
+
+        let start = self.bit_len;
+        let saved = self.state;
+        if self.encode(time, value.to_raw()).is_none() {
+            // 清除写了一半的样本
+            for bit in start..self.bit_len {
+                self.buf[bit / 8] &= !(0x80 >> (bit % 8));
+            }
+            self.bit_len = start;
+            self.state = saved;
+            return Err(Error::SavedFull);
+        }
+        self.count += 1;
+        self.buf[1..3].copy_from_slice(&self.count.to_le_bytes());
+        Ok(())
+    }
+
+    /// 剩余空间是否一定能容纳下一个样本
+    pub fn has_room(&self) -> bool {
+        self.bit_len + SAMPLE_MAX_BITS <= N * 8
+    }
+
+    fn encode(&mut self, time: i64, raw: u64) -> Option<()> {
+        let state = &mut self.state;
+        let mut writer = BitWriter {
+            buf: &mut self.buf,
+            bit_len: &mut self.bit_len,
+        };
+
+        if self.count == 0 {
+            writer.write(time as u64, 64)?;
+            writer.write(raw, 64)?;
+            *state = CodecState {
+                time,
+                value: raw,
+                ..Default::default()
+            };
+            return Some(());
+        }
+
+        // 时间戳：delta-of-delta，按范围使用不同长度的前缀
+        let delta = time.wrapping_sub(state.time);
+        let dod = delta.wrapping_sub(state.delta);
+        match dod {
+            0 => writer.write(0b0, 1)?,
+            -64..=63 => {
+                writer.write(0b10, 2)?;
+                writer.write(dod as u64, 7)?;
+            }
+            -256..=255 => {
+                writer.write(0b110, 3)?;
+                writer.write(dod as u64, 9)?;
+            }
+            -2048..=2047 => {
+                writer.write(0b1110, 4)?;
+                writer.write(dod as u64, 12)?;
+            }
+            _ => {
+                writer.write(0b1111, 4)?;
+                writer.write(dod as u64, 64)?;
+            }
+        }
+
+        match V::CODEC {
+            SampleCodec::Xor => {
+                let xor = raw ^ state.value;
+                if xor == 0 {
+                    writer.write(0b0, 1)?;
+                } else {
+                    let leading = xor.leading_zeros().min(31);
+                    let trailing = xor.trailing_zeros();
+                    let window_trailing = 64 - state.leading - state.window_bits;
+                    if state.window_bits > 0 && leading >= state.leading && trailing >= window_trailing {
+                        // 有效位落在上一个窗口内，只写入窗口中的位
+                        writer.write(0b10, 2)?;
+                        writer.write(xor >> window_trailing, state.window_bits)?;
+                    } else {
+                        let bits = 64 - leading - trailing;
+                        writer.write(0b11, 2)?;
+                        writer.write(leading as u64, 5)?;
+                        writer.write((bits - 1) as u64, 6)?;
+                        writer.write(xor >> trailing, bits)?;
+                        state.leading = leading;
+                        state.window_bits = bits;
+                    }
+                }
+            }
+            SampleCodec::Varint => {
+                let diff = (raw as i64).wrapping_sub(state.value as i64);
+                let mut zigzag = ((diff << 1) ^ (diff >> 63)) as u64;
+                loop {
+                    let byte = (zigzag & 0x7F) as u8;
+                    zigzag >>= 7;
+                    if zigzag == 0 {
+                        writer.write(byte as u64, 8)?;
+                        break;
+                    }
+                    writer.write((byte | 0x80) as u64, 8)?;
+                }
+            }
+        }
+
+        state.time = time;
+        state.delta = delta;
+        state.value = raw;
+        Some(())
+    }
+}
+
+struct BitWriter<'a> {
+    buf: &'a mut [u8],
+    bit_len: &'a mut usize,
+}
+
+impl BitWriter<'_> {
+    /// 按高位在前写入 `value` 的低 `bits` 位，空间不足时返回 `None`
+    fn write(&mut self, value: u64, bits: u32) -> Option<()> {
+        if *self.bit_len + bits as usize > self.buf.len() * 8 {
+            return None;
+        }
+        for i in (0..bits).rev() {
+            if (value >> i) & 1 == 1 {
+                self.buf[*self.bit_len / 8] |= 0x80 >> (*self.bit_len % 8);
+            }
+            *self.bit_len += 1;
+        }
+        Some(())
+    }
+}
+
+struct BitReader<'a> {
+    buf: &'a [u8],
+    bit_pos: usize,
+}
+
+impl BitReader<'_> {
+    fn read(&mut self, bits: u32) -> Option<u64> {
+        if self.bit_pos + bits as usize > self.buf.len() * 8 {
+            return None;
+        }
+        let mut value = 0u64;
+        for _ in 0..bits {
+            let bit = (self.buf[self.bit_pos / 8] >> (7 - self.bit_pos % 8)) & 1;
+            value = (value << 1) | bit as u64;
+            self.bit_pos += 1;
+        }
+        Some(value)
+    }
+
+    /// 读取 `bits` 位的补码整数
+    fn read_signed(&mut self, bits: u32) -> Option<i64> {
+        let value = self.read(bits)?;
+        let shift = 64 - bits;
+        Some(((value << shift) as i64) >> shift)
+    }
+
+    /// 读取前缀中连续 1 的个数，最多 `max` 个
+    fn read_prefix(&mut self, max: u32) -> Option<u32> {
+        let mut ones = 0;
+        while ones < max && self.read(1)? == 1 {
+            ones += 1;
+        }
+        Some(ones)
+    }
+}
+
+/// [`SampleBlock`] 的解码器，按顺序逐个解码样本，不需要分配内存。
+///
+/// 数据不完整或编码方式与 `V` 不符时迭代提前结束。
+pub struct SampleDecoder<'a, V: SampleValue> {
+    reader: BitReader<'a>,
+    remain: u16,
+    first: bool,
+    state: CodecState,
+    _marker: PhantomData<V>,
+}
+
+impl<'a, V: SampleValue> SampleDecoder<'a, V> {
+    /// 解码一条由 [`SampleBlock`] 写入的 TSL 内容。
+    pub fn new(data: &'a [u8]) -> Self {
+        let remain = if data.len() >= HEADER_SIZE && data[0] == V::CODEC as u8 {
+            u16::from_le_bytes([data[1], data[2]])
+        } else {
+            0
+        };
+        Self {
+            reader: BitReader {
+                buf: data,
+                bit_pos: HEADER_SIZE * 8,
+            },
+            remain,
+            first: true,
+            state: CodecState::default(),
+            _marker: PhantomData,
+        }
+    }
+
+    /// 尚未解码的样本数量
+    pub fn remaining(&self) -> usize {
+        self.remain as usize
+    }
+
+    fn decode(&mut self) -> Option<(i64, u64)> {
+        let reader = &mut self.reader;
+        let state = &mut self.state;
+
+        if self.first {
+            self.first = false;
+            state.time = reader.read(64)? as i64;
+            state.value = reader.read(64)?;
+            return Some((state.time, state.value));
+        }
+
+        let dod = match reader.read_prefix(4)? {
+            0 => 0,
+            1 => reader.read_signed(7)?,
+            2 => reader.read_signed(9)?,
+            3 => reader.read_signed(12)?,
+            _ => reader.read(64)? as i64,
+        };
+        state.delta = state.delta.wrapping_add(dod);
+        state.time = state.time.wrapping_add(state.delta);
+
+        match V::CODEC {
+            SampleCodec::Xor => match reader.read_prefix(2)? {
+                0 => {}
+                1 => {
+                    if state.window_bits == 0 {
+                        return None;
+                    }
+                    let trailing = 64 - state.leading - state.window_bits;
+                    state.value ^= reader.read(state.window_bits)? << trailing;
+                }
+                _ => {
+                    state.leading = reader.read(5)? as u32;
+                    state.window_bits = reader.read(6)? as u32 + 1;
+                    if state.leading + state.window_bits > 64 {
+                        return None;
+                    }
+                    let trailing = 64 - state.leading - state.window_bits;
+                    state.value ^= reader.read(state.window_bits)? << trailing;
+                }
+            },
+            SampleCodec::Varint => {
+                let mut zigzag = 0u64;
+                let mut shift = 0;
+                loop {
+                    let byte = reader.read(8)?;
+                    if shift < 64 {
+                        zigzag |= (byte & 0x7F) << shift;
+                    }
+                    shift += 7;
+                    if byte & 0x80 == 0 {
+                        break;
+                    }
+                }
+                let diff = ((zigzag >> 1) as i64) ^ -((zigzag & 1) as i64);
+                state.value = (state.value as i64).wrapping_add(diff) as u64;
+            }
+        }
+        Some((state.time, state.value))
+    }
+}
+
+impl<V: SampleValue> Iterator for SampleDecoder<'_, V> {
+    type Item = (i64, V);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.remain == 0 {
+            return None;
+        }
+        match self.decode() {
+            Some((time, raw)) => {
+                self.remain -= 1;
+                Some((time, V::from_raw(raw)))
+            }
+            None => {
+                self.remain = 0;
+                None
+            }
+        }
+    }
+}
+
+/// 时间戳能否无损地保存为 `fdb_time_t`，未启用 `time64` 特性时它只有 32 位
+fn time_fits(time: i64) -> bool {
+    crate::fdb_time_t::try_from(time).is_ok()
+}
+
+impl<S: NorFlash> TSDB<S> {
+    /// 把一个样本写入样本块，块写满时先把块作为一条 TSL 追加到数据库。
+    ///
+    /// # 参数
+    /// - `block`: 样本块，写满前样本只保存在内存中，必要时调用 [`TSDB::flush_samples`] 写入
+    /// - `time`: 样本的时间戳，必须严格递增
+    /// - `value`: 样本的值
+    ///
+    /// # 返回
+    /// - `Err(Error::InvalidArgument)`: 时间戳超出 `fdb_time_t` 的范围
+    /// - `Err(Error::WriteError)`: 时间戳不大于上一个样本或数据库中最后一条 TSL 的时间戳
+    /// - `Err(Error)`: 追加块失败，块内容保持不变
+    pub fn append_sample<V: SampleValue, const N: usize>(
+        &mut self,
+        block: &mut SampleBlock<V, N>,
+        time: i64,
+        value: V,
+    ) -> Result<(), Error> {
+        if !time_fits(time) {
+            return Err(Error::InvalidArgument);
+        }
+        if block.is_empty() && time <= self.last_time() {
+            return Err(Error::WriteError);
+        }
+        match block.push(time, value) {
+            Err(Error::SavedFull) if !block.is_empty() => {
+                self.flush_samples(block)?;
+                block.push(time, value)
+            }
+            result => result,
+        }
+    }
+
+    /// 把样本块中尚未写入的样本作为一条 TSL 追加到数据库，并清空样本块。
+    ///
+    /// # 返回
+    /// - `Err(Error::InvalidArgument)`: 块内最后一个样本的时间戳（即 TSL 的时间戳）超出 `fdb_time_t` 的范围
+    pub fn flush_samples<V: SampleValue, const N: usize>(&mut self, block: &mut SampleBlock<V, N>) -> Result<(), Error> {
+        if let Some(last_time) = block.last_time() {
+            if !time_fits(last_time) {
+                return Err(Error::InvalidArgument);
+            }
+            self.append_with_timestamp(last_time, block.as_bytes())?;
+            block.clear();
+        }
+        Ok(())
+    }
+
+    /// 按时间范围遍历由 [`SampleBlock`] 写入的样本（`alloc` 特性）。
+    ///
+    /// 每条 TSL 的时间戳是块内最后一个样本的时间戳，因此从第一条时间戳不小于 `from`
+    /// 的 TSL 开始逐块解码，遇到时间戳大于 `to` 的样本即结束。已删除的块会被跳过。
+    ///
+    /// # 参数
+    /// - `from`: 起始时间戳（包含）
+    /// - `to`: 结束时间戳（包含）
+    /// - `callback`: 样本回调，返回 `false` 可提前终止
+    #[cfg(feature = "alloc")]
+    pub fn samples_by_time<V, F>(&mut self, from: i64, to: i64, mut callback: F) -> Result<(), Error>
+    where
+        V: SampleValue,
+        F: FnMut(i64, V) -> bool + Send,
+    {
+        // 查询的时间戳会转换为 fdb_time_t，超出范围时截断会使 from > to，变成逆序查询
+        let (min, max) = (crate::fdb_time_t::MIN as i64, crate::fdb_time_t::MAX as i64);
+        if from > max || to < min {
+            return Ok(());
+        }
+        let mut buf = alloc::vec![0u8; self.inner.max_len];
+        let mut result = Ok(());
+        self.tsdb_iter_by_time(from.max(min), max, |db, tsl| {
+            let len = match db.get_value_into(tsl, &mut buf) {
+                Ok(Some(len)) => len,
+                Ok(None) => return true,
+                Err(err) => {
+                    result = Err(err);
+                    return false;
+                }
+            };
+            for (time, value) in SampleDecoder::<V>::new(&buf[..len]) {
+                if time > to {
+                    return false;
+                }
+                if time >= from && !callback(time, value) {
+                    return false;
+                }
+            }
+            true
+        });
+        result
+    }
+}
@@ -0,0 +1,377 @@
+use super::TSDB;
+use crate::Error;
+use core::cell::UnsafeCell;
+use core::mem::MaybeUninit;
+use core::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use embedded_storage::nor_flash::NorFlash;
+use std::sync::{Condvar, Mutex, MutexGuard};
+use std::time::Duration;
+
+/// [`IngestBuffer`] 的配置。
+#[derive(Debug, Clone)]
+pub struct IngestConfig {
+    /// 缓冲区能容纳的条目数，会向上取整为 2 的幂
+    pub capacity: usize,
+    /// 缓冲的条目达到此数量时立即写入
+    pub batch_size: usize,
+    /// 距离上次写入超过此时间后，即使条目不足 `batch_size` 也会写入
+    pub flush_interval: Duration,
+}
+
+impl Default for IngestConfig {
+    fn default() -> Self {
+        Self {
+            capacity: 4096,
+            batch_size: 256,
+            flush_interval: Duration::from_millis(100),
+        }
+    }
+}
+
+/// [`IngestBuffer::push`] 失败的原因。
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PushError {
+    /// 缓冲区已满（背压），写入者跟不上生产者
+    Full,
+    /// 缓冲区已关闭
+    Closed,
+}
+
+/// [`IngestBuffer`] 的统计信息。
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct IngestStats {
+    /// 成功放入缓冲区的条目数
+    pub pushed: u64,
+    /// 因缓冲区已满被拒绝的条目数
+    pub rejected: u64,
+    /// 已写入 TSDB 的条目数
+    pub written: u64,
+    /// 时间戳不大于已写入的最新时间戳而被丢弃的条目数
+    pub dropped: u64,
+}
+
+/// TSDB 的写缓冲前端（`std` 特性）。
+///
+/// 多个生产者线程通过 [`IngestBuffer::push`] 把 `(时间戳, 数据)` 放入一个有界的无锁队列，
+/// 队列满时立即返回 [`PushError::Full`]，不会等待 Flash。唯一的写入线程运行
+/// [`IngestBuffer::run`]，在条目数量达到 `batch_size` 或超过 `flush_interval` 时取出所有条目，
+/// 按时间戳排序后通过 [`TSDB::append_batch`] 写入。
+///
+/// 不同生产者的时间戳可能交错，同一批内会重新排序；但时间戳不大于已写入的最新时间戳的条目
+/// 无法再写入 TSDB，会被丢弃并计入 [`IngestStats::dropped`]。
+///
+/// # 示例
+///
+/// `TSDB` 不能跨线程移动，写入循环运行在拥有数据库的线程中：
+///
+/// ```ignore
+/// let buffer = IngestBuffer::new(IngestConfig::default());
+/// std::thread::scope(|scope| {
+///     scope.spawn(|| {
+///         buffer.push(now(), b"sample").unwrap();
+///         buffer.flush().unwrap();
+///         buffer.close();
+///     });
+///     buffer.run(&mut tsdb).unwrap();
+/// });
+/// ```
+pub struct IngestBuffer {
+    queue: Queue<(i64, Vec<u8>)>,
+    config: IngestConfig,
+    state: Mutex<FlushState>,
+    // 唤醒写入线程
+    wake: Condvar,
+    // 唤醒等待 flush 的线程
+    flushed: Condvar,
+    closed: AtomicBool,
+    // 队列只允许一个消费者，同一时刻只能有一个线程取出条目
+    consumer: Mutex<()>,
+    pushed: AtomicU64,
+    rejected: AtomicU64,
+    written: AtomicU64,
+    dropped: AtomicU64,
+}
+
+#[derive(Default)]
+struct FlushState {
+    // 已处理完的队列位置，之前的条目都已写入或丢弃
+    done: usize,
+    // 等待中的 flush 请求
+    requested: bool,
+    // 写入过程中发生过错误
+    failed: bool,
+}
+
+impl IngestBuffer {
+    /// 创建一个新的写缓冲。
+    pub fn new(config: IngestConfig) -> Self {
+        assert!(config.batch_size > 0, "batch size MUST be more than 0");
+        Self {
+            queue: Queue::new(config.capacity.max(2)),
+            config,
+            state: Mutex::new(FlushState::default()),
+            wake: Condvar::new(),
+            flushed: Condvar::new(),
+            closed: AtomicBool::new(false),
+            consumer: Mutex::new(()),
+            pushed: AtomicU64::new(0),
+            rejected: AtomicU64::new(0),
+            written: AtomicU64::new(0),
+            dropped: AtomicU64::new(0),
+        }
+    }
+
+    fn state(&self) -> MutexGuard<'_, FlushState> {
+        self.state.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// 放入一个条目，不会阻塞。
+    ///
+    /// # 返回
+    /// - `Err(PushError::Full)`: 缓冲区已满，调用者可以稍后重试或丢弃该条目。
+    /// - `Err(PushError::Closed)`: 缓冲区已关闭。
+    pub fn push(&self, timestamp: i64, data: &[u8]) -> Result<(), PushError> {
+        if self.closed.load(Ordering::Acquire) {
+            return Err(PushError::Closed);
+        }
+        match self.queue.push((timestamp, data.to_vec())) {
+            Ok(len) => {
+                self.pushed.fetch_add(1, Ordering::Relaxed);
+                // 只在刚好达到阈值时唤醒写入线程，其余情况下不触碰锁
+                if len == self.config.batch_size {
+                    let _state = self.state();
+                    self.wake.notify_one();
+                }
+                Ok(())
+            }
+            Err(_) => {
+                self.rejected.fetch_add(1, Ordering::Relaxed);
+                Err(PushError::Full)
+            }
+        }
+    }
+
+    /// 缓冲区中尚未写入的条目数。
+    pub fn pending(&self) -> usize {
+        self.queue.len()
+    }
+
+    /// 统计信息。
+    pub fn stats(&self) -> IngestStats {
+        IngestStats {
+            pushed: self.pushed.load(Ordering::Relaxed),
+            rejected: self.rejected.load(Ordering::Relaxed),
+            written: self.written.load(Ordering::Relaxed),
+            dropped: self.dropped.load(Ordering::Relaxed),
+        }
+    }
+
+    /// 等待调用之前放入的所有条目写入 TSDB。
+    ///
+    /// 写入线程必须正在运行 [`IngestBuffer::run`]，否则会一直等待。
+    ///
+    /// # 返回
+    /// - `Err(Error::WriteError)`: 写入过程中发生过错误，部分条目可能没有写入。
+    pub fn flush(&self) -> Result<(), Error> {
+        let target = self.queue.tail();
+        let mut state = self.state();
+        while !state.failed && (state.done.wrapping_sub(target) as isize) < 0 {
+            state.requested = true;
+            self.wake.notify_one();
+            state = self.flushed.wait(state).unwrap_or_else(|e| e.into_inner());
+        }
+        if state.failed {
+            Err(Error::WriteError)
+        } else {
+            Ok(())
+        }
+    }
+
+    /// 关闭缓冲区，之后的 `push` 都会失败，[`IngestBuffer::run`] 写完剩余条目后返回。
+    ///
+    /// 与 `close` 同时进行的 `push` 可能在 `run` 返回后才完成，这些条目可以通过
+    /// [`IngestBuffer::drain_into`] 写入。
+    pub fn close(&self) {
+        self.closed.store(true, Ordering::Release);
+        let _state = self.state();
+        self.wake.notify_one();
+    }
+
+    /// 写入线程的主循环，直到 [`IngestBuffer::close`] 被调用且缓冲区为空时返回。
+    ///
+    /// 写入失败时立即返回错误，等待中的 `flush` 也会返回错误。
+    pub fn run<S: NorFlash>(&self, db: &mut TSDB<S>) -> Result<(), Error> {
+        let mut batch = Vec::with_capacity(self.config.batch_size);
+        loop {
+            {
+                let mut state = self.state();
+                if !state.requested
+                    && !self.closed.load(Ordering::Acquire)
+                    && self.queue.len() < self.config.batch_size
+                {
+                    state = self
+                        .wake
+                        .wait_timeout(state, self.config.flush_interval)
+                        .unwrap_or_else(|e| e.into_inner())
+                        .0;
+                }
+                state.requested = false;
+            }
+
+            let closed = self.closed.load(Ordering::Acquire);
+            let result = self.drain(db, &mut batch);
+            if let Err(err) = result {
+                self.state().failed = true;
+                self.flushed.notify_all();
+                return Err(err);
+            }
+            if closed && self.queue.tail() == self.queue.head() {
+                return Ok(());
+            }
+        }
+    }
+
+    /// 取出当前所有条目并写入 TSDB，返回写入的条目数。
+    ///
+    /// 通常由 [`IngestBuffer::run`] 调用，也可以在不使用写入线程时手动调用。
+    pub fn drain_into<S: NorFlash>(&self, db: &mut TSDB<S>) -> Result<usize, Error> {
+        let mut batch = Vec::new();
+        self.drain(db, &mut batch)
+    }
+
+    fn drain<S: NorFlash>(
+        &self,
+        db: &mut TSDB<S>,
+        batch: &mut Vec<(i64, Vec<u8>)>,
+    ) -> Result<usize, Error> {
+        let _consumer = self.consumer.lock().unwrap_or_else(|e| e.into_inner());
+        batch.clear();
+        // 只取出此刻已经完成放入的条目，位置之后的条目留给下一轮
+        let end = self.queue.tail();
+        while self.queue.head() != end {
+            match self.queue.pop() {
+                Some(item) => batch.push(item),
+                // 生产者已申请位置但还没写完，稍等即可
+                None => std::thread::yield_now(),
+            }
+        }
+
+        // 不同生产者的条目可能交错，排序后去掉无法写入的条目
+        batch.sort_by_key(|(timestamp, _)| *timestamp);
+        let mut last_time = db.last_time();
+        let before = batch.len();
+        batch.retain(|(timestamp, _)| {
+            let keep = *timestamp > last_time;
+            if keep {
+                last_time = *timestamp;
+            }
+            keep
+        });
+        self.dropped.fetch_add((before - batch.len()) as u64, Ordering::Relaxed);
+
+        let items: Vec<(i64, &[u8])> = batch.iter().map(|(t, d)| (*t, d.as_slice())).collect();
+        db.append_batch(&items)?;
+        self.written.fetch_add(items.len() as u64, Ordering::Relaxed);
+
+        let mut state = self.state();
+        state.done = end;
+        self.flushed.notify_all();
+        Ok(items.len())
+    }
+}
+
+/// 有界的多生产者队列（Dmitry Vyukov 的有界 MPMC 队列），这里只有一个消费者。
+///
+/// 每个槽位带有一个序号：等于入队位置时可以写入，等于入队位置加一时可以读取。
+struct Queue<T> {
+    slots: Box<[Slot<T>]>,
+    mask: usize,
+    // 下一个入队位置
+    tail: AtomicUsize,
+    // 下一个出队位置
+    head: AtomicUsize,
+}
+
+struct Slot<T> {
+    sequence: AtomicUsize,
+    value: UnsafeCell<MaybeUninit<T>>,
+}
+
+unsafe impl<T: Send> Send for Queue<T> {}
+unsafe impl<T: Send> Sync for Queue<T> {}
+
+impl<T> Queue<T> {
+    fn new(capacity: usize) -> Self {
+        let capacity = capacity.next_power_of_two();
+        Self {
+            slots: (0..capacity)
+                .map(|i| Slot {
+                    sequence: AtomicUsize::new(i),
+                    value: UnsafeCell::new(MaybeUninit::uninit()),
+                })
+                .collect(),
+            mask: capacity - 1,
+            tail: AtomicUsize::new(0),
+            head: AtomicUsize::new(0),
+        }
+    }
+
+    fn tail(&self) -> usize {
+        self.tail.load(Ordering::Acquire)
+    }
+
+    fn head(&self) -> usize {
+        self.head.load(Ordering::Acquire)
+    }
+
+    fn len(&self) -> usize {
+        self.tail().wrapping_sub(self.head()).min(self.slots.len())
+    }
+
+    /// 入队，成功时返回入队后的大致长度，队列满时退回条目
+    fn push(&self, value: T) -> Result<usize, T> {
+        let mut pos = self.tail.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.slots[pos & self.mask];
+            let sequence = slot.sequence.load(Ordering::Acquire);
+            match (sequence.wrapping_sub(pos) as isize).signum() {
+                0 => match self.tail.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        unsafe { (*slot.value.get()).write(value) };
+                        slot.sequence.store(pos.wrapping_add(1), Ordering::Release);
+                        return Ok(pos.wrapping_add(1).wrapping_sub(self.head()));
+                    }
+                    Err(current) => pos = current,
+                },
+                // 槽位还没有被消费，队列已满
+                -1 => return Err(value),
+                _ => pos = self.tail.load(Ordering::Relaxed),
+            }
+        }
+    }
+
+    /// 出队，只能由唯一的消费者调用
+    fn pop(&self) -> Option<T> {
+        let pos = self.head.load(Ordering::Relaxed);
+        let slot = &self.slots[pos & self.mask];
+        if slot.sequence.load(Ordering::Acquire) != pos.wrapping_add(1) {
+            return None;
+        }
+        let value = unsafe { (*slot.value.get()).assume_init_read() };
+        slot.sequence
+            .store(pos.wrapping_add(self.slots.len()), Ordering::Release);
+        self.head.store(pos.wrapping_add(1), Ordering::Release);
+        Some(value)
+    }
+}
+
+impl<T> Drop for Queue<T> {
+    fn drop(&mut self) {
+        while self.pop().is_some() {}
+    }
+}
@@ -3,12 +3,22 @@ pub use types::*;
 
 mod reader;
 pub use reader::*;
+mod compact;
+pub use compact::*;
+#[cfg(feature = "std")]
+mod shared;
+#[cfg(feature = "std")]
+pub use shared::*;
+#[cfg(feature = "std")]
+mod ingest;
+#[cfg(feature = "std")]
+pub use ingest::*;
 
 use crate::{
     fdb_blob, fdb_blob_make_write, fdb_blob_read, fdb_db_t, fdb_tsdb, fdb_tsdb_control_read,
     fdb_tsdb_control_write, fdb_tsdb_deinit, fdb_tsdb_init, fdb_tsdb_t, fdb_tsl_append_with_ts,
     fdb_tsl_clean, fdb_tsl_iter, fdb_tsl_iter_by_time, fdb_tsl_iter_reverse, fdb_tsl_query_count,
-    fdb_tsl_set_status, Error, FlashDispatch, RawHandle, FDB_KV_NAME_MAX,
+    fdb_tsl_set_status, Error, FlashDispatch, RawHandle, SyncNorFlash, FDB_KV_NAME_MAX,
     FDB_TSDB_CTRL_GET_LAST_TIME, FDB_TSDB_CTRL_GET_ROLLOVER, FDB_TSDB_CTRL_GET_SEC_SIZE,
     FDB_TSDB_CTRL_SET_MAX_SIZE, FDB_TSDB_CTRL_SET_NOT_FORMAT, FDB_TSDB_CTRL_SET_ROLLOVER,
     FDB_TSDB_CTRL_SET_SEC_SIZE,
@@ -27,6 +37,9 @@ pub struct TSDB<S: NorFlash> {
     user_data: FlashDispatch,
     #[cfg(feature = "log")]
     name_buf: [u8; FDB_KV_NAME_MAX as usize + 1],
+    // 扇区目录（`ts_sec_dir` 特性），每个扇区一项，由 C 库在初始化和切换扇区时维护
+    #[cfg(feature = "ts_sec_dir")]
+    sec_dir: alloc::vec::Vec<crate::tsdb_sec_dir_entry>,
     initialized: bool,
     // 由于 fdb_kvdb 内部引用了 storage 和 name_buf，结构体无法安全地在线程间移动，
     // 因此标记为 !Send 和 !Sync。
@@ -61,13 +74,28 @@ impl TSDB<crate::storage::StdStorage> {
             crate::storage::FileStrategy::Multi,
         )?;
 
-        let mut db = Box::new(TSDB::new(storage));
+        let mut db = Box::new(TSDB::new_with_sync(storage));
         db.set_name(name)?;
         db.init(entry_max)?;
         Ok(db)
     }
 }
 
+impl<S: SyncNorFlash> TSDB<S> {
+    /// 与 [`TSDB::new`] 相同，但会把 C 库的 `sync` 提示传递给存储后端，
+    /// 使存储可以按自身的持久化策略只在关键写入后同步。
+    pub fn new_with_sync(storage: S) -> Self {
+        let mut db = Self::new(storage);
+        db.user_data = FlashDispatch::with_sync::<S>();
+        db
+    }
+
+    /// 将存储后端中尚未持久化的写入同步到介质。
+    pub fn sync(&mut self) -> Result<(), S::Error> {
+        self.storage.sync()
+    }
+}
+
 impl<S: NorFlash> TSDB<S> {
     /// 创建一个未初始化的 KVDB 实例。
     ///
@@ -80,6 +108,8 @@ impl<S: NorFlash> TSDB<S> {
             user_data: FlashDispatch::new::<S>(),
             #[cfg(feature = "log")]
             name_buf: [0; FDB_KV_NAME_MAX as usize + 1],
+            #[cfg(feature = "ts_sec_dir")]
+            sec_dir: alloc::vec::Vec::new(),
             initialized: false,
             _marker: PhantomData,
         }
@@ -172,6 +202,14 @@ impl<S: NorFlash> TSDB<S> {
             // 只有这里获取才不会导致悬空指针
             self.user_data.instance = &mut self.storage as *mut _ as *mut c_void;
 
+            // 按时间查询时先在扇区目录中二分查找起始扇区，不再逐个读取扇区头
+            #[cfg(feature = "ts_sec_dir")]
+            {
+                self.sec_dir = alloc::vec![Default::default(); (max_size / sec_size) as usize];
+                self.inner.sec_dir = self.sec_dir.as_mut_ptr();
+                self.inner.sec_dir_num = self.sec_dir.len();
+            }
+
             #[cfg(feature = "log")]
             let name = self.name_buf.as_ptr() as *const c_char;
             #[cfg(not(feature = "log"))]
@@ -230,6 +268,33 @@ impl<S: NorFlash> TSDB<S> {
         Error::convert(unsafe { fdb_tsl_append_with_ts(self.handle(), &mut blob, timestamp as _) })
     }
 
+    /// 批量追加带时间戳的日志条目
+    ///
+    /// 同一扇区内的条目一次性写入全部索引，再依次写入数据和状态，整批只在最后同步一次
+    /// （切换扇区时 C 库本身也会同步）。
+    ///
+    /// # 参数
+    /// - `items`: `(时间戳, 数据)` 列表，时间戳必须严格递增且大于上次追加的时间戳
+    ///
+    /// # 返回
+    /// - `Ok(())`: 全部追加成功
+    /// - `Err(Error::WriteError)`: 时间戳不递增或数据过长，此时不会写入任何条目
+    /// - `Err(Error)`: 写入失败，失败条目之前的条目已经写入
+    #[cfg(feature = "alloc")]
+    pub fn append_batch(&mut self, items: &[(i64, &[u8])]) -> Result<(), Error> {
+        let mut batch: alloc::vec::Vec<crate::fdb_tsl_batch_item> = items
+            .iter()
+            .map(|(timestamp, data)| crate::fdb_tsl_batch_item {
+                time: *timestamp as _,
+                buf: data.as_ptr() as *const c_void,
+                size: data.len(),
+            })
+            .collect();
+        Error::convert(unsafe {
+            crate::fdb_tsl_append_batch(self.handle(), batch.as_mut_ptr(), batch.len())
+        })
+    }
+
     /// 设置日志条目的状态（逻辑标记）
     ///
     /// # 参数
@@ -257,6 +322,23 @@ impl<S: NorFlash> TSDB<S> {
         unsafe { fdb_tsl_query_count(self.handle(), from as _, to as _, status as _) }
     }
 
+    /// 汇总指定时间范围内特定状态的日志：数量以及最早、最新的条目
+    ///
+    /// 启用 `ts_sec_dir` 特性时，完全落在范围内的扇区直接使用扇区目录中按状态统计的条目数量，
+    /// 只需扫描范围两端的扇区，耗时与扇区数量而不是条目数量成正比；否则遍历范围内的所有条目。
+    ///
+    /// # 参数
+    /// - `from`: 起始时间戳（包含）
+    /// - `to`: 结束时间戳（包含），小于 `from` 时与交换两者的结果相同
+    /// - `status`: 要筛选的状态
+    pub fn summary(&mut self, from: i64, to: i64, status: TSLStatus) -> TSLSummary {
+        let mut summary = crate::fdb_tsl_summary::default();
+        unsafe {
+            crate::fdb_tsl_query_summary(self.handle(), from as _, to as _, status as _, &mut summary)
+        };
+        summary.into()
+    }
+
     /// 迭代所有日志条目（支持正向/反向）
     ///
     /// # 参数
@@ -359,6 +441,55 @@ impl<S: NorFlash> TSDB<S> {
         }
     }
 
+    /// 将指定TSL条目的数据读入调用者提供的缓冲区，不分配内存
+    ///
+    /// 适合在 `tsdb_iter` 等遍历大量记录的循环中复用同一个缓冲区。
+    ///
+    /// # 参数
+    /// - `tsl_obj`: TSL对象（包含状态和长度信息）
+    /// - `buf`: 接收数据的缓冲区，长度不能小于数据长度
+    ///
+    /// # 返回
+    /// - `Ok(Some(len))`: 状态有效时返回数据长度，数据保存在 `buf[..len]` 中
+    /// - `Ok(None)`: 状态为UNUSED/DELETED时返回None
+    /// - `Err(Error::InvalidArgument)`: 缓冲区太小
+    /// - `Err(Error)`: 读取失败（如数据损坏）
+    pub fn get_value_into(&mut self, tsl_obj: &TSLEntry, buf: &mut [u8]) -> Result<Option<usize>, Error> {
+        match tsl_obj.status() {
+            TSLStatus::PRE_WRITE | TSLStatus::Write | TSLStatus::UserStatus1 => {
+                let value_len = tsl_obj.value_len();
+                if buf.len() < value_len {
+                    return Err(Error::InvalidArgument);
+                }
+                let mut blob = fdb_blob_make_by_tsl(&mut buf[..value_len], tsl_obj, 0);
+                if self.fdb_blob_read(&mut blob) != value_len {
+                    return Err(Error::ReadError);
+                }
+                Ok(Some(value_len))
+            }
+            TSLStatus::UNUSED | TSLStatus::Deleted | TSLStatus::UserStatus2 => Ok(None),
+        }
+    }
+
+    /// 获取存储后端的引用，例如读取 [`SimFlash`](crate::SimFlash) 的访问计数。
+    pub fn storage(&self) -> &S {
+        &self.storage
+    }
+
+    /// 获取存储后端的访问统计（`stats` 特性）。
+    ///
+    /// 统计从创建实例开始累计，包括初始化过程中的访问，可用 [`TSDB::reset_stats`] 清零。
+    #[cfg(feature = "stats")]
+    pub fn stats(&self) -> crate::FlashStats {
+        self.user_data.stats.borrow().clone()
+    }
+
+    /// 清零存储后端的访问统计（`stats` 特性）。
+    #[cfg(feature = "stats")]
+    pub fn reset_stats(&mut self) {
+        *self.user_data.stats.borrow_mut() = Default::default();
+    }
+
     /// 打开TSL数据读取器
     ///
     /// # 参数
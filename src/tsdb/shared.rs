@@ -0,0 +1,78 @@
+use super::{TSLEntry, TSLStatus, TSDB};
+use crate::sync::{db_lock_hook, db_unlock_hook, DbGuard, DbLock};
+use crate::{fdb_db_t, fdb_tsdb_control, Error, RawHandle, FDB_TSDB_CTRL_SET_LOCK, FDB_TSDB_CTRL_SET_UNLOCK};
+use core::cell::UnsafeCell;
+use core::ffi::c_void;
+use embedded_storage::nor_flash::NorFlash;
+
+/// 可以在线程间共享的 TSDB（`std` 特性）。
+///
+/// 创建时会通过 `FDB_TSDB_CTRL_SET_LOCK`/`FDB_TSDB_CTRL_SET_UNLOCK` 为 C 库安装锁钩子，
+/// 所有方法都只需要 `&self`。追加、查询与迭代互斥执行，参见 [`SharedKVDB`](crate::SharedKVDB)。
+pub struct SharedTSDB<S: NorFlash> {
+    // db 必须先于 lock 释放：deinit 期间 C 库仍可能调用锁钩子
+    db: UnsafeCell<Box<TSDB<S>>>,
+    lock: Box<DbLock>,
+}
+
+unsafe impl<S: NorFlash + Send> Send for SharedTSDB<S> {}
+unsafe impl<S: NorFlash + Send> Sync for SharedTSDB<S> {}
+
+impl<S: NorFlash> SharedTSDB<S> {
+    /// 将一个 TSDB 实例转换为可共享的实例。
+    pub fn new(mut db: Box<TSDB<S>>) -> Self {
+        let lock = Box::new(DbLock::default());
+        db.user_data.lock = &*lock as *const DbLock as *const c_void;
+        unsafe {
+            // 钩子通过 user_data 找到锁，初始化之前也要能找到，否则加锁与解锁无法配对
+            (*(db.handle() as fdb_db_t)).user_data = &mut db.user_data as *mut _ as *mut c_void;
+            // C 库直接把参数当作函数指针使用
+            fdb_tsdb_control(db.handle(), FDB_TSDB_CTRL_SET_LOCK as i32, db_lock_hook as *mut c_void);
+            fdb_tsdb_control(db.handle(), FDB_TSDB_CTRL_SET_UNLOCK as i32, db_unlock_hook as *mut c_void);
+        }
+        Self {
+            db: UnsafeCell::new(db),
+            lock,
+        }
+    }
+
+    /// 获取数据库的独占访问权，可以调用 [`TSDB`] 的任意方法。
+    ///
+    /// **注意**: 同一线程在持有守卫期间再次调用 `lock`（包括此类型的其他方法）会 panic。
+    pub fn lock(&self) -> DbGuard<'_, TSDB<S>> {
+        self.lock.guard(unsafe { &mut **self.db.get() as *mut TSDB<S> })
+    }
+
+    /// 追加带时间戳的日志条目，参见 [`TSDB::append_with_timestamp`]。
+    pub fn append_with_timestamp(&self, timestamp: i64, data: &[u8]) -> Result<(), Error> {
+        self.lock().append_with_timestamp(timestamp, data)
+    }
+
+    /// 查询指定时间范围内特定状态的日志数量，参见 [`TSDB::count`]。
+    pub fn count(&self, from: i64, to: i64, status: TSLStatus) -> usize {
+        self.lock().count(from, to, status)
+    }
+
+    /// 按时间范围迭代日志条目，参见 [`TSDB::tsdb_iter_by_time`]。
+    ///
+    /// 迭代期间一直持有锁，回调中应通过参数访问数据库。
+    pub fn tsdb_iter_by_time<F: FnMut(&mut TSDB<S>, &mut TSLEntry) -> bool + Send>(
+        &self,
+        from: i64,
+        to: i64,
+        callback: F,
+    ) {
+        self.lock().tsdb_iter_by_time(from, to, callback)
+    }
+
+    /// 卸载锁钩子并取回 TSDB 实例。
+    pub fn into_inner(self) -> Box<TSDB<S>> {
+        let mut db = self.db.into_inner();
+        unsafe {
+            fdb_tsdb_control(db.handle(), FDB_TSDB_CTRL_SET_LOCK as i32, core::ptr::null_mut());
+            fdb_tsdb_control(db.handle(), FDB_TSDB_CTRL_SET_UNLOCK as i32, core::ptr::null_mut());
+        }
+        db.user_data.lock = core::ptr::null();
+        db
+    }
+}
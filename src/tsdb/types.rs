@@ -1,7 +1,7 @@
 use embedded_storage::nor_flash::NorFlash;
 
 use crate::{
-    fdb_blob, fdb_blob__bindgen_ty_1, fdb_tsl, fdb_tsl_status_FDB_TSL_DELETED, fdb_tsl_status_FDB_TSL_PRE_WRITE, fdb_tsl_status_FDB_TSL_UNUSED, fdb_tsl_status_FDB_TSL_USER_STATUS1, fdb_tsl_status_FDB_TSL_USER_STATUS2, fdb_tsl_status_FDB_TSL_WRITE, fdb_tsl_status_t, fdb_tsl_t, RawHandle, TSDB
+    fdb_blob, fdb_blob__bindgen_ty_1, fdb_tsl, fdb_tsl_summary, fdb_tsl_status_FDB_TSL_DELETED, fdb_tsl_status_FDB_TSL_PRE_WRITE, fdb_tsl_status_FDB_TSL_UNUSED, fdb_tsl_status_FDB_TSL_USER_STATUS1, fdb_tsl_status_FDB_TSL_USER_STATUS2, fdb_tsl_status_FDB_TSL_WRITE, fdb_tsl_status_t, fdb_tsl_t, RawHandle, TSDB
 };
 
 #[repr(u32)]
@@ -53,6 +53,28 @@ impl From<fdb_tsl> for TSLEntry {
     }
 }
 
+/// 时间范围内日志条目的汇总结果，参见 [`TSDB::summary`]。
+#[derive(Debug, Clone, Default)]
+pub struct TSLSummary {
+    /// 匹配的条目数量
+    pub count: usize,
+    /// 时间戳最小（最早）的匹配条目
+    pub first: Option<TSLEntry>,
+    /// 时间戳最大（最新）的匹配条目
+    pub last: Option<TSLEntry>,
+}
+
+impl From<fdb_tsl_summary> for TSLSummary {
+    fn from(value: fdb_tsl_summary) -> Self {
+        let found = value.count > 0;
+        Self {
+            count: value.count,
+            first: found.then(|| value.first.into()),
+            last: found.then(|| value.last.into()),
+        }
+    }
+}
+
 // 迭代器闭包数据包装（用于跨语言回调）
 pub(super) struct CallbackData<'a, S: NorFlash, F> {
     pub(super) callback: F,         // 用户提供的迭代回调函数
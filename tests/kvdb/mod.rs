@@ -3,7 +3,11 @@
 
 use core::ffi::CStr;
 use embedded_io::{Read, Seek};
+use embedded_storage::nor_flash::{ErrorType, NorFlash, ReadNorFlash};
+use flashdb_rs::storage::{FileStrategy, StdStorage};
 use flashdb_rs::{define_default_kvs, KVDB};
+use std::cell::Cell;
+use std::rc::Rc;
 use tempfile::TempDir;
 
 // 使用宏定义一组默认键值对，用于测试
@@ -165,3 +169,1137 @@ fn test_kvdb_garbage_collection() -> anyhow::Result<()> {
 
     Ok(())
 }
+
+#[test]
+#[cfg(feature = "kv_index")]
+fn test_kvdb_index() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+
+    {
+        let mut db = KVDB::new_file("index_db", path, 4096, 8 * 4096, None)?;
+
+        // 反复覆盖写入以触发 GC 搬运，索引需要始终指向最新的节点
+        for round in 0..5u8 {
+            for i in 0..60 {
+                db.set(&format!("key{}", i), &[round; 64])?;
+            }
+        }
+        for i in (0..60).step_by(3) {
+            db.delete(&format!("key{}", i))?;
+        }
+        assert_eq!(db.index_len(), 40);
+
+        for i in 0..60 {
+            let value = db.get(&format!("key{}", i))?;
+            if i % 3 == 0 {
+                assert!(value.is_none());
+            } else {
+                assert_eq!(value.unwrap(), [4u8; 64]);
+            }
+        }
+        assert!(db.get("missing")?.is_none());
+    }
+
+    // 重新打开后，索引在加载过程中重建
+    let mut db = KVDB::new_file("index_db", path, 4096, 8 * 4096, None)?;
+    assert_eq!(db.index_len(), 40);
+    assert_eq!(db.get("key1")?.unwrap(), [4u8; 64]);
+    assert!(db.get("key3")?.is_none());
+
+    db.reset()?;
+    assert_eq!(db.index_len(), 0);
+
+    Ok(())
+}
+
+#[test]
+#[cfg(feature = "kv_snapshot")]
+fn test_kvdb_index_snapshot() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let snapshot = temp_dir.path().join("snap_db.fdb.idx");
+
+    {
+        let mut db = KVDB::new_file("snap_db", path, 4096, 8 * 4096, None)?;
+        for i in 0..30 {
+            db.set(&format!("key{}", i), format!("value{}", i).as_bytes())?;
+        }
+        db.delete("key0")?;
+    }
+    // 正常关闭后生成快照
+    assert!(snapshot.exists());
+
+    {
+        // 从快照恢复，恢复后快照被删除
+        let mut db = KVDB::new_file("snap_db", path, 4096, 8 * 4096, None)?;
+        assert!(!snapshot.exists());
+        assert_eq!(db.index_len(), 29);
+        assert!(db.get("key0")?.is_none());
+        assert_eq!(db.get("key29")?.unwrap(), b"value29");
+        db.set("key30", b"value30")?;
+    }
+
+    // 篡改快照后应回退到完整的加载检查
+    let mut data = std::fs::read(&snapshot)?;
+    let last = data.len() - 5;
+    data[last] ^= 0xFF;
+    std::fs::write(&snapshot, &data)?;
+
+    let mut db = KVDB::new_file("snap_db", path, 4096, 8 * 4096, None)?;
+    assert_eq!(db.index_len(), 30);
+    assert_eq!(db.get("key30")?.unwrap(), b"value30");
+    assert_eq!(db.get("key1")?.unwrap(), b"value1");
+
+    Ok(())
+}
+
+#[test]
+#[cfg(feature = "kv_snapshot")]
+fn test_kvdb_index_snapshot_stale() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+
+    {
+        let mut db = KVDB::new_file("stale_db", path, 4096, 8 * 4096, None)?;
+        for i in 0..20 {
+            db.set(&format!("key{}", i), format!("value{}", i).as_bytes())?;
+        }
+        db.set("key1", b"new")?;
+    }
+    assert!(temp_dir.path().join("stale_db.fdb.idx").exists());
+
+    {
+        // 不使用快照的写入者删除 KV，只改变了 KV 的状态，扇区状态不变
+        let storage = StdStorage::new(path, "stale_db", 4096, 8 * 4096, FileStrategy::Multi)?;
+        let mut db = Box::new(KVDB::new(storage));
+        db.init(None)?;
+        db.delete("key5")?;
+    }
+
+    // 快照已过期，应回退到完整的加载检查
+    let mut db = KVDB::new_file("stale_db", path, 4096, 8 * 4096, None)?;
+    assert_eq!(db.index_len(), 19);
+    assert!(db.get("key5")?.is_none());
+    assert_eq!(db.get("key1")?.unwrap(), b"new");
+
+    Ok(())
+}
+
+#[test]
+fn test_kvdb_write_batch() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+
+    {
+        let mut db = KVDB::new_file("batch_db", path, 4096, 8 * 4096, None)?;
+        db.set("a", b"old")?;
+
+        // 多轮覆盖写入，期间会触发 GC
+        for round in 0..20u8 {
+            let value = [round; 100];
+            db.write_batch(&[("a", &value), ("b", &value), ("c", &value[..10])])?;
+        }
+        assert_eq!(db.get("a")?.unwrap(), [19u8; 100]);
+        assert_eq!(db.get("c")?.unwrap(), [19u8; 10]);
+
+        assert!(matches!(
+            db.write_batch(&[("x", b"1"), ("x", b"2")]),
+            Err(flashdb_rs::Error::KvNameExist)
+        ));
+        assert!(matches!(
+            db.write_batch(&[("x", &[0u8; 3000]), ("y", &[0u8; 3000])]),
+            Err(flashdb_rs::Error::SavedFull)
+        ));
+        // 批量写入头的名称是保留的，所有写入方式都不能使用
+        assert!(matches!(
+            db.write_batch(&[("x", b"1"), ("__batch__", b"2")]),
+            Err(flashdb_rs::Error::KvNameError)
+        ));
+        assert!(matches!(db.set("__batch__", b"1"), Err(flashdb_rs::Error::KvNameError)));
+        assert!(matches!(db.get_writer("__batch__", 1), Err(flashdb_rs::Error::KvNameError)));
+        assert!(db.get("x")?.is_none());
+        assert_eq!(db.iter().count(), 3);
+    }
+
+    let mut db = KVDB::new_file("batch_db", path, 4096, 8 * 4096, None)?;
+    assert_eq!(db.get("b")?.unwrap(), [19u8; 100]);
+    assert_eq!(db.iter().count(), 3);
+
+    Ok(())
+}
+
+/// 模拟掉电：写入次数耗尽后，之后的写入和擦除都被静默丢弃
+struct PowerCut {
+    inner: StdStorage,
+    budget: Rc<Cell<Option<usize>>>,
+}
+
+impl PowerCut {
+    fn alive(&self) -> bool {
+        match self.budget.get() {
+            Some(0) => false,
+            Some(n) => {
+                self.budget.set(Some(n - 1));
+                true
+            }
+            None => true,
+        }
+    }
+}
+
+impl ErrorType for PowerCut {
+    type Error = flashdb_rs::Error;
+}
+
+impl ReadNorFlash for PowerCut {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        self.inner.read(offset, bytes)
+    }
+
+    fn capacity(&self) -> usize {
+        self.inner.capacity()
+    }
+}
+
+impl NorFlash for PowerCut {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = 4096;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        if self.alive() {
+            self.inner.erase(from, to)?;
+        }
+        Ok(())
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        if self.alive() {
+            self.inner.write(offset, bytes)?;
+        }
+        Ok(())
+    }
+}
+
+#[test]
+fn test_kvdb_write_batch_power_cut() -> anyhow::Result<()> {
+    let open = |path: &std::path::Path, budget: &Rc<Cell<Option<usize>>>| -> anyhow::Result<_> {
+        let inner = StdStorage::new(path, "cut_db", 4096, 8 * 4096, FileStrategy::Multi)?;
+        let mut db = Box::new(KVDB::new(PowerCut {
+            inner,
+            budget: budget.clone(),
+        }));
+        db.init(None)?;
+        Ok(db)
+    };
+
+    // 在批量写入的每一次写操作之后掉电，重启后只能看到全部旧值或全部新值
+    let mut cut = 0;
+    loop {
+        let temp_dir = TempDir::new()?;
+        let budget = Rc::new(Cell::new(None));
+        let completed = {
+            let mut db = open(temp_dir.path(), &budget)?;
+            db.set("a", b"old")?;
+            db.set("b", b"old")?;
+            budget.set(Some(cut));
+            db.write_batch(&[("a", b"new"), ("b", b"new"), ("c", b"new")])?;
+            budget.get() != Some(0)
+        };
+
+        budget.set(None);
+        let mut db = open(temp_dir.path(), &budget)?;
+        let a = db.get("a")?.unwrap();
+        let b = db.get("b")?.unwrap();
+        let c = db.get("c")?;
+        if a == b"new" {
+            assert_eq!(b, b"new", "cut after {} writes", cut);
+            assert_eq!(c.as_deref(), Some(&b"new"[..]), "cut after {} writes", cut);
+        } else {
+            assert_eq!(b, b"old", "cut after {} writes", cut);
+            assert!(c.is_none(), "cut after {} writes", cut);
+        }
+        // 旧节点必须已被删除，不能出现重复的键
+        assert_eq!(db.iter().count(), 2 + c.is_some() as usize);
+
+        if completed {
+            break;
+        }
+        cut += 1;
+    }
+    assert!(cut > 3);
+
+    Ok(())
+}
+
+/// 模拟写入失败：第 N 次写入返回错误，之后的写入恢复正常
+struct FailOnce {
+    inner: StdStorage,
+    countdown: Rc<Cell<Option<usize>>>,
+}
+
+impl ErrorType for FailOnce {
+    type Error = flashdb_rs::Error;
+}
+
+impl ReadNorFlash for FailOnce {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        self.inner.read(offset, bytes)
+    }
+
+    fn capacity(&self) -> usize {
+        self.inner.capacity()
+    }
+}
+
+impl NorFlash for FailOnce {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = 4096;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        self.inner.erase(from, to)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        match self.countdown.get() {
+            Some(0) => {
+                self.countdown.set(None);
+                Err(flashdb_rs::Error::WriteError)
+            }
+            Some(n) => {
+                self.countdown.set(Some(n - 1));
+                self.inner.write(offset, bytes)
+            }
+            None => self.inner.write(offset, bytes),
+        }
+    }
+}
+
+#[test]
+fn test_kvdb_write_batch_write_error() -> anyhow::Result<()> {
+    let open = |path: &std::path::Path, countdown: &Rc<Cell<Option<usize>>>| -> anyhow::Result<_> {
+        let inner = StdStorage::new(path, "fail_db", 4096, 8 * 4096, FileStrategy::Multi)?;
+        let mut db = Box::new(KVDB::new(FailOnce {
+            inner,
+            countdown: countdown.clone(),
+        }));
+        db.init(None)?;
+        Ok(db)
+    };
+    let check = |db: &mut KVDB<FailOnce>, fail: usize| -> anyhow::Result<()> {
+        let a = db.get("a")?.unwrap();
+        let b = db.get("b")?.unwrap();
+        let c = db.get("c")?;
+        if a == b"new" {
+            assert_eq!(b, b"new", "fail at write {}", fail);
+            assert_eq!(c.as_deref(), Some(&b"new"[..]), "fail at write {}", fail);
+        } else {
+            assert_eq!(b, b"old", "fail at write {}", fail);
+            assert!(c.is_none(), "fail at write {}", fail);
+        }
+        for i in 0..10 {
+            assert_eq!(db.get(&format!("f{}", i))?.unwrap(), [39u8; 100], "fail at write {}", fail);
+        }
+        // 不能出现重复的键，批量写入的头部也不能残留
+        assert_eq!(db.iter().count(), 12 + c.is_some() as usize, "fail at write {}", fail);
+        Ok(())
+    };
+
+    // 让批量写入的每一次写操作依次失败，之后继续写入触发 GC，再重新打开
+    let mut fail = 0;
+    loop {
+        let temp_dir = TempDir::new()?;
+        let countdown = Rc::new(Cell::new(None));
+        let failed = {
+            let mut db = open(temp_dir.path(), &countdown)?;
+            db.set("a", b"old")?;
+            db.set("b", b"old")?;
+            countdown.set(Some(fail));
+            let result = db.write_batch(&[("a", b"new"), ("b", b"new"), ("c", b"new")]);
+            let failed = countdown.get().is_none();
+            assert_eq!(result.is_err(), failed, "fail at write {}", fail);
+            countdown.set(None);
+            for round in 0..40u8 {
+                for i in 0..10 {
+                    db.set(&format!("f{}", i), &[round; 100])?;
+                }
+            }
+            check(&mut db, fail)?;
+            failed
+        };
+
+        let mut db = open(temp_dir.path(), &countdown)?;
+        check(&mut db, fail)?;
+
+        if !failed {
+            break;
+        }
+        fail += 1;
+    }
+    assert!(fail > 3);
+
+    Ok(())
+}
+
+#[test]
+fn test_kvdb_incremental_gc() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+
+    let value = vec![0x5Au8; 500];
+    let mut last = 0;
+    {
+        let mut db = KVDB::new_file("inc_gc_db", path, 4096, 6 * 4096, None)?;
+        db.set_gc_budget(1);
+        assert_eq!(db.gc_budget(), 1);
+        assert!(!db.gc_pressure().is_behind());
+
+        // 写满一个扇区的冷数据并删除其中一个，回收该扇区需要多次增量 GC 才能完成
+        for i in 0..7 {
+            db.set(&format!("cold_{}", i), &value)?;
+        }
+        db.delete("cold_0")?;
+        // 反复覆盖热数据，每次写入最多只搬移一个 KV，直到冷数据扇区正在被回收
+        for round in 1..100u8 {
+            let mut val = value.clone();
+            val[0] = round;
+            db.set("hot", &val)?;
+            last = round;
+            if db.gc_pressure().in_progress {
+                break;
+            }
+        }
+        assert!(db.gc_pressure().in_progress);
+        assert_eq!(db.get("hot")?.unwrap()[0], last);
+        for i in 1..7 {
+            assert_eq!(db.get(&format!("cold_{}", i))?.unwrap(), value);
+        }
+    }
+
+    // 在回收中途重新打开，数据完整，未完成的回收可以继续
+    let mut db = KVDB::new_file("inc_gc_db", path, 4096, 6 * 4096, None)?;
+    assert_eq!(db.get("hot")?.unwrap()[0], last);
+    for i in 1..7 {
+        assert_eq!(db.get(&format!("cold_{}", i))?.unwrap(), value);
+    }
+    assert_eq!(db.iter().count(), 7);
+
+    // 主动回收，直到无需继续
+    assert!(db.gc_pressure().in_progress);
+    let mut steps = 0;
+    while db.gc_step(1)? {
+        steps += 1;
+        assert!(steps < 100);
+    }
+    assert!(!db.gc_pressure().in_progress);
+    assert!(!db.gc_pressure().is_behind());
+    assert!(db.gc_step(0).is_err());
+    assert_eq!(db.iter().count(), 7);
+
+    Ok(())
+}
+
+#[test]
+fn test_kvdb_gc_policy() -> anyhow::Result<()> {
+    use flashdb_rs::GcPolicy;
+
+    // 返回整个负载期间 Flash 的写入与擦除次数
+    let run = |policy: GcPolicy| -> anyhow::Result<usize> {
+        let temp_dir = TempDir::new()?;
+        let inner = StdStorage::new(temp_dir.path(), "policy_db", 4096, 8 * 4096, FileStrategy::Multi)?;
+        let ops = Rc::new(Cell::new(None));
+        let mut db = Box::new(KVDB::new(PowerCut {
+            inner,
+            budget: ops.clone(),
+        }));
+        db.init(None)?;
+        db.set_gc_policy(policy);
+        assert_eq!(db.gc_policy(), policy);
+
+        let value = vec![0xA5u8; 300];
+        for i in 0..24 {
+            db.set(&format!("cold_{}", i), &value)?;
+        }
+        ops.set(Some(usize::MAX));
+        // 少量热点键频繁更新，冷数据偶尔更新
+        for round in 0..400usize {
+            let mut val = value.clone();
+            val[0] = round as u8;
+            db.set(&format!("hot_{}", round % 3), &val)?;
+            if round % 40 == 0 {
+                db.set(&format!("cold_{}", round / 40), &val)?;
+            }
+        }
+        let ops = usize::MAX - ops.get().unwrap();
+
+        for i in 0..3 {
+            let last = (0..400usize).filter(|round| round % 3 == i).last().unwrap();
+            assert_eq!(db.get(&format!("hot_{}", i))?.unwrap()[0], last as u8);
+        }
+        for i in 0..24 {
+            let expect = if i < 10 { (i * 40) as u8 } else { 0xA5 };
+            assert_eq!(db.get(&format!("cold_{}", i))?.unwrap()[0], expect);
+        }
+        assert_eq!(db.iter().count(), 27);
+        Ok(ops)
+    };
+
+    let sequential = run(GcPolicy::Sequential)?;
+    let greedy = run(GcPolicy::Greedy)?;
+    let cost_benefit = run(GcPolicy::CostBenefit)?;
+    assert!(greedy < sequential);
+    assert!(cost_benefit < sequential);
+
+    Ok(())
+}
+
+#[test]
+fn test_kvdb_get_into() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("into_db", path, 4096, 8 * 4096, None)?;
+
+    db.set("a", b"alpha")?;
+    db.set("b", &[0x42; 200])?;
+    db.set("c", b"")?;
+
+    let mut buf = [0u8; 64];
+    let len = db.get_into("a", &mut buf)?;
+    assert_eq!(&buf[..len], b"alpha");
+    assert_eq!(db.get_into("c", &mut buf)?, 0);
+    assert!(matches!(db.get_into("missing", &mut buf), Err(flashdb_rs::Error::KeyNotFound)));
+    // 缓冲区太小
+    assert!(matches!(db.get_into("b", &mut buf), Err(flashdb_rs::Error::InvalidArgument)));
+    assert_eq!(db.get_entry("b")?.unwrap().value_len(), 200);
+
+    // 迭代器把所有值读入同一个缓冲区，放不下的值单独报错
+    let mut values = Vec::new();
+    let mut too_big = 0;
+    let mut iter = db.iter_values(&mut buf);
+    while let Some(item) = iter.next() {
+        match item {
+            Ok((entry, value)) => values.push((entry.name().unwrap().to_string(), value.to_vec())),
+            Err(_) => too_big += 1,
+        }
+    }
+    values.sort();
+    assert_eq!(values, vec![("a".to_string(), b"alpha".to_vec()), ("c".to_string(), vec![])]);
+    assert_eq!(too_big, 1);
+
+    Ok(())
+}
+
+#[test]
+#[cfg(feature = "kv_index")]
+fn test_kvdb_parallel_readers() -> anyhow::Result<()> {
+    use std::sync::atomic::{AtomicBool, Ordering};
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("parallel_db", path, 4096, 8 * 4096, None)?;
+    for i in 0..20 {
+        db.set(&format!("key{}", i), &[0; 64])?;
+    }
+
+    let open = || StdStorage::new(path, "parallel_db", 4096, 8 * 4096, FileStrategy::Multi);
+    let readers = (0..4)
+        .map(|_| Ok(db.reader(open()?)?))
+        .collect::<anyhow::Result<Vec<_>>>()?;
+    // 只读句柄不能写入，容量不一致的存储会被拒绝
+    let small = StdStorage::new(path, "parallel_db", 4096, 4 * 4096, FileStrategy::Multi)?;
+    assert!(matches!(db.reader(small), Err(flashdb_rs::Error::InvalidArgument)));
+
+    let done = AtomicBool::new(false);
+    let generation = db.generation();
+    std::thread::scope(|scope| -> anyhow::Result<()> {
+        let handles: Vec<_> = readers
+            .into_iter()
+            .map(|mut reader| {
+                let done = &done;
+                scope.spawn(move || -> Result<usize, flashdb_rs::Error> {
+                    let mut last = [0u8; 20];
+                    let mut buf = [0u8; 64];
+                    let mut reads = 0;
+                    while !done.load(Ordering::Relaxed) {
+                        for i in 0..20 {
+                            // 值总是完整的，同一个句柄读到的版本不会倒退
+                            let len = reader.get_into(&format!("key{}", i), &mut buf)?;
+                            assert_eq!(len, 64);
+                            assert!(buf.iter().all(|&b| b == buf[0]));
+                            assert!(buf[0] >= last[i]);
+                            last[i] = buf[0];
+                            reads += 1;
+                        }
+                        assert!(reader.get("missing")?.is_none());
+                    }
+                    Ok(reads)
+                })
+            })
+            .collect();
+
+        // 反复覆盖写入以触发 GC 搬运
+        for round in 1..=100u8 {
+            for i in 0..20 {
+                db.set(&format!("key{}", i), &[round; 64])?;
+            }
+        }
+        done.store(true, Ordering::Relaxed);
+        for handle in handles {
+            assert!(handle.join().unwrap()? > 0);
+        }
+        Ok(())
+    })?;
+    assert!(db.generation() > generation);
+
+    let mut reader = db.reader(open()?)?;
+    assert_eq!(reader.get("key7")?.unwrap(), [100u8; 64]);
+    assert_eq!(reader.get_entry("key7")?.unwrap().value_len(), 64);
+    Ok(())
+}
+
+#[test]
+fn test_shared_kvdb() -> anyhow::Result<()> {
+    use flashdb_rs::SharedKVDB;
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let db = SharedKVDB::new(KVDB::new_file("shared_db", path, 4096, 8 * 4096, None)?);
+
+    std::thread::scope(|scope| {
+        for thread in 0..4 {
+            let db = &db;
+            scope.spawn(move || {
+                // 反复覆盖写入以触发 GC，其他线程同时读写各自的键
+                for round in 0..50u8 {
+                    for i in 0..5 {
+                        let key = format!("t{}k{}", thread, i);
+                        db.set(&key, &[round; 32]).unwrap();
+                        assert_eq!(db.get(&key).unwrap().unwrap(), [round; 32]);
+                    }
+                }
+                db.delete(&format!("t{}k0", thread)).unwrap();
+            });
+        }
+    });
+
+    let mut buf = [0u8; 32];
+    assert_eq!(db.get_into("t2k3", &mut buf)?, 32);
+    assert_eq!(buf, [49u8; 32]);
+    assert!(db.get("t1k0")?.is_none());
+    {
+        let mut guard = db.lock();
+        assert_eq!(guard.get("t3k4")?.unwrap(), [49u8; 32]);
+    }
+
+    // 卸载钩子后仍然可以正常使用
+    let mut db = db.into_inner();
+    db.set("after", b"1")?;
+    assert_eq!(db.get("t0k1")?.unwrap(), [49u8; 32]);
+    Ok(())
+}
+
+#[test]
+#[cfg(feature = "kv_compress")]
+fn test_kvdb_compression() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("compress_db", path, 4096, 4 * 4096, None)?;
+    assert_eq!(db.compress_threshold(), 0);
+    db.set_compress_threshold(128);
+
+    // 重复较多的配置数据
+    let pattern = b"{\"sensor\":1,\"gain\":0.5,\"offset\":-12}";
+    let config: Vec<u8> = (0..3000).map(|i| pattern[i % pattern.len()]).collect();
+    // 不可压缩的数据
+    let noise_of = |len: u32, seed: u32| -> Vec<u8> {
+        (0..len)
+            .map(|i| {
+                let mut x = i ^ seed << 16;
+                x = (x ^ x >> 16).wrapping_mul(0x7feb352d);
+                x = (x ^ x >> 15).wrapping_mul(0x846ca68b);
+                (x ^ x >> 16) as u8
+            })
+            .collect()
+    };
+    let noise = noise_of(600, 0);
+    db.set("config", &config)?;
+    db.set("noise", &noise)?;
+    db.set("small", &[7; 64])?;
+
+    let entry = db.get_entry("config")?.unwrap();
+    assert!(entry.is_compressed());
+    assert!(entry.value_len() < config.len() / 4);
+    // 压缩后不会变短的值和短于阈值的值原样保存
+    assert!(!db.get_entry("noise")?.unwrap().is_compressed());
+    assert!(!db.get_entry("small")?.unwrap().is_compressed());
+
+    // 所有读取路径都透明解压
+    assert_eq!(db.get("config")?.unwrap(), config);
+    let mut buf = vec![0u8; 4096];
+    let len = db.get_into("config", &mut buf)?;
+    assert_eq!(&buf[..len], &config[..]);
+    assert!(matches!(db.get_into("config", &mut buf[..100]), Err(flashdb_rs::Error::InvalidArgument)));
+    let mut reader = db.get_reader("config")?;
+    reader.seek(embedded_io::SeekFrom::Start(2990))?;
+    let mut tail = [0u8; 32];
+    let read = reader.read(&mut tail)?;
+    assert_eq!(&tail[..read], &config[2990..]);
+
+    // 批量写入同样压缩，GC 搬移后压缩标志保持不变
+    let batch_value = vec![0x5a; 1500];
+    db.write_batch(&[("batch", &batch_value), ("config", &config[..1000])])?;
+    assert!(db.get_entry("batch")?.unwrap().is_compressed());
+    for round in 1..=40 {
+        db.set("hot", &noise_of(1500, round))?;
+    }
+    assert!(!db.get_entry("hot")?.unwrap().is_compressed());
+    assert_eq!(db.get("config")?.unwrap(), &config[..1000]);
+    assert_eq!(db.get("batch")?.unwrap(), batch_value);
+
+    // 修改阈值不影响已写入的值
+    db.set_compress_threshold(0);
+    db.set("raw", &batch_value)?;
+    assert!(!db.get_entry("raw")?.unwrap().is_compressed());
+    drop(db);
+
+    let mut db = KVDB::new_file("compress_db", path, 4096, 4 * 4096, None)?;
+    assert_eq!(db.get("batch")?.unwrap(), batch_value);
+    assert_eq!(db.get("raw")?.unwrap(), batch_value);
+    assert_eq!(db.get("hot")?.unwrap(), noise_of(1500, 40));
+    assert_eq!(db.get("noise")?.unwrap(), noise);
+    Ok(())
+}
+
+#[test]
+fn test_kvdb_writer() -> anyhow::Result<()> {
+    use embedded_io::Write;
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("writer_db", path, 4096, 8 * 4096, None)?;
+    db.set("model", b"old")?;
+
+    // 分块写入，提交之前读到的仍是旧值
+    let value: Vec<u8> = (0..2000u32).map(|i| (i * 7 % 251) as u8).collect();
+    let mut writer = db.get_writer("model", value.len())?;
+    for chunk in value.chunks(7) {
+        writer.write_all(chunk)?;
+    }
+    assert_eq!(writer.remaining(), 0);
+    assert!(matches!(writer.write(b"x"), Err(flashdb_rs::Error::InvalidArgument)));
+    writer.finish()?;
+    assert_eq!(db.get("model")?.unwrap(), value);
+
+    // 写入不足时不能提交，丢弃的写入器不影响旧值
+    let mut writer = db.get_writer("model", 100)?;
+    writer.write_all(&[1; 50])?;
+    assert!(matches!(writer.finish(), Err(flashdb_rs::Error::InvalidArgument)));
+    let mut writer = db.get_writer("model", 100)?;
+    writer.write_all(&[2; 60])?;
+    drop(writer);
+    assert_eq!(db.get("model")?.unwrap(), value);
+    assert!(matches!(db.get_writer("huge", 8192), Err(flashdb_rs::Error::SavedFull)));
+
+    // 反复写入触发 GC，放弃写入留下的空间被回收
+    for round in 0..40u8 {
+        let mut writer = db.get_writer(&format!("key{}", round % 3), 1000)?;
+        writer.write_all(&[round; 1000])?;
+        writer.finish()?;
+    }
+    assert_eq!(db.get("key1")?.unwrap(), [37u8; 1000]);
+    assert_eq!(db.get("model")?.unwrap(), value);
+
+    // 写入中途掉电：重启后旧值仍然有效
+    let mut writer = db.get_writer("model", 500)?;
+    writer.write_all(&[3; 500])?;
+    core::mem::forget(writer);
+    drop(db);
+    let mut db = KVDB::new_file("writer_db", path, 4096, 8 * 4096, None)?;
+    assert_eq!(db.get("model")?.unwrap(), value);
+    assert_eq!(db.get("key0")?.unwrap(), [39u8; 1000]);
+    Ok(())
+}
+
+/// 统计读取次数的存储包装
+struct ReadCounter {
+    inner: StdStorage,
+    reads: Rc<Cell<usize>>,
+}
+
+impl ErrorType for ReadCounter {
+    type Error = flashdb_rs::Error;
+}
+
+impl ReadNorFlash for ReadCounter {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        self.reads.set(self.reads.get() + 1);
+        self.inner.read(offset, bytes)
+    }
+
+    fn capacity(&self) -> usize {
+        self.inner.capacity()
+    }
+}
+
+impl NorFlash for ReadCounter {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = 4096;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        self.inner.erase(from, to)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.inner.write(offset, bytes)
+    }
+}
+
+#[test]
+fn test_kvdb_iter_prefetch() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let storage = StdStorage::new(path, "prefetch_db", 4096, 32 * 4096, FileStrategy::Multi)?;
+    let reads = Rc::new(Cell::new(0));
+    let mut db = Box::new(KVDB::new(ReadCounter {
+        inner: storage,
+        reads: reads.clone(),
+    }));
+    db.init(None)?;
+    for i in 0..200u32 {
+        db.set(&format!("key{}", i), &[i as u8; 100])?;
+    }
+    // 更新一部分键，留下需要跳过的已删除 KV
+    for i in 0..200u32 {
+        if i % 3 == 0 {
+            db.set(&format!("key{}", i), &[i as u8 + 1; 50])?;
+        }
+    }
+
+    let collect = |iter: &mut flashdb_rs::KVDBValueIter<'_, '_, ReadCounter>| -> anyhow::Result<Vec<(String, Vec<u8>)>> {
+        let mut items = Vec::new();
+        while let Some(item) = iter.next() {
+            let (entry, value) = item?;
+            items.push((entry.name().unwrap().to_string(), value.to_vec()));
+        }
+        Ok(items)
+    };
+
+    let mut buf = [0u8; 128];
+    reads.set(0);
+    let plain = collect(&mut db.iter_values(&mut buf))?;
+    let plain_reads = reads.get();
+
+    reads.set(0);
+    let prefetched = collect(&mut db.iter_values(&mut buf).prefetch(2))?;
+    let prefetch_reads = reads.get();
+
+    assert_eq!(plain.len(), 200);
+    assert_eq!(prefetched, plain);
+    assert!(prefetched.contains(&("key3".to_string(), vec![4u8; 50])));
+    // 每个扇区（包括空扇区）最多只需要一次整块读取
+    assert!(prefetch_reads <= 32, "prefetch reads: {}", prefetch_reads);
+    assert!(prefetch_reads * 10 < plain_reads, "{} vs {}", prefetch_reads, plain_reads);
+
+    // 迭代结束后预读窗口被移除，写入后读到的是新数据
+    db.set("key1", b"new")?;
+    assert_eq!(db.get("key1")?.unwrap(), b"new");
+    let count = db.iter().prefetch(1).filter(|entry| entry.name().unwrap() == "key1").count();
+    assert_eq!(count, 1);
+    Ok(())
+}
+
+#[test]
+fn test_kvdb_scan_prefix() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("scan_db", path, 4096, 16 * 4096, None)?;
+    for dev in 0..5 {
+        for field in ["name", "temp", "ver"] {
+            db.set(&format!("dev/{}/{}", dev, field), format!("{}-{}", dev, field).as_bytes())?;
+        }
+    }
+    db.set("dev", b"root")?;
+    db.set("dev/1", b"not a field")?;
+    db.set("devx/1/name", b"other")?;
+    db.set("dev/2/temp", b"updated")?;
+    db.delete("dev/2/ver")?;
+
+    let names = |entries: &[flashdb_rs::KVEntry]| -> Vec<String> {
+        entries.iter().map(|entry| entry.name().unwrap().to_string()).collect()
+    };
+
+    let entries = db.scan_prefix("dev/2/")?;
+    assert_eq!(names(&entries), ["dev/2/name", "dev/2/temp"]);
+    let mut buf = [0u8; 16];
+    let len = db.read_value_into(&entries[1], &mut buf)?;
+    assert_eq!(&buf[..len], b"updated");
+
+    assert_eq!(db.scan_prefix("dev/1")?.len(), 4);
+    assert_eq!(db.scan_prefix("dev/")?.len(), 15);
+    assert_eq!(db.scan_prefix("dev")?.len(), 17);
+    assert!(db.scan_prefix("dev/9/")?.is_empty());
+    assert_eq!(db.scan_prefix("")?.len(), db.iter().count());
+
+    let entries = db.scan_range("dev/1/", "dev/3/")?;
+    assert_eq!(
+        names(&entries),
+        ["dev/1/name", "dev/1/temp", "dev/1/ver", "dev/2/name", "dev/2/temp"]
+    );
+    assert!(db.scan_range("dev/3/", "dev/1/")?.is_empty());
+    Ok(())
+}
+
+#[cfg(feature = "kv_index")]
+#[test]
+fn test_kvdb_scan_prefix_stale_index() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("stale_db", path, 4096, 16 * 4096, None)?;
+    for dev in 0..5 {
+        for field in ["name", "temp", "ver"] {
+            db.set(&format!("dev/{}/{}", dev, field), format!("{}-{}", dev, field).as_bytes())?;
+        }
+    }
+    assert_eq!(db.scan_prefix("dev/3/")?.len(), 3);
+
+    // 绕过数据库直接损坏一个 KV 的名称，使索引中的地址失效
+    let mut corrupted = false;
+    for entry in std::fs::read_dir(path)? {
+        let file = entry?.path();
+        let mut data = std::fs::read(&file)?;
+        if let Some(pos) = data.windows(10).position(|w| w == b"dev/3/temp") {
+            data[pos..pos + 10].fill(0);
+            std::fs::write(&file, &data)?;
+            corrupted = true;
+        }
+    }
+    assert!(corrupted);
+
+    let names: Vec<String> = db
+        .scan_prefix("dev/3/")?
+        .iter()
+        .map(|entry| entry.name().unwrap().to_string())
+        .collect();
+    assert_eq!(names, ["dev/3/name", "dev/3/ver"]);
+    assert_eq!(db.scan_prefix("dev/")?.len(), 14);
+    assert!(db.get("dev/3/temp")?.is_none());
+    Ok(())
+}
+
+#[test]
+#[cfg(feature = "kv_index")]
+fn test_kvdb_scan_prefix_relocate() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("relocate_db", path, 4096, 16 * 4096, None)?;
+    for dev in 0..5 {
+        for field in ["name", "temp", "ver"] {
+            db.set(&format!("dev/{}/{}", dev, field), format!("{}-{}", dev, field).as_bytes())?;
+        }
+    }
+    db.set("dev/3/temp", b"new")?;
+
+    // 绕过数据库损坏索引指向的新节点，并把旧节点的状态改回 WRITE，使索引中的地址过期而键仍然存在
+    let file = temp_dir.path().join("relocate_db.fdb.0");
+    let mut data = std::fs::read(&file)?;
+    let found: Vec<usize> = data
+        .windows(10)
+        .enumerate()
+        .filter(|(_, w)| *w == b"dev/3/temp")
+        .map(|(pos, _)| pos)
+        .collect();
+    assert_eq!(found.len(), 2);
+    // 名称之前是 24 字节的 KV 头，状态表在最前，魔数在偏移 4 处
+    let old_hdr = found[0] - 24;
+    assert_eq!(&data[old_hdr + 4..old_hdr + 8], b"KV00");
+    data[old_hdr] = 0x3F;
+    data[found[1]..found[1] + 10].fill(0);
+    std::fs::write(&file, &data)?;
+
+    let names: Vec<String> = db
+        .scan_prefix("dev/3/")?
+        .iter()
+        .map(|entry| entry.name().unwrap().to_string())
+        .collect();
+    assert_eq!(names, ["dev/3/name", "dev/3/temp", "dev/3/ver"]);
+    // 扫描时已修正索引，之后的查找仍能找到该键
+    assert_eq!(db.get("dev/3/temp")?.unwrap(), b"3-temp");
+    assert_eq!(db.index_len(), 15);
+    Ok(())
+}
+
+#[cfg(feature = "kv_parallel_load")]
+#[test]
+fn test_kvdb_parallel_load() -> anyhow::Result<()> {
+    use embedded_io::Write;
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let open = || StdStorage::new(path, "parallel_db", 4096, 32 * 4096, FileStrategy::Multi);
+    {
+        let mut db = KVDB::new_file("parallel_db", path, 4096, 32 * 4096, None)?;
+        for i in 0..300u32 {
+            db.set(&format!("key{}", i), &[(i % 251) as u8; 200])?;
+        }
+        for i in (0..300u32).step_by(7) {
+            db.set(&format!("key{}", i), &[0xAA; 64])?;
+        }
+        // 写入中途掉电，留下一个未完成的 KV
+        let mut writer = db.get_writer("key1", 300)?;
+        writer.write_all(&[3; 300])?;
+        core::mem::forget(writer);
+    }
+
+    let expect = |i: u32| if i % 7 == 0 { vec![0xAA; 64] } else { vec![(i % 251) as u8; 200] };
+    let reads = Rc::new(Cell::new(0));
+    let load = |parallel: bool| -> anyhow::Result<usize> {
+        reads.set(0);
+        let mut db = Box::new(KVDB::new(ReadCounter {
+            inner: open()?,
+            reads: reads.clone(),
+        }));
+        if parallel {
+            db.init_parallel(None, 4, || open().map_err(Into::into))?;
+        } else {
+            db.init(None)?;
+        }
+        let load_reads = reads.get();
+        for i in 0..300u32 {
+            assert_eq!(db.get(&format!("key{}", i))?.unwrap(), expect(i), "key{}", i);
+        }
+        assert_eq!(db.iter().count(), 300);
+        Ok(load_reads)
+    };
+
+    // 第一次加载完成掉电恢复，之后串行与并行加载的结果一致，并行加载时不再读取 KV 的数据
+    load(true)?;
+    let serial_reads = load(false)?;
+    let parallel_reads = load(true)?;
+    assert!(parallel_reads * 2 < serial_reads, "{} vs {}", parallel_reads, serial_reads);
+
+    let mut db = KVDB::new_file_parallel("parallel_db", path, 4096, 32 * 4096, None, 0)?;
+    db.set("key1", b"after")?;
+    assert_eq!(db.get("key1")?.unwrap(), b"after");
+    assert_eq!(db.get("key299")?.unwrap(), expect(299));
+    Ok(())
+}
+
+#[test]
+fn test_sharded_kvdb() -> anyhow::Result<()> {
+    use flashdb_rs::ShardedKVDB;
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    {
+        let db = ShardedKVDB::new_file("sharded_db", path, 4, 4096, 8 * 4096)?;
+        assert_eq!(db.shard_count(), 4);
+        std::thread::scope(|scope| {
+            for thread in 0..4 {
+                let db = &db;
+                scope.spawn(move || {
+                    for round in 0..20u8 {
+                        for i in 0..25 {
+                            db.set(&format!("dev/{}/{}", thread, i), &[round; 48]).unwrap();
+                        }
+                    }
+                });
+            }
+        });
+        db.delete("dev/0/0")?;
+        while db.gc_step(8)? {}
+
+        // 键分布到多个分片，每个分片只包含路由到它的键
+        let mut counts = [0usize; 4];
+        for shard in 0..4 {
+            for entry in db.shard(shard).lock().iter() {
+                let name = entry.name().unwrap().to_string();
+                assert_eq!(db.shard_of(&name), shard);
+                counts[shard] += 1;
+            }
+        }
+        assert!(counts.iter().all(|&count| count > 0), "{:?}", counts);
+        assert_eq!(counts.iter().sum::<usize>(), 99);
+        assert_eq!(db.iter().count(), 99);
+    }
+
+    // 重新打开后键仍然路由到原来的分片
+    let db = ShardedKVDB::new_file("sharded_db", path, 4, 4096, 8 * 4096)?;
+    assert!(db.get("dev/0/0")?.is_none());
+    assert_eq!(db.get("dev/3/24")?.unwrap(), [19u8; 48]);
+    let mut buf = [0u8; 48];
+    assert_eq!(db.get_into("dev/1/7", &mut buf)?, 48);
+    assert_eq!(buf, [19u8; 48]);
+    let entries = db.scan_prefix("dev/2/")?;
+    assert_eq!(entries.len(), 25);
+    assert!(entries.windows(2).all(|w| w[0].name_bytes() < w[1].name_bytes()));
+    assert!(matches!(
+        ShardedKVDB::new_file("sharded_db", path, 0, 4096, 8 * 4096),
+        Err(flashdb_rs::Error::InvalidArgument)
+    ));
+    // 分片数量与创建时不同会被拒绝
+    drop(db);
+    assert!(matches!(
+        ShardedKVDB::new_file("sharded_db", path, 3, 4096, 8 * 4096),
+        Err(flashdb_rs::Error::InvalidArgument)
+    ));
+    Ok(())
+}
+
+#[cfg(feature = "stats")]
+#[test]
+fn test_kvdb_stats() -> anyhow::Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut db = KVDB::new_file("stats_db", path, 4096, 8 * 4096, None)?;
+    db.reset_stats();
+
+    for i in 0..20u32 {
+        db.set(&format!("key{}", i), &[i as u8; 100])?;
+    }
+    for i in 0..10u32 {
+        assert_eq!(db.get(&format!("key{}", i))?.unwrap(), vec![i as u8; 100]);
+    }
+    db.delete("key0")?;
+
+    let stats = db.stats();
+    assert_eq!(stats.set_calls, 20);
+    assert_eq!(stats.set_bytes, (0..20u32).map(|i| format!("key{}", i).len() as u64 + 100).sum());
+    assert_eq!(stats.get_calls, 10);
+    assert_eq!(stats.del_calls, 1);
+    assert!(stats.flash.write_bytes > stats.set_bytes, "{}", stats);
+    assert_eq!(stats.gc_sectors, 0);
+
+    // 反复覆盖写入一半的键，触发 GC，没有覆盖的键会被搬移
+    for round in 0..40u32 {
+        for i in 1..10u32 {
+            db.set(&format!("key{}", i), &[round as u8; 100])?;
+        }
+    }
+    let stats = db.stats();
+    assert_eq!(stats.set_calls, 20 + 40 * 9);
+    assert!(stats.gc_sectors > 0, "{}", stats);
+    assert!(stats.moved_kvs > 0 && stats.moved_bytes > 0, "{}", stats);
+    assert_eq!(stats.flash.erase_calls as u32, stats.gc_sectors, "{}", stats);
+    assert_eq!(stats.flash.sector_erases.iter().sum::<u32>(), stats.gc_sectors);
+    assert!(stats.flash.max_sector_erases() >= 1);
+    assert!(stats.write_amplification().unwrap() > 1.0);
+
+    db.reset_stats();
+    assert_eq!(db.stats(), Default::default());
+
+    // 只回收一个扇区后，其余从未擦除的扇区也要计入
+    while db.stats().flash.erase_calls == 0 {
+        db.set("key1", &[0u8; 100])?;
+    }
+    let stats = db.stats();
+    assert_eq!(stats.flash.sector_erases.len(), 8);
+    assert_eq!(stats.flash.min_sector_erases(), 0);
+    assert_eq!(stats.flash.max_sector_erases(), 1);
+    Ok(())
+}
@@ -1,2 +1,4 @@
 mod kvdb;
-mod tsdb;
\ No newline at end of file
+mod storage;
+mod tsdb;
+mod utils;
\ No newline at end of file
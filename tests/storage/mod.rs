@@ -0,0 +1,445 @@
+#![cfg(feature = "std")]
+#![cfg(test)]
+
+use anyhow::Result;
+use embedded_storage::nor_flash::{ErrorType, NorFlash, ReadNorFlash};
+#[cfg(feature = "mmap")]
+use flashdb_rs::storage::MmapStorage;
+use flashdb_rs::storage::{Durability, FileStrategy, StdStorage};
+use flashdb_rs::{CachedFlash, SimFlash, SimTiming, SyncNorFlash, KVDB};
+use std::cell::Cell;
+use std::rc::Rc;
+use std::time::Duration;
+use tempfile::TempDir;
+
+#[test]
+fn test_std_storage_positional_io() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+    let mut storage = StdStorage::new(
+        temp_dir.path(),
+        "pos_db",
+        4096,
+        4 * 4096,
+        FileStrategy::Multi,
+    )?;
+
+    // 读取跨越文件末尾时，已写入的部分原样返回，其余部分视为已擦除
+    storage.write(4096 + 10, b"abcd")?;
+    let mut buf = [0u8; 8];
+    storage.read(4096 + 12, &mut buf)?;
+    assert_eq!(&buf, b"cd\xFF\xFF\xFF\xFF\xFF\xFF");
+
+    storage.read(3 * 4096, &mut buf)?;
+    assert_eq!(buf, [0xFF; 8]);
+
+    Ok(())
+}
+
+#[test]
+fn test_std_storage_virtual_erase() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+
+    // 多文件模式：擦除即截断，写入位置之前的空洞读取为 0xFF
+    let mut storage = StdStorage::new(
+        temp_dir.path().join("multi"),
+        "erase_db",
+        4096,
+        4 * 4096,
+        FileStrategy::Multi,
+    )?;
+    storage.write(4096, &[0u8; 64])?;
+    storage.erase(4096, 2 * 4096)?;
+    let sector_file = temp_dir.path().join("multi").join("erase_db.fdb.1");
+    assert_eq!(std::fs::metadata(&sector_file)?.len(), 0);
+
+    storage.write(4096 + 100, b"tail")?;
+    let mut buf = [0u8; 104];
+    storage.read(4096, &mut buf)?;
+    assert!(buf[..100].iter().all(|&b| b == 0xFF));
+    assert_eq!(&buf[100..], b"tail");
+
+    // 单文件模式：中间的扇区写入 0xFF，覆盖到文件末尾的擦除直接截断
+    let single = temp_dir.path().join("single.fdb");
+    let mut storage = StdStorage::new(&single, "erase_db", 4096, 4 * 4096, FileStrategy::Single)?;
+    storage.write(0, &[0u8; 3 * 4096])?;
+    storage.erase(4096, 2 * 4096)?;
+    storage.erase(2 * 4096, 4 * 4096)?;
+    assert_eq!(std::fs::metadata(&single)?.len(), 2 * 4096);
+
+    let mut buf = vec![0u8; 4 * 4096];
+    storage.read(0, &mut buf)?;
+    assert!(buf[..4096].iter().all(|&b| b == 0));
+    assert!(buf[4096..].iter().all(|&b| b == 0xFF));
+
+    Ok(())
+}
+
+#[test]
+fn test_std_storage_cache_capacity() -> Result<()> {
+    // 容量为 1 时每次跨扇区都会换出句柄；容量为 0 时所有扇区文件保持打开
+    for capacity in [1, 0] {
+        let temp_dir = TempDir::new()?;
+        let storage = StdStorage::new(
+            temp_dir.path(),
+            "cache_db",
+            4096,
+            32 * 4096,
+            FileStrategy::Multi,
+        )?
+        .with_cache_capacity(capacity);
+        let mut db = Box::new(KVDB::new(storage));
+        db.init(None)?;
+
+        let value = vec![0xA5u8; 900];
+        for i in 0..40 {
+            db.set(&format!("key{}", i), &value)?;
+        }
+        for i in 0..40 {
+            assert_eq!(db.get(&format!("key{}", i))?.unwrap(), value);
+        }
+    }
+
+    Ok(())
+}
+
+/// 统计收到的同步提示的存储包装，计数为 (普通写入, 同步写入)
+struct SyncCounter {
+    inner: StdStorage,
+    counts: Rc<Cell<(usize, usize)>>,
+}
+
+impl ErrorType for SyncCounter {
+    type Error = flashdb_rs::Error;
+}
+
+impl ReadNorFlash for SyncCounter {
+    const READ_SIZE: usize = 1;
+
+    fn read(&mut self, offset: u32, bytes: &mut [u8]) -> Result<(), Self::Error> {
+        self.inner.read(offset, bytes)
+    }
+
+    fn capacity(&self) -> usize {
+        self.inner.capacity()
+    }
+}
+
+impl NorFlash for SyncCounter {
+    const WRITE_SIZE: usize = 1;
+    const ERASE_SIZE: usize = 4096;
+
+    fn erase(&mut self, from: u32, to: u32) -> Result<(), Self::Error> {
+        self.inner.erase(from, to)
+    }
+
+    fn write(&mut self, offset: u32, bytes: &[u8]) -> Result<(), Self::Error> {
+        self.write_sync(offset, bytes, false)
+    }
+}
+
+impl SyncNorFlash for SyncCounter {
+    fn write_sync(&mut self, offset: u32, bytes: &[u8], sync: bool) -> Result<(), Self::Error> {
+        let (plain, synced) = self.counts.get();
+        if sync {
+            self.counts.set((plain, synced + 1));
+        } else {
+            self.counts.set((plain + 1, synced));
+        }
+        self.inner.write_sync(offset, bytes, sync)
+    }
+
+    fn sync(&mut self) -> Result<(), Self::Error> {
+        self.inner.sync()
+    }
+}
+
+#[test]
+fn test_sync_hint_forwarded() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+    let inner = StdStorage::new(
+        temp_dir.path(),
+        "hint_db",
+        4096,
+        8 * 4096,
+        FileStrategy::Multi,
+    )?;
+    let counts = Rc::new(Cell::new((0, 0)));
+    let storage = SyncCounter {
+        inner,
+        counts: counts.clone(),
+    };
+    let mut db = Box::new(KVDB::new_with_sync(storage));
+    db.init(None)?;
+    counts.set((0, 0));
+
+    db.set("key", b"value")?;
+    db.set("key", b"value2")?;
+    db.sync()?;
+
+    // 状态位写入需要同步，KV 头部写入不需要
+    let (plain, synced) = counts.get();
+    assert!(plain > 0);
+    assert!(synced > 0);
+    Ok(())
+}
+
+#[test]
+fn test_std_storage_durability() -> Result<()> {
+    let modes = [
+        Durability::None,
+        Durability::PerWrite,
+        Durability::StatusChange,
+        Durability::GroupCommit {
+            max_pending: 8,
+            max_delay: Duration::from_millis(5),
+        },
+    ];
+    for durability in modes {
+        let temp_dir = TempDir::new()?;
+        let open = || -> Result<StdStorage> {
+            Ok(StdStorage::new(
+                temp_dir.path(),
+                "durable_db",
+                4096,
+                16 * 4096,
+                FileStrategy::Multi,
+            )?
+            // 容量为 1 时，同步需要重新打开已被换出的文件
+            .with_cache_capacity(1)
+            .with_durability(durability))
+        };
+
+        {
+            let mut db = Box::new(KVDB::new_with_sync(open()?));
+            db.init(None)?;
+            for i in 0..50 {
+                db.set(&format!("key{}", i), &[i as u8; 200])?;
+            }
+            db.sync()?;
+        }
+
+        let mut db = Box::new(KVDB::new_with_sync(open()?));
+        db.init(None)?;
+        for i in 0..50 {
+            assert_eq!(db.get(&format!("key{}", i))?.unwrap(), vec![i as u8; 200]);
+        }
+    }
+
+    Ok(())
+}
+
+#[test]
+#[cfg(feature = "mmap")]
+fn test_mmap_storage_roundtrip() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+
+    for strategy in [FileStrategy::Single, FileStrategy::Multi] {
+        let path = match strategy {
+            FileStrategy::Single => temp_dir.path().join("mmap_single.fdb"),
+            FileStrategy::Multi => temp_dir.path().join("mmap_multi"),
+        };
+
+        // 1. 通过 mmap 后端写入
+        {
+            let storage = MmapStorage::new(&path, "mmap_db", 4096, 16 * 4096, strategy)?;
+            let mut db = Box::new(KVDB::new(storage));
+            db.init(None)?;
+            db.set("key1", b"hello")?;
+            db.set("key2", &[0x5A; 300])?;
+            db.delete("key1")?;
+            assert!(db.get("key1")?.is_none());
+            assert_eq!(db.get("key2")?.unwrap(), vec![0x5A; 300]);
+        }
+
+        // 2. 文件布局与 StdStorage 一致，换用普通文件后端仍能读出
+        let storage = StdStorage::new(&path, "mmap_db", 4096, 16 * 4096, strategy)?;
+        let mut db = Box::new(KVDB::new(storage));
+        db.init(None)?;
+        assert!(db.get("key1")?.is_none());
+        assert_eq!(db.get("key2")?.unwrap(), vec![0x5A; 300]);
+    }
+
+    Ok(())
+}
+
+#[test]
+#[cfg(feature = "mmap")]
+fn test_mmap_direct_read() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+
+    for strategy in [FileStrategy::Single, FileStrategy::Multi] {
+        let path = match strategy {
+            FileStrategy::Single => temp_dir.path().join("direct_single.fdb"),
+            FileStrategy::Multi => temp_dir.path().join("direct_multi"),
+        };
+        let storage = MmapStorage::new(&path, "direct_db", 4096, 8 * 4096, strategy)?;
+        let mut db = Box::new(KVDB::new(CachedFlash::<_, 256, 4>::new(storage)));
+        db.init(None)?;
+        db.set("key", b"hello")?;
+        db.set("big", &[0x5A; 1000])?;
+
+        // 闭包直接借用映射内存中的值
+        assert_eq!(db.with_value("key", |value| value.to_vec())?, Some(b"hello".to_vec()));
+        assert_eq!(db.with_value("big", |value| value.len())?, Some(1000));
+        assert_eq!(db.with_value("missing", |value| value.len())?, None);
+
+        let entry = db.get_entry("big")?.unwrap();
+        assert_eq!(db.value_slice(&entry), Some(&[0x5A; 1000][..]));
+
+        // 已删除的 KV 不再返回值
+        db.delete("key")?;
+        assert_eq!(db.with_value("key", |value| value.len())?, None);
+    }
+
+    Ok(())
+}
+
+#[test]
+fn test_cached_flash_coherence() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+    let inner = StdStorage::new(temp_dir.path(), "cache_db", 4096, 4 * 4096, FileStrategy::Multi)?;
+    let mut flash = CachedFlash::<_, 64, 2>::new(inner);
+
+    // 跨页读取，第二次读取命中缓存
+    flash.write(60, b"abcdefgh")?;
+    let mut buf = [0u8; 8];
+    flash.read(60, &mut buf)?;
+    assert_eq!(&buf, b"abcdefgh");
+    flash.read(60, &mut buf)?;
+    assert_eq!(&buf, b"abcdefgh");
+    assert_eq!(flash.stats(), (2, 2));
+
+    // 写入和擦除使缓存页失效
+    flash.erase(0, 4096)?;
+    flash.read(60, &mut buf)?;
+    assert_eq!(buf, [0xFF; 8]);
+    flash.write(62, b"XY")?;
+    flash.read(60, &mut buf)?;
+    assert_eq!(&buf, b"\xFF\xFFXY\xFF\xFF\xFF\xFF");
+
+    // 整页读取不占用缓存，超出缓存页数时按 LRU 淘汰
+    let mut page = [0u8; 64];
+    flash.read(1024, &mut page)?;
+    flash.read(60, &mut buf)?;
+    assert_eq!(flash.stats(), (5, 6));
+    // 第 0 页最久未使用，被第 2048 页替换
+    flash.read(2048, &mut buf)?;
+    flash.read(64, &mut buf[..1])?;
+    assert_eq!(flash.stats(), (6, 7));
+    flash.read(0, &mut buf[..1])?;
+    assert_eq!(flash.stats(), (6, 8));
+
+    Ok(())
+}
+
+#[test]
+fn test_cached_flash_kvdb() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+    let inner = StdStorage::new(temp_dir.path(), "cache_kv", 4096, 8 * 4096, FileStrategy::Multi)?;
+    let mut db = Box::new(KVDB::new(CachedFlash::<_, 256, 8>::new(inner)));
+    db.init(None)?;
+
+    for round in 0..20u8 {
+        for i in 0..10 {
+            db.set(&format!("key_{}", i), &[round; 100])?;
+        }
+    }
+    for i in 0..10 {
+        assert_eq!(db.get(&format!("key_{}", i))?.unwrap(), [19u8; 100]);
+    }
+    assert_eq!(db.iter().count(), 10);
+    Ok(())
+}
+
+#[test]
+fn test_sim_flash_nor_semantics() -> Result<()> {
+    let mut flash = SimFlash::<4096, 4>::new(4 * 4096);
+    assert_eq!(flash.capacity(), 4 * 4096);
+
+    flash.write(4096, &[0xF0, 0x0F, 0xAA, 0x55])?;
+    // 只清除位的写入是允许的
+    flash.write(4096, &[0x00, 0x0F, 0x00, 0x55])?;
+    // 把 0 变回 1 需要先擦除
+    assert!(flash.write(4096, &[0xFF; 4]).is_err());
+    let mut buf = [0u8; 4];
+    flash.read(4096, &mut buf)?;
+    assert_eq!(buf, [0x00, 0x0F, 0x00, 0x55]);
+
+    // 未对齐的写入和擦除、越界访问都会失败
+    assert!(flash.write(4097, &[0; 4]).is_err());
+    assert!(flash.write(4096, &[0; 3]).is_err());
+    assert!(flash.erase(0, 100).is_err());
+    assert!(flash.read(4 * 4096 - 2, &mut buf).is_err());
+
+    flash.erase(4096, 3 * 4096)?;
+    flash.read(4096, &mut buf)?;
+    assert_eq!(buf, [0xFF; 4]);
+    assert_eq!(flash.erase_counts(), &[0, 1, 1, 0]);
+
+    let counters = *flash.counters();
+    assert_eq!(counters.programs, 2);
+    assert_eq!(counters.program_bytes, 8);
+    assert_eq!(counters.reads, 2);
+    assert_eq!(counters.erases, 2);
+    assert_eq!(counters.busy_time(), Duration::ZERO);
+    Ok(())
+}
+
+#[test]
+fn test_sim_flash_timing() -> Result<()> {
+    let timing = SimTiming {
+        read_latency: Duration::from_micros(1),
+        read_throughput: 1_000_000,
+        program_latency: Duration::from_micros(500),
+        program_throughput: 0,
+        program_page: 256,
+        erase_latency: Duration::from_millis(40),
+    };
+    let mut flash = SimFlash::<4096>::with_timing(2 * 4096, timing);
+
+    let mut buf = [0u8; 100];
+    flash.read(0, &mut buf)?;
+    assert_eq!(flash.last_op(), Duration::from_micros(101));
+    // 跨越两页的写入按两次页编程计算
+    flash.write(200, &buf)?;
+    assert_eq!(flash.last_op(), Duration::from_micros(1000));
+    flash.erase(0, 2 * 4096)?;
+    assert_eq!(flash.last_op(), Duration::from_millis(80));
+
+    let counters = flash.counters();
+    assert_eq!(counters.read_time, Duration::from_micros(101));
+    assert_eq!(counters.program_time, Duration::from_micros(1000));
+    assert_eq!(counters.erase_time, Duration::from_millis(80));
+    assert_eq!(counters.busy_time(), Duration::from_micros(81_101));
+
+    flash.reset_counters();
+    assert_eq!(flash.counters().busy_time(), Duration::ZERO);
+    assert_eq!(flash.max_erase_count(), 1);
+    Ok(())
+}
+
+#[test]
+fn test_sim_flash_kvdb() -> Result<()> {
+    let flash = SimFlash::<4096>::with_timing(8 * 4096, SimTiming::SPI_NOR);
+    let mut db = Box::new(KVDB::new_with_sync(flash));
+    db.init(None)?;
+    assert!(db.storage().counters().erases > 0, "初始化时应格式化所有扇区");
+
+    // 反复覆盖写入触发 GC，所有写入都必须满足 NOR Flash 的语义
+    for round in 0..30u8 {
+        for i in 0..10 {
+            db.set(&format!("key_{}", i), &[round; 100])?;
+        }
+    }
+    for i in 0..10 {
+        assert_eq!(db.get(&format!("key_{}", i))?.unwrap(), [29u8; 100]);
+    }
+
+    let flash = db.storage();
+    let counters = flash.counters();
+    assert!(counters.sync_programs > 0 && counters.sync_programs < counters.programs);
+    assert!(flash.max_erase_count() > 1, "{:?}", flash.erase_counts());
+    assert_eq!(counters.erases, flash.erase_counts().iter().map(|&n| n as u64).sum::<u64>());
+    assert!(counters.erase_time >= SimTiming::SPI_NOR.erase_latency * counters.erases as u32);
+    Ok(())
+}
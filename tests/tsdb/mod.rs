@@ -245,4 +245,399 @@ fn test_tsdb_reader_operations() -> Result<()> {
     assert_eq!(&buffer[..read_len], &test_data[20..26]);
 
     Ok(())
-}
\ No newline at end of file
+}
+
+#[test]
+fn test_tsdb_get_value_into() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut tsdb = TSDB::new_file("into_test", path, 4096, 16 * 4096, 256)?;
+
+    for i in 0..100u8 {
+        tsdb.append_with_timestamp(1000 + i as i64, &[i; 16])?;
+    }
+
+    // 遍历过程中复用同一个缓冲区
+    let mut buf = [0u8; 16];
+    let mut small = [0u8; 8];
+    let mut count = 0usize;
+    tsdb.tsdb_iter(
+        |db, tsl| {
+            let len = db.get_value_into(tsl, &mut buf).unwrap().unwrap();
+            assert_eq!(&buf[..len], &[count as u8; 16]);
+            assert!(db.get_value_into(tsl, &mut small).is_err());
+            count += 1;
+            true
+        },
+        false,
+    );
+    assert_eq!(count, 100);
+
+    Ok(())
+}
+
+#[test]
+fn test_shared_tsdb() -> Result<()> {
+    use flashdb_rs::SharedTSDB;
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let tsdb = SharedTSDB::new(TSDB::new_file("shared_test", path, 4096, 128 * 1024, 64)?);
+
+    std::thread::scope(|scope| {
+        for thread in 0..4u8 {
+            let tsdb = &tsdb;
+            scope.spawn(move || {
+                for _ in 0..50 {
+                    // 时间戳必须递增，读取与追加需要在同一次加锁内完成
+                    let mut db = tsdb.lock();
+                    let timestamp = db.last_time() + 1;
+                    db.append_with_timestamp(timestamp, &[thread; 16]).unwrap();
+                }
+            });
+        }
+    });
+    assert_eq!(tsdb.count(0, i64::MAX, TSLStatus::Write), 200);
+
+    let mut last = 0;
+    tsdb.tsdb_iter_by_time(0, i64::MAX, |db, tsl| {
+        assert_eq!(tsl.time(), last + 1);
+        last = tsl.time();
+        let data = db.get_value(tsl).unwrap().unwrap();
+        assert!(data.iter().all(|&b| b == data[0]));
+        true
+    });
+    assert_eq!(last, 200);
+
+    let mut tsdb = tsdb.into_inner();
+    assert_eq!(tsdb.count(0, i64::MAX, TSLStatus::Write), 200);
+    Ok(())
+}
+
+#[test]
+fn test_tsdb_append_batch() -> Result<()> {
+    let single_dir = TempDir::new()?;
+    let batch_dir = TempDir::new()?;
+    let records: Vec<(i64, Vec<u8>)> = (1..=500)
+        .map(|i| (i * 10, vec![i as u8; (i as usize * 7) % 120]))
+        .collect();
+
+    {
+        let mut single = TSDB::new_file("batch_test", single_dir.path().to_str().unwrap(), 4096, 32 * 1024, 128)?;
+        for (timestamp, data) in &records {
+            single.append_with_timestamp(*timestamp, data)?;
+        }
+        let mut batch = TSDB::new_file("batch_test", batch_dir.path().to_str().unwrap(), 4096, 32 * 1024, 128)?;
+        for chunk in records.chunks(45) {
+            let items: Vec<(i64, &[u8])> = chunk.iter().map(|(t, d)| (*t, d.as_slice())).collect();
+            batch.append_batch(&items)?;
+        }
+        assert_eq!(batch.last_time(), 5000);
+
+        // 时间戳不递增或数据过长时整批都不会写入
+        assert!(batch.append_batch(&[(5010, b"a"), (5005, b"b")]).is_err());
+        assert!(batch.append_batch(&[(5010, b"a"), (5020, &[0u8; 129])]).is_err());
+        assert_eq!(batch.last_time(), 5000);
+        assert_eq!(batch.count(5001, i64::MAX, TSLStatus::Write), 0);
+        batch.append_batch(&[])?;
+    }
+
+    // 批量写入与逐条写入的 Flash 布局完全一致
+    for i in 0..8 {
+        let name = format!("batch_test.fdb.{}", i);
+        assert_eq!(
+            std::fs::read(single_dir.path().join(&name))?,
+            std::fs::read(batch_dir.path().join(&name))?,
+            "sector {} differs",
+            i
+        );
+    }
+
+    let mut tsdb = TSDB::new_file("batch_test", batch_dir.path().to_str().unwrap(), 4096, 32 * 1024, 128)?;
+    tsdb.append_batch(&[(5010, b"next")])?;
+    let mut last = None;
+    tsdb.tsdb_iter(
+        |db, tsl| {
+            last = Some((tsl.time(), db.get_value(tsl).unwrap().unwrap()));
+            false
+        },
+        true,
+    );
+    assert_eq!(last, Some((5010, b"next".to_vec())));
+    Ok(())
+}
+
+#[test]
+fn test_tsdb_iter_by_time_after_rollover() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+
+    fn collect(tsdb: &mut TSDB<flashdb_rs::storage::StdStorage>, from: i64, to: i64) -> Vec<i64> {
+        let mut times = Vec::new();
+        tsdb.tsdb_iter_by_time(from, to, |_, tsl| {
+            times.push(tsl.time());
+            true
+        });
+        times
+    }
+
+    let mut tsdb = TSDB::new_file("range_test", path, 4096, 64 * 1024, 128)?;
+    for i in 1..=3000 {
+        tsdb.append_with_timestamp(i * 10, &[i as u8; 100])?;
+    }
+
+    for round in 0..2 {
+        // 多次翻转写入后最旧的扇区不在地址 0 处
+        let mut all = Vec::new();
+        tsdb.tsdb_iter(
+            |_, tsl| {
+                all.push(tsl.time());
+                true
+            },
+            false,
+        );
+        let oldest = all[0];
+        assert!(oldest > 10 && all.len() > 400, "round {}", round);
+
+        let ranges = [
+            (0, i64::MAX),
+            (0, oldest),
+            (oldest + 5, oldest + 205),
+            (25000, 25500),
+            (29955, 30000),
+            (30001, i64::MAX),
+            (0, oldest - 10),
+            (i64::MAX, 0),
+            (25505, 25000),
+            (30000, 29950),
+            (oldest + 95, oldest - 100),
+            (oldest - 10, 0),
+        ];
+        for (from, to) in ranges {
+            let mut expected: Vec<i64> = all
+                .iter()
+                .copied()
+                .filter(|t| *t >= from.min(to) && *t <= from.max(to))
+                .collect();
+            if from > to {
+                expected.reverse();
+            }
+            assert_eq!(collect(&mut tsdb, from, to), expected, "round {} range {}..{}", round, from, to);
+            assert_eq!(tsdb.count(from, to, TSLStatus::Write), expected.len());
+        }
+
+        // 重新打开后扇区目录从 Flash 重建
+        drop(tsdb);
+        tsdb = TSDB::new_file("range_test", path, 4096, 64 * 1024, 128)?;
+    }
+    Ok(())
+}
+
+#[test]
+fn test_tsdb_summary() -> Result<()> {
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut tsdb = TSDB::new_file("summary_test", path, 4096, 64 * 1024, 128)?;
+    for i in 1..=3000 {
+        tsdb.append_with_timestamp(i * 10, &[i as u8; 100])?;
+    }
+
+    let set_every = |tsdb: &mut TSDB<flashdb_rs::storage::StdStorage>, step: i64, status: TSLStatus| {
+        tsdb.tsdb_iter(
+            |db, tsl| {
+                if tsl.time() % (step * 10) == 0 {
+                    db.set_status(tsl, status).unwrap();
+                }
+                true
+            },
+            false,
+        );
+    };
+    let check = |tsdb: &mut TSDB<flashdb_rs::storage::StdStorage>| {
+        let mut all = Vec::new();
+        tsdb.tsdb_iter(
+            |_, tsl| {
+                all.push((tsl.time(), tsl.status()));
+                true
+            },
+            false,
+        );
+        let oldest = all[0].0;
+        let ranges = [
+            (0, i64::MAX),
+            (oldest + 5, 29995),
+            (25000, 28000),
+            (28000, 25000),
+            (29955, 30000),
+            (30001, i64::MAX),
+            (0, oldest - 10),
+        ];
+        for (from, to) in ranges {
+            for status in [TSLStatus::Write, TSLStatus::UserStatus1, TSLStatus::Deleted] {
+                let matched: Vec<i64> = all
+                    .iter()
+                    .filter(|(t, s)| *s == status && *t >= from.min(to) && *t <= from.max(to))
+                    .map(|(t, _)| *t)
+                    .collect();
+                let summary = tsdb.summary(from, to, status);
+                assert_eq!(summary.count, matched.len(), "range {}..{} {:?}", from, to, status);
+                assert_eq!(summary.first.map(|tsl| tsl.time()), matched.first().copied());
+                assert_eq!(summary.last.as_ref().map(|tsl| tsl.time()), matched.last().copied());
+                assert_eq!(tsdb.count(from, to, status), matched.len());
+            }
+        }
+        // 汇总得到的条目可以直接读取
+        let last = tsdb.summary(0, i64::MAX, TSLStatus::Write).last.unwrap();
+        assert_eq!(tsdb.get_value(&last).unwrap().unwrap(), vec![(last.time() / 10) as u8; 100]);
+    };
+
+    check(&mut tsdb);
+    // 每次汇总后修改状态，已统计的扇区需要同步更新
+    set_every(&mut tsdb, 7, TSLStatus::UserStatus1);
+    check(&mut tsdb);
+    set_every(&mut tsdb, 3, TSLStatus::Deleted);
+    check(&mut tsdb);
+
+    drop(tsdb);
+    let mut tsdb = TSDB::new_file("summary_test", path, 4096, 64 * 1024, 128)?;
+    check(&mut tsdb);
+    Ok(())
+}
+
+#[test]
+fn test_tsdb_sample_blocks() -> Result<()> {
+    use flashdb_rs::tsdb::{SampleBlock, SampleDecoder};
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut tsdb = TSDB::new_file("sample_test", path, 4096, 128 * 1024, 512)?;
+
+    // 固定间隔附带少量抖动的温度数据
+    let samples: Vec<(i64, f64)> = (0..5000i64)
+        .map(|i| (1_700_000_000_000 + i * 1000 + (i % 7 == 3) as i64 * 3, 20.0 + ((i / 50) % 40) as f64 * 0.25))
+        .collect();
+    let mut block = SampleBlock::<f64, 512>::new();
+    for (time, value) in &samples {
+        tsdb.append_sample(&mut block, *time, *value)?;
+    }
+    assert!(tsdb.append_sample(&mut block, samples[10].0, 1.0).is_err());
+    tsdb.flush_samples(&mut block)?;
+    assert!(block.is_empty());
+
+    // 每个样本平均不到 2 字节（原始格式每条 TSL 的索引就占 24 字节）
+    let blocks = tsdb.count(0, i64::MAX, TSLStatus::Write);
+    assert!(blocks * 512 < samples.len() * 2, "{} blocks", blocks);
+
+    let mut decoded = Vec::new();
+    tsdb.samples_by_time(0, i64::MAX, |time, value: f64| {
+        decoded.push((time, value));
+        true
+    })?;
+    assert_eq!(decoded, samples);
+
+    let (from, to) = (samples[1234].0 - 1, samples[3210].0);
+    let mut ranged = Vec::new();
+    tsdb.samples_by_time(from, to, |time, value: f64| {
+        ranged.push((time, value));
+        true
+    })?;
+    assert_eq!(ranged, samples[1234..=3210]);
+
+    // 整数使用 varint 编码，首个块之后的样本时间戳必须大于数据库中的最后时间
+    let mut counter = SampleBlock::<i64, 64>::new();
+    assert!(tsdb.append_sample(&mut counter, samples[0].0, 1).is_err());
+    let base = samples.last().unwrap().0;
+    let values: Vec<(i64, i64)> = (1..=200).map(|i| (base + i * 60_000, i * i - 5000)).collect();
+    for (time, value) in &values {
+        tsdb.append_sample(&mut counter, *time, *value)?;
+    }
+    tsdb.flush_samples(&mut counter)?;
+    let mut decoded = Vec::new();
+    tsdb.samples_by_time(base + 1, i64::MAX, |time, value: i64| {
+        decoded.push((time, value));
+        true
+    })?;
+    assert_eq!(decoded, values);
+
+    // 数据不完整或类型不符时解码提前结束
+    let mut block = SampleBlock::<f64, 128>::new();
+    for i in 0..20 {
+        block.push(i * 10, i as f64 * 1.5)?;
+    }
+    let bytes = block.as_bytes();
+    assert_eq!(SampleDecoder::<f64>::new(bytes).count(), 20);
+    assert!(SampleDecoder::<f64>::new(&bytes[..bytes.len() / 2]).count() < 20);
+    assert_eq!(SampleDecoder::<i64>::new(bytes).count(), 0);
+    Ok(())
+}
+
+#[test]
+fn test_tsdb_ingest_buffer() -> Result<()> {
+    use flashdb_rs::{IngestBuffer, IngestConfig, PushError};
+    use std::sync::atomic::{AtomicI64, Ordering};
+    use std::time::Duration;
+
+    let temp_dir = TempDir::new()?;
+    let path = temp_dir.path().to_str().unwrap();
+    let mut tsdb = TSDB::new_file("ingest_test", path, 4096, 256 * 1024, 64)?;
+
+    // 没有写入线程时缓冲区写满后立即返回背压
+    let buffer = IngestBuffer::new(IngestConfig {
+        capacity: 8,
+        batch_size: 4,
+        flush_interval: Duration::from_millis(10),
+    });
+    for i in 1..=8 {
+        buffer.push(i, b"x").unwrap();
+    }
+    assert_eq!(buffer.push(9, b"x"), Err(PushError::Full));
+    assert_eq!(buffer.pending(), 8);
+    assert_eq!(buffer.drain_into(&mut tsdb)?, 8);
+    assert_eq!(buffer.stats().rejected, 1);
+
+    let buffer = IngestBuffer::new(IngestConfig {
+        capacity: 256,
+        batch_size: 64,
+        flush_interval: Duration::from_millis(5),
+    });
+    let clock = AtomicI64::new(100);
+    // TSDB 不能跨线程移动，写入循环运行在当前线程，由另一个线程等待生产者结束后关闭缓冲区
+    std::thread::scope(|scope| -> Result<()> {
+        let producers: Vec<_> = (0..4u8)
+            .map(|thread| {
+                let (buffer, clock) = (&buffer, &clock);
+                scope.spawn(move || {
+                    let mut sent = 0;
+                    while sent < 500 {
+                        let timestamp = clock.fetch_add(1, Ordering::Relaxed);
+                        match buffer.push(timestamp, &[thread; 24]) {
+                            Ok(()) => sent += 1,
+                            Err(PushError::Full) => std::thread::yield_now(),
+                            Err(PushError::Closed) => unreachable!(),
+                        }
+                    }
+                })
+            })
+            .collect();
+        let buffer = &buffer;
+        let closer = scope.spawn(move || {
+            for producer in producers {
+                producer.join().unwrap();
+            }
+            // flush 返回时，之前放入的条目都已经处理完毕
+            buffer.flush().unwrap();
+            assert_eq!(buffer.pending(), 0);
+            buffer.close();
+            assert_eq!(buffer.push(0, b"x"), Err(PushError::Closed));
+        });
+        buffer.run(&mut tsdb)?;
+        closer.join().unwrap();
+        Ok(())
+    })?;
+
+    let stats = buffer.stats();
+    assert_eq!(stats.pushed, 2000);
+    assert_eq!(stats.written + stats.dropped, 2000);
+    assert_eq!(tsdb.count(100, i64::MAX, TSLStatus::Write) as u64, stats.written);
+    Ok(())
+}
@@ -0,0 +1,43 @@
+#![cfg(test)]
+
+use flashdb_rs::fdb_calc_crc32;
+
+/// 逐位计算的参考实现
+fn crc32_reference(crc: u32, data: &[u8]) -> u32 {
+    let mut crc = !crc;
+    for &byte in data {
+        crc ^= byte as u32;
+        for _ in 0..8 {
+            crc = (crc >> 1) ^ (0xEDB8_8320 & (crc & 1).wrapping_neg());
+        }
+    }
+    !crc
+}
+
+fn crc32(crc: u32, data: &[u8]) -> u32 {
+    unsafe { fdb_calc_crc32(crc, data.as_ptr() as *const _, data.len()) }
+}
+
+#[test]
+fn test_crc32_matches_reference() {
+    assert_eq!(crc32(0, b"123456789"), 0xCBF4_3926);
+
+    // 覆盖不同的长度、起始对齐以及分段累加，无论启用哪种 CRC 实现结果都必须一致
+    let data: Vec<u8> = (0..4200u32).map(|i| (i.wrapping_mul(2_654_435_761) >> 13) as u8).collect();
+    for offset in 0..8 {
+        for len in (0..300).chain([511, 512, 513, 1024, 4096]) {
+            let buf = &data[offset..offset + len];
+            let split = len / 3;
+            let expected = crc32_reference(0, buf);
+            assert_eq!(crc32(0, buf), expected, "offset {} len {}", offset, len);
+            assert_eq!(
+                crc32(crc32(0, &buf[..split]), &buf[split..]),
+                expected,
+                "offset {} len {} split {}",
+                offset,
+                len,
+                split
+            );
+        }
+    }
+}